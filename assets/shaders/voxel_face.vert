@@ -0,0 +1,81 @@
+#version 450
+#extension GL_KHR_vulkan_glsl : enable
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(binding = 0) uniform modelViewProjection
+    {
+        mat4 model;
+        mat4 view;
+        mat4 projection;
+    } ubo;
+
+// one face per quad. Layout matches packedFace.hpp
+layout(std430, binding = 1) readonly buffer faceBuffer
+    {
+        uvec2 faces[];
+    };
+
+// xyz: world position of the sub-chunk origin, w: voxel size. Indexed by the firstInstance of the draw, which needs the
+// drawIndirectFirstInstance device feature when drawn indirectly
+layout(std430, binding = 2) readonly buffer originBuffer
+    {
+        vec4 origins[];
+    };
+
+layout(location = 0) out vec3 fragColour;
+layout(location = 1) out vec2 fragTexCoord;
+
+const vec3 orientationColours[3] = vec3[](
+    vec3(0.23, 0.48, 0.34),
+    vec3(0.53, 0.81, 0.92),
+    vec3(0.37, 0.50, 0.22)
+);
+
+// indexed by voxelType
+const vec3 materialColours[3] = vec3[](
+    vec3(1.0),
+    vec3(1.0),
+    vec3(0.0)
+);
+
+const vec2 corners[4] = vec2[](
+    vec2(0.0, 0.0),
+    vec2(1.0, 0.0),
+    vec2(1.0, 1.0),
+    vec2(0.0, 1.0)
+);
+
+void main() {
+    // the shared index pattern is 0, 1, 2, 0, 2, 3 repeated every 4 vertices
+    uvec2 face = faces[gl_VertexIndex >> 2];
+    uint corner = uint(gl_VertexIndex) & 3u;
+
+    uvec3 position = uvec3(face.x & 63u, (face.x >> 6) & 63u, (face.x >> 12) & 63u);
+    uint orientation = (face.x >> 18) & 7u;
+    uint axis = orientation >> 1;
+
+    // negative faces walk the corners backwards to flip the winding
+    if ((orientation & 1u) != 0u) {
+        corner = (4u - corner) & 3u;
+    }
+
+    vec2 size = vec2(face.y & 63u, (face.y >> 6) & 63u);
+    uint material = (face.y >> 12) & 255u;
+
+    vec2 span = corners[corner] * size;
+    vec3 offset;
+    if (axis == 0u) {
+        offset = vec3(span.x, span.y, 0.0);
+    } else if (axis == 1u) {
+        offset = vec3(span.x, 0.0, span.y);
+    } else {
+        offset = vec3(0.0, span.x, span.y);
+    }
+
+    vec4 origin = origins[gl_InstanceIndex];
+    vec3 worldPosition = origin.xyz + (vec3(position) + offset) * origin.w;
+
+    gl_Position = ubo.projection * ubo.view * ubo.model * vec4(worldPosition, 1.0);
+    fragColour = materialColours[min(material, 2u)] * orientationColours[axis];
+    fragTexCoord = corners[corner];
+}
@@ -0,0 +1,47 @@
+// buddyAllocator.hpp
+// Hands out power of two sized ranges of a larger range. Only tracks offsets, the memory itself is owned by the user
+#pragma once
+#include <vector>
+#include <unordered_set>
+#include <cstdint>
+
+class buddyAllocator
+    {
+        public:
+            static constexpr uint64_t c_invalidOffset = ~0ull;
+
+            struct allocation
+                {
+                    uint64_t m_offset = c_invalidOffset;
+                    uint64_t m_size = 0;
+
+                    bool valid() const;
+                };
+
+        private:
+            // free block offsets for every order. A block of order n is m_minimumSize << n long
+            std::vector<std::unordered_set<uint64_t>> m_freeBlocks;
+            uint64_t m_minimumSize = 1;
+            uint64_t m_capacity = 0;
+            uint64_t m_used = 0;
+
+            unsigned int getOrder(uint64_t size) const;
+            void insertFreeBlock(uint64_t offset, unsigned int order);
+
+        public:
+            buddyAllocator() = default;
+            // Capacity is rounded up to the minimum size times a power of two
+            buddyAllocator(uint64_t capacity, uint64_t minimumSize);
+            void create(uint64_t capacity, uint64_t minimumSize);
+
+            // Returns an invalid allocation if there is no free block large enough
+            allocation allocate(uint64_t size);
+            void free(const allocation &allocation);
+
+            // Doubles the capacity. Existing allocations keep their offsets
+            void grow();
+
+            uint64_t getCapacity() const;
+            uint64_t getUsed() const;
+
+    };
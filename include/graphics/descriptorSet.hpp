@@ -63,7 +63,7 @@ class descriptorSet
             void bindImages(const vulkanImageView *imageViews, const vulkanSampler *imageSamplers, int count, int binding);
             void bindImage(const vulkanImageView &imageView, int binding);
             void bindUBO(const vulkanBuffer &buffer, VkDeviceSize range, int binding);
-            void bindSBO(const vulkanBuffer &buffer, VkDeviceSize range, int binding);
+            void bindSBO(const vulkanBuffer &buffer, VkDeviceSize range, int binding, VkDeviceSize offset = 0);
             void update();
 
             bool needsUpdate() const;
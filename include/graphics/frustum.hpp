@@ -0,0 +1,40 @@
+// frustum.hpp
+// View frustum planes and culling of axis aligned boxes against them
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <glm/mat4x4.hpp>
+
+// Boxes are stored as one array per component so a plane can be tested against four boxes at once
+struct boundingBoxes
+    {
+        std::vector<float> m_minX;
+        std::vector<float> m_minY;
+        std::vector<float> m_minZ;
+        std::vector<float> m_maxX;
+        std::vector<float> m_maxY;
+        std::vector<float> m_maxZ;
+
+        void clear();
+        void push(const glm::vec3 &min, const glm::vec3 &max);
+        std::size_t size() const;
+    };
+
+class frustum
+    {
+        private:
+            // xyz: normal pointing inwards, w: distance. Ordered left, right, bottom, top, near, far
+            glm::vec4 m_planes[6] = {};
+
+        public:
+            frustum() = default;
+            explicit frustum(const glm::mat4 &viewProjection);
+            void set(const glm::mat4 &viewProjection);
+
+            bool intersects(const glm::vec3 &min, const glm::vec3 &max) const;
+            // Appends the index of every box at least partially inside the frustum
+            void cull(const boundingBoxes &boxes, std::vector<uint32_t> &visible) const;
+
+    };
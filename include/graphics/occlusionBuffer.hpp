@@ -0,0 +1,41 @@
+// occlusionBuffer.hpp
+// A small software depth buffer. Solid boxes are rasterised into it and other boxes are tested against a max depth pyramid
+// built from it, so anything hidden behind the occluders can be skipped before it is drawn
+#pragma once
+#include <vector>
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <glm/mat4x4.hpp>
+
+class occlusionBuffer
+    {
+        private:
+            // clip space w below this is treated as behind the camera
+            static constexpr float c_nearW = 0.01f;
+
+            // level 0 is the full resolution depth, every level after holds the furthest depth of 2x2 texels of the one before.
+            // Depth is z / w after projection, larger is further away
+            std::vector<std::vector<float>> m_levels;
+            std::vector<glm::ivec2> m_levelSizes;
+            glm::mat4 m_viewProjection = glm::mat4(1.f);
+
+            // Projects the corners of the box to pixels. Returns false if any corner is behind the camera
+            bool project(const glm::vec3 &min, const glm::vec3 &max, glm::vec3 corners[8]) const;
+            void rasteriseTriangle(const glm::vec3 &a, const glm::vec3 &b, const glm::vec3 &c);
+
+        public:
+            void create(unsigned int width, unsigned int height);
+            void clear(const glm::mat4 &viewProjection);
+
+            // The box has to be completely solid. Boxes crossing the near plane are skipped
+            void rasteriseOccluder(const glm::vec3 &min, const glm::vec3 &max);
+            // Must be called after the last occluder and before testing
+            void buildPyramid();
+            // False only if the box is certainly hidden
+            bool visible(const glm::vec3 &min, const glm::vec3 &max) const;
+
+            glm::ivec2 getSize() const;
+            const float *getDepth() const;
+
+    };
@@ -0,0 +1,37 @@
+// packedFace.hpp
+// A single voxel face packed into 8 bytes. Expanded into a quad by the vertex shader through vertex pulling
+#pragma once
+#include <cstdint>
+
+struct packedFace
+    {
+        // x: 6 | y: 6 | z: 6 | orientation: 3. Position is relative to the owning sub-chunk, in voxels
+        std::uint32_t m_position = 0;
+        // width: 6 | height: 6 | material: 8
+        std::uint32_t m_data = 0;
+
+        static constexpr unsigned int c_coordinateBits = 6;
+        static constexpr unsigned int c_coordinateMask = (1 << c_coordinateBits) - 1;
+        static constexpr unsigned int c_orientationShift = c_coordinateBits * 3;
+        static constexpr unsigned int c_materialShift = c_coordinateBits * 2;
+
+        // Orientation is an index into +1, -1, +2, -2, +3, -3 of quad::m_orientation
+        static constexpr packedFace create(unsigned int x, unsigned int y, unsigned int z, unsigned int orientation, unsigned int width, unsigned int height, unsigned int material)
+            {
+                packedFace face;
+                face.m_position =
+                    (x & c_coordinateMask) |
+                    ((y & c_coordinateMask) << c_coordinateBits) |
+                    ((z & c_coordinateMask) << (c_coordinateBits * 2)) |
+                    ((orientation & 0b111) << c_orientationShift);
+
+                face.m_data =
+                    (width & c_coordinateMask) |
+                    ((height & c_coordinateMask) << c_coordinateBits) |
+                    ((material & 0xFF) << c_materialShift);
+
+                return face;
+            }
+    };
+
+static_assert(sizeof(packedFace) == 8, "packedFace must stay 8 bytes to match the vertex shader");
@@ -73,6 +73,8 @@ class renderer
             VkSurfaceKHR m_windowSurface = VK_NULL_HANDLE;
 
             renderSurface m_surface;
+            // rasterises voxelSpace faces with voxel_face.vert over the raytraced image
+            renderSurface m_voxelSurface;
             vulkanSwapChain m_swapChain;
             renderPass m_renderPass;
 
@@ -106,6 +108,10 @@ class renderer
                 };
             std::vector<renderable> m_renderables;
 
+            // set by drawVoxels for the frame being recorded
+            voxelSpace *m_voxelSpace = nullptr;
+            descriptorSet *m_voxelDescriptorSet = nullptr;
+
             void recordSubmissionCommandBuffer(VkCommandBuffer submissionBuffer);
 
             oneTimeCommandBuffer &createOneTimeBuffer();
@@ -127,6 +133,9 @@ class renderer
             void dispatchCompute(unsigned int pipeline, descriptorSet *descriptorSet, unsigned int x, unsigned int y, unsigned int z);
 
             void draw(descriptorSet &descriptorSet);
+            // Draws the sub-chunks chosen by the space's last cull with one indirect draw and uploads its dirty memory ahead of the render pass.
+            // The descriptor set comes from createVoxelDescriptorSet and must have been passed through voxelSpace::bindDescriptors
+            void drawVoxels(voxelSpace &space, descriptorSet &descriptorSet);
 
             void preRecording();
             void recordCommandBuffer();
@@ -139,6 +148,7 @@ class renderer
             const vulkanDevice &getDevice() const;
 
             descriptorSet *createDescriptorSet();
+            descriptorSet *createVoxelDescriptorSet();
             descriptorSet *createComputeDescriptorSet(unsigned int pipeline);
             glm::vec2 getSize() const;
 
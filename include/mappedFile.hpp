@@ -0,0 +1,46 @@
+// mappedFile.hpp
+// A file opened for reading and writing with a read only memory mapping of its contents. Writes go through the file and are only
+// guaranteed to be visible through the mapping once it has been rebuilt
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+class mappedFile
+    {
+        private:
+            const uint8_t *m_data = nullptr;
+            std::size_t m_size = 0;
+            #if defined(_WIN32)
+                void *m_file = nullptr;
+                void *m_mapping = nullptr;
+            #else
+                int m_file = -1;
+            #endif
+
+        public:
+            mappedFile() = default;
+            mappedFile(const mappedFile &rhs) = delete;
+            mappedFile &operator=(const mappedFile &rhs) = delete;
+            ~mappedFile();
+
+            // Opens the file, creating an empty one if it does not exist. Does not map it
+            bool open(const char *file);
+            void close();
+            bool isOpen() const;
+
+            // Maps the whole file. Fails for empty files
+            bool map();
+            void unmap();
+            bool isMapped() const;
+
+            // Reads through the file, so it sees every write even if the mapping has not been rebuilt
+            bool readAt(uint64_t offset, void *data, std::size_t size) const;
+            bool writeAt(uint64_t offset, const void *data, std::size_t size);
+            // Truncates or extends the file. The mapping is released first
+            bool resize(uint64_t size);
+            uint64_t getFileSize() const;
+
+            const uint8_t *getData() const;
+            std::size_t getMappedSize() const;
+
+    };
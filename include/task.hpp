@@ -1,128 +1,171 @@
 // task.hpp
-// Represents a single task within the graph. Binds either a method with an object or a function and allows the user to execute it without needing to specify the template type beforehand
+// Represents a single task within the graph. Binds either a method with an object or any other callable, together with the arguments
+// it is run with. Callables that fit in c_inlineSize bytes are stored inside the task itself so creating one does not allocate
 #pragma once
-#include <memory>
 #include <cstddef>
+#include <new>
+#include <utility>
 #include <functional>
+#include <type_traits>
+#include <assert.h>
 
 class task
     {
         private:
-            template<typename TFunc>
-            struct taskFunc;
+            static constexpr std::size_t c_inlineSize = 64;
 
-            template<typename TObj, typename TFunc>
-            struct taskFuncMethod;
-
-            struct taskFuncBase
+            // Moving and destroying the stored callable. Running it goes through m_invoke directly
+            struct operations
                 {
-                    std::size_t m_functionOffset = 0;
-                    template<typename TRet, typename ...TArgs>
-                    auto execute(TArgs ...args)
-                        {
-                            std::uint8_t *functionOffset = reinterpret_cast<std::uint8_t*>(this) + m_functionOffset;
-                            return (*reinterpret_cast<std::function<TRet(TArgs...)>*>(functionOffset))(args...);
-                        }
+                    void (*m_move)(void *destination, void *source);
+                    void (*m_destroy)(void *storage);
                 };
-            
-            template<typename TFuncResult, typename ...TFuncArgs>
-            struct taskFunc<TFuncResult(TFuncArgs...)> : taskFuncBase
-                {
-                    TFuncResult(*m_functionPtr)(TFuncArgs...);
-                    std::function<TFuncResult(TFuncArgs...)> m_execute;
 
-                    taskFunc(TFuncResult(*func)(TFuncArgs...))
-                        {
-                            m_execute = [this] (TFuncArgs ...args) {
-                                return m_functionPtr(args...);
-                            };
+            template<typename TCallable>
+            static constexpr bool c_storedInline = sizeof(TCallable) <= c_inlineSize && alignof(TCallable) <= alignof(std::max_align_t) && std::is_nothrow_move_constructible_v<TCallable>;
 
-                            m_functionPtr = func;
-                            m_functionOffset = offsetof(taskFunc, m_execute);
+            template<typename TCallable>
+            struct inlineStorage
+                {
+                    static TCallable &get(void *storage) { return *std::launder(reinterpret_cast<TCallable*>(storage)); }
+                    static void invoke(void *storage) { get(storage)(); }
+                    static void move(void *destination, void *source)
+                        {
+                            new (destination) TCallable(std::move(get(source)));
+                            get(source).~TCallable();
                         }
+                    static void destroy(void *storage) { get(storage).~TCallable(); }
+
+                    static constexpr operations c_operations = { &move, &destroy };
                 };
 
-            template<typename TObj, typename TFuncResult, typename TBaseObj, typename ...TFuncArgs>
-            struct taskFuncMethod<TObj, TFuncResult(TBaseObj::*)(TFuncArgs...)> : taskFuncBase
+            // Larger callables live on the heap and the task only holds the pointer
+            template<typename TCallable>
+            struct heapStorage
                 {
-                    TFuncResult(TBaseObj::*m_functionPtr)(TFuncArgs...);
-                    TObj *m_attachedObject;
-                    std::function<TFuncResult(TFuncArgs...)> m_execute;
-
-                    taskFuncMethod(TObj *attached, TFuncResult(TBaseObj::*func)(TFuncArgs...))
-                        {
-                            m_execute = [this] (TFuncArgs ...args) {
-                                return (m_attachedObject->*m_functionPtr)(args...);
-                            };
+                    static TCallable *&get(void *storage) { return *std::launder(reinterpret_cast<TCallable**>(storage)); }
+                    static void invoke(void *storage) { (*get(storage))(); }
+                    static void move(void *destination, void *source) { new (destination) TCallable*(get(source)); }
+                    static void destroy(void *storage) { delete get(storage); }
 
-                            m_attachedObject = attached;
-                            m_functionPtr = func;
-                            m_functionOffset = offsetof(taskFuncMethod, m_execute);
-                        }
+                    static constexpr operations c_operations = { &move, &destroy };
                 };
 
-            std::unique_ptr<taskFuncBase> m_taskFunc;
+            alignas(std::max_align_t) std::byte m_storage[c_inlineSize];
+            void (*m_invoke)(void *storage) = nullptr;
+            const operations *m_operations = nullptr;
+
+            template<typename TCallable>
+            void store(TCallable &&callable);
+            void reset();
 
         public:
             task() = default;
-            task(task &rhs)
-                {
-                    *this = rhs;
-                }
+            task(const task &rhs) = delete;
+            task(task &&rhs) noexcept;
+            ~task();
 
-            task(task &&rhs) noexcept
-                {
-                    *this = std::move(rhs);
-                }
+            // Binds a free function, lambda or other callable. The arguments are copied into the task and passed on every execute
+            template<typename TFunc, typename ...TArgs>
+                requires (!std::is_same_v<std::decay_t<TFunc>, task> && std::is_invocable_v<std::decay_t<TFunc>&, std::decay_t<TArgs>&...>)
+            task(TFunc &&func, TArgs &&...args);
 
-            template<typename TFunc>
-            task(TFunc &func)
-                {
-                    assign(func);
-                }
+            // Binds a method to the object it is called on
+            template<typename TObj, typename TFunc, typename ...TArgs>
+                requires std::is_member_function_pointer_v<TFunc>
+            task(TObj *attached, TFunc func, TArgs &&...args);
 
-            template<typename TObj, typename TFunc>
-            task(TObj *attached, TFunc func)
-                {
-                    assign(attached, func);
-                }
+            task &operator=(const task &rhs) = delete;
+            task &operator=(task &&rhs) noexcept;
 
-            template<typename TFunc>
-            void assign(TFunc &func)
-                {
-                    m_taskFunc = std::make_unique<taskFunc<TFunc>>(func);
-                }
+            void execute();
+            bool valid() const;
 
-            template<typename TObj, typename TFunc>
-            void assign(TObj *attached, TFunc func)
-                {
-                    m_taskFunc = std::make_unique<taskFuncMethod<TObj, TFunc>>(attached, func);
-                }
+    };
 
-            template<typename TRet = void, typename ...Args>
-            auto execute(Args ...args)
-                {
-                    return m_taskFunc->execute<TRet>(args...);
-                }
+template<typename TCallable>
+inline void task::store(TCallable &&callable)
+    {
+        using callableType = std::decay_t<TCallable>;
+        if constexpr (c_storedInline<callableType>)
+            {
+                new (m_storage) callableType(std::forward<TCallable>(callable));
+                m_invoke = &inlineStorage<callableType>::invoke;
+                m_operations = &inlineStorage<callableType>::c_operations;
+            }
+        else
+            {
+                new (m_storage) callableType*(new callableType(std::forward<TCallable>(callable)));
+                m_invoke = &heapStorage<callableType>::invoke;
+                m_operations = &heapStorage<callableType>::c_operations;
+            }
+    }
+
+inline void task::reset()
+    {
+        if (m_operations)
+            {
+                m_operations->m_destroy(m_storage);
+            }
+        m_invoke = nullptr;
+        m_operations = nullptr;
+    }
+
+inline task::task(task &&rhs) noexcept
+    {
+        *this = std::move(rhs);
+    }
 
-            task &operator=(task &rhs)
-                {
-                    if (&rhs == this)
-                        {
-                            return *this;
-                        }
-                    m_taskFunc.reset(rhs.m_taskFunc.release());
-                    return *this;
-                }
+inline task::~task()
+    {
+        reset();
+    }
 
-            task &operator=(task &&rhs) noexcept
-                {
-                    if (&rhs == this)
-                        {
-                            return *this;
-                        }
-                    m_taskFunc = std::move(rhs.m_taskFunc);
-                    return *this;
-                }
+template<typename TFunc, typename ...TArgs>
+    requires (!std::is_same_v<std::decay_t<TFunc>, task> && std::is_invocable_v<std::decay_t<TFunc>&, std::decay_t<TArgs>&...>)
+inline task::task(TFunc &&func, TArgs &&...args)
+    {
+        store([func = std::forward<TFunc>(func), ...args = std::forward<TArgs>(args)]() mutable {
+            std::invoke(func, args...);
+        });
+    }
+
+template<typename TObj, typename TFunc, typename ...TArgs>
+    requires std::is_member_function_pointer_v<TFunc>
+inline task::task(TObj *attached, TFunc func, TArgs &&...args)
+    {
+        store([attached, func, ...args = std::forward<TArgs>(args)]() mutable {
+            std::invoke(func, attached, args...);
+        });
+    }
 
-    };
+inline task &task::operator=(task &&rhs) noexcept
+    {
+        if (&rhs == this)
+            {
+                return *this;
+            }
+
+        reset();
+        if (rhs.m_operations)
+            {
+                rhs.m_operations->m_move(m_storage, rhs.m_storage);
+                m_invoke = rhs.m_invoke;
+                m_operations = rhs.m_operations;
+                rhs.m_invoke = nullptr;
+                rhs.m_operations = nullptr;
+            }
+
+        return *this;
+    }
+
+inline void task::execute()
+    {
+        assert(m_invoke);
+        m_invoke(m_storage);
+    }
+
+inline bool task::valid() const
+    {
+        return m_invoke != nullptr;
+    }
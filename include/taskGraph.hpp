@@ -1,45 +1,38 @@
 // taskGraph.hpp
-// Allows for creation of a execution graph. Will be executed when desired and will run through behaviours logically
+// Allows for creation of a execution graph. Will be executed when desired and will run through behaviours logically. Graphs only hold
+// the dependencies, every graph is executed on the workers of the process wide taskScheduler
 #pragma once
 #include <vector>
-#include <queue>
-#include <thread>
 #include <atomic>
 #include <memory>
 #include <initializer_list>
-#include <mutex>
-#include <tuple>
+#include <cstdint>
 #include <assert.h>
 #include "task.hpp"
+#include "taskProfiler.hpp"
 
+// Workers look for frame critical work first and background work last
+enum class taskPriority : std::uint8_t
+    {
+        FRAME_CRITICAL,
+        NORMAL,
+        BACKGROUND
+    };
+
+class taskScheduler;
 class taskGraph
     {
         private:
-            struct nodeArgsBase
+            // One submission of a graph. Nodes point at the state of the graph they belong to so several can be in flight at once
+            struct executionState
                 {
-                    virtual void execute(task &task)
-                        {
-                            task.execute();
-                        }
-                };
-
-            template <typename ...Args>
-            struct nodeArgs : nodeArgsBase
-                {
-                    std::tuple<Args...> m_argsTuple;
-                    template <typename ...Args>
-                    nodeArgs(Args ...args)
-                        {
-                            m_argsTuple = { args... };
-                        }
-
-                    virtual void execute(task &task) override final
-                        {
-                            auto applyFunc = [&task]<typename ...Args>(Args ...args){
-                                task.execute(args...);
-                            };
-                            std::apply(applyFunc, m_argsTuple);
-                        }
+                    // nodes that have not finished yet, plus one while any are left. The worker that finishes the last node lets the
+                    // scheduler stop counting the submission before it takes this to zero and wakes the threads waiting on the scheduler
+                    std::atomic<std::size_t> m_remainingNodes = 0;
+                    taskPriority m_priority = taskPriority::NORMAL;
+                    // where the nodes are recorded and which submission they belong to
+                    taskProfiler *m_profiler = nullptr;
+                    std::uint32_t m_submission = 0;
                 };
 
             struct node
@@ -47,49 +40,37 @@ class taskGraph
                     std::vector<node*> m_parents;
                     std::vector<node*> m_children;
                     task m_task;
-                    std::unique_ptr<nodeArgsBase> m_args;
                     bool m_doneExecution = false;
                     bool m_inUse = false;
-                    bool m_queued = false;
-                    std::atomic<int> m_parentsDone = 0;
+                    // parents that have not finished in the current execution. Counted up as edges are added and back down as
+                    // parents finish. The worker that takes it to zero schedules the node
+                    std::atomic<int> m_pendingParents = 0;
+                    // position in taskGraph::m_roots, or c_notRoot once the node has a parent
+                    std::size_t m_rootIndex = 0;
+                    // what the workers walk. Points at m_children while the graph is built and into the child array of a compiled graph
+                    node **m_childList = nullptr;
+                    std::uint32_t m_childCount = 0;
+                    int m_parentCount = 0;
+                    executionState *m_state = nullptr;
+                    const char *m_label = nullptr;
+                    // only written while profiling. The parent whose completion made the node ready and when that happened
+                    node *m_readyParent = nullptr;
+                    std::int64_t m_queuedTime = 0;
 
                     void execute()
                         {
-                            m_args->execute(m_task);
-                            for (auto &child : m_children)
-                                {
-                                    child->m_parentsDone++;
-                                }
+                            m_task.execute();
                             m_doneExecution = true;
                         }
 
                     node() = default;
-                    node(node &rhs)
-                        {
-                            *this = rhs;
-                        }
-
+                    node(const node &rhs) = delete;
                     node(node &&rhs) noexcept
                         {
                             *this = std::move(rhs);
                         }
 
-                    node &operator=(node &rhs)
-                        {
-                            if (&rhs == this)
-                                {
-                                    return *this;
-                                }
-                            m_parents = rhs.m_parents;
-                            m_children = rhs.m_children;
-                            m_task = rhs.m_task;
-                            m_doneExecution = rhs.m_doneExecution;
-                            m_inUse = rhs.m_inUse;
-                            m_parentsDone.store(rhs.m_parentsDone);
-
-                            return *this;
-                        }
-
+                    node &operator=(const node &rhs) = delete;
                     node &operator=(node &&rhs) noexcept
                         {
                             if (&rhs == this)
@@ -102,36 +83,33 @@ class taskGraph
                             m_task = std::move(rhs.m_task);
                             m_doneExecution = std::move(rhs.m_doneExecution);
                             m_inUse = std::move(rhs.m_inUse);
-                            m_parentsDone.store(rhs.m_parentsDone);
+                            m_pendingParents.store(rhs.m_pendingParents);
+                            m_rootIndex = rhs.m_rootIndex;
+                            m_childList = rhs.m_childList;
+                            m_childCount = rhs.m_childCount;
+                            m_parentCount = rhs.m_parentCount;
+                            m_state = rhs.m_state;
+                            m_label = rhs.m_label;
 
                             return *this;
                         }
                 };
 
-            struct executionHandler
-                {
-                    std::queue<node*> m_enqueuedNodes;
-                    std::mutex m_queueMutex;
-                    std::thread m_thread;
-                    bool m_running = false;
-                    std::atomic<bool> m_isProcessing = false;
-
-                    executionHandler();
-                    executionHandler(const executionHandler &rhs);
-                    void executionLoop();
-
-                    executionHandler &operator=(const executionHandler &rhs);
-                };
+            static constexpr std::size_t c_notRoot = ~std::size_t(0);
 
             std::vector<std::unique_ptr<node>> m_nodePool;
-            std::queue<std::size_t> m_nodePoolFreeIndices;
+            std::vector<std::size_t> m_nodePoolFreeIndices;
+            // nodes without parents, kept up to date as edges are added so execute does not have to look at every node
+            std::vector<node*> m_roots;
+            std::size_t m_nodeCount = 0;
 
-            std::vector<node*> m_enqueuedNodes;
+            // state of the nodes built directly in this graph
+            executionState m_executionState;
 
-            std::vector<executionHandler> m_threadPool;
-            static constexpr unsigned int c_DEFAULT_THREAD_COUNT = 4;
+            taskProfiler m_profiler;
+            std::atomic<std::uint32_t> m_submissionCount = 0;
 
-            bool m_executing = false;
+            friend class taskScheduler;
             friend class taskGraphTests;
             friend class taskGraphTests_add_Test;
             friend class taskGraphTests_clear_Test;
@@ -140,76 +118,85 @@ class taskGraph
             friend class taskGraphTests_executeComplex_Test;
             friend class taskGraphTests_executeComplexNoDelay_Test;
 
-            void initThreadPool(unsigned int threadCount);
             void initNodePool(unsigned int expectedNodeCount);
 
             std::size_t createNode(task task);
-            template<typename ...Args>
-            std::size_t createNode(task task, Args ...args);
+            void addEdge(node *parent, node *child);
+            void inject(node *const *roots, std::size_t rootCount, std::size_t nodeCount, executionState &state, taskPriority priority);
 
         public:
+            // Nodes are owned by the graph. Handles stay valid until the graph is cleared
+            using nodeHandle = taskGraph::node*;
+
+            // A graph frozen by compile. Nodes and their child lists sit in flat arrays and the roots are known, so running it again only
+            // resets each node's counter as it starts. Tasks keep what they captured, so anything that changes between runs goes through a
+            // context object the tasks hold a pointer to and the caller fills in before each execute
+            class compiledGraph
+                {
+                    private:
+                        std::vector<node> m_nodes;
+                        std::vector<node*> m_childList;
+                        std::vector<node*> m_roots;
+                        // kept on the heap so nodes can point at it while the compiled graph is moved around
+                        std::unique_ptr<executionState> m_state;
+
+                        friend class taskGraph;
+
+                    public:
+                        compiledGraph() = default;
+                        compiledGraph(const compiledGraph &rhs) = delete;
+                        compiledGraph(compiledGraph &&rhs) noexcept = default;
+                        compiledGraph &operator=(const compiledGraph &rhs) = delete;
+                        compiledGraph &operator=(compiledGraph &&rhs) noexcept = default;
+
+                        std::size_t size() const { return m_nodes.size(); }
+                        bool empty() const { return m_nodes.empty(); }
+                };
+
+            // Returned by submit. Refers to the latest submission of its graph and is valid while that graph is alive
+            class executionHandle
+                {
+                    private:
+                        executionState *m_state = nullptr;
+
+                        executionHandle(executionState *state);
+
+                        friend class taskGraph;
+
+                    public:
+                        executionHandle() = default;
+
+                        bool done() const;
+                        // Runs tasks from any submitted graph on the calling thread until this one is finished
+                        void wait();
+                };
+
             taskGraph(unsigned int expectedNodeCount = 10);
-            taskGraph(unsigned int threadCount, unsigned int expectedNodeCount = 10);
             ~taskGraph();
 
-            taskGraph::node *addTask(task task, taskGraph::node *required = nullptr);
-            taskGraph::node *addTask(task task, std::initializer_list<taskGraph::node*> parents, std::initializer_list<taskGraph::node*> children);
-
-            template<typename ...Args>
-            taskGraph::node *addTask(task task, taskGraph::node *required = nullptr, Args ...args);
+            // Labels name the node in the profiler and must outlive the graph, string literals are the intended use
+            taskGraph::node *addTask(task task, taskGraph::node *required = nullptr, const char *label = nullptr);
+            taskGraph::node *addTask(task task, std::initializer_list<taskGraph::node*> parents, std::initializer_list<taskGraph::node*> children, const char *label = nullptr);
 
             void addParents(taskGraph::node *base, std::initializer_list<taskGraph::node*> parents);
             void addChildren(taskGraph::node *base, std::initializer_list<taskGraph::node*> children);
 
             void clear();
+            // Moves every node into a compiledGraph and clears this graph. Handles to the old nodes are invalid afterwards
+            compiledGraph compile();
+
+            // Hands the roots to the workers and returns straight away. The graph must not be changed until the handle is done
+            executionHandle submit(taskPriority priority = taskPriority::NORMAL);
+            executionHandle submit(compiledGraph &graph, taskPriority priority = taskPriority::NORMAL);
+            // submit and wait
+            void execute(taskPriority priority = taskPriority::NORMAL);
+            void execute(compiledGraph &graph, taskPriority priority = taskPriority::NORMAL);
 
-            void start(unsigned int threadCount);
-            void execute();
+            // Whether the nodes built directly in this graph have finished
             bool done() const;
-            void stop();
+
+            taskProfiler &getProfiler();
 
             taskGraph &operator=(taskGraph &rhs);
 
     };
-
-template<typename ...Args>
-inline std::size_t taskGraph::createNode(task task, Args ...args)
-    {
-        assert(!m_executing);
-
-        if (m_nodePoolFreeIndices.empty())
-            {
-                std::size_t newSize = m_nodePool.size() * 2;
-                std::size_t oldSize = m_nodePool.size();
-                m_nodePool.resize(newSize);
-                for (std::size_t i = oldSize; i < newSize; i++)
-                    {
-                        m_nodePool[i] = std::make_unique<node>();
-                        m_nodePoolFreeIndices.push(i);
-                    }
-            }
-
-        std::size_t index = m_nodePoolFreeIndices.front();
-        m_nodePoolFreeIndices.pop();
-        m_nodePool[index]->m_task = task;
-        m_nodePool[index]->m_doneExecution = false;
-        m_nodePool[index]->m_inUse = true;
-        m_nodePool[index]->m_parentsDone = 0;
-        m_nodePool[index]->m_queued = false;
-        m_nodePool[index]->m_args = std::make_unique<nodeArgs<Args...>>(args...);
-        return index;
-    }
-
-template<typename ...Args>
-taskGraph::node *taskGraph::addTask(task task, taskGraph::node *required, Args ...args)
-    {
-        std::size_t index = createNode(task, args...);
-
-        if (required)
-            {
-                m_nodePool[index]->m_parents.push_back(required);
-                required->m_children.push_back(m_nodePool[index].get());
-            }
-
-        return m_nodePool[index].get();
-    }
@@ -0,0 +1,113 @@
+// taskProfiler.hpp
+// Records when every taskGraph node was queued, started and finished. Each thread writes into its own ring buffer without locking and
+// the events are collected on the thread that reads them. Events can be summarised, drawn in ImGui or exported as a Chrome trace
+#pragma once
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <array>
+#include <cstdint>
+
+class taskProfiler
+    {
+        public:
+            // Times are in nanoseconds from now()
+            struct event
+                {
+                    const void *m_node = nullptr;
+                    // the parent whose completion made the node ready, null for roots
+                    const void *m_readyParent = nullptr;
+                    const char *m_label = nullptr;
+                    std::uint32_t m_submission = 0;
+                    std::uint32_t m_thread = 0;
+                    std::int64_t m_queuedTime = 0;
+                    std::int64_t m_startTime = 0;
+                    std::int64_t m_endTime = 0;
+                };
+
+            struct stage
+                {
+                    const char *m_label = nullptr;
+                    std::size_t m_count = 0;
+                    double m_totalTime = 0.0;
+                    double m_maxTime = 0.0;
+                };
+
+            // Durations are in milliseconds
+            struct summary
+                {
+                    std::size_t m_taskCount = 0;
+                    unsigned int m_threadCount = 0;
+                    double m_wallTime = 0.0;
+                    double m_busyTime = 0.0;
+                    // busy time over wall time times the threads that ran something
+                    double m_parallelEfficiency = 0.0;
+                    double m_averageQueueWait = 0.0;
+                    double m_maxQueueWait = 0.0;
+                    double m_criticalPathTime = 0.0;
+                    // first to last. Follows the parent that finished last back from the node that finished last
+                    std::vector<const char*> m_criticalPath;
+                    // sorted by total time
+                    std::vector<stage> m_stages;
+                };
+
+        private:
+            // the collecting thread may read a slot while it is being overwritten, so the event is copied in and out as atomic words
+            // and only kept if the sequence did not change around the copy
+            static constexpr std::size_t c_eventWords = (sizeof(event) + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t);
+
+            struct slot
+                {
+                    std::array<std::atomic<std::uint64_t>, c_eventWords> m_event = {};
+                    // index + 1 of the event in the slot once it is fully written
+                    std::atomic<std::uint64_t> m_sequence = 0;
+                };
+
+            struct ringBuffer
+                {
+                    std::unique_ptr<slot[]> m_slots;
+                    std::atomic<std::uint64_t> m_head = 0;
+                    // only touched by the collecting thread
+                    std::uint64_t m_readIndex = 0;
+                };
+
+            static constexpr std::uint64_t c_ringCapacity = 1 << 14;
+            // threads with a higher index share the last ring
+            static constexpr std::size_t c_maxRings = 64;
+            static constexpr std::size_t c_maxCollectedEvents = 1 << 16;
+            static constexpr std::int64_t c_summaryInterval = 500'000'000;
+
+            // one per recording thread, created by the first event it records so the profiler never has to know the worker count
+            std::array<std::atomic<ringBuffer*>, c_maxRings> m_rings = {};
+            std::atomic<bool> m_enabled = false;
+
+            std::vector<event> m_events;
+            summary m_latestSubmission;
+            summary m_window;
+            std::int64_t m_lastSummaryTime = 0;
+
+            ringBuffer &getRing(std::uint32_t thread);
+
+        public:
+            taskProfiler() = default;
+            taskProfiler(const taskProfiler &rhs) = delete;
+            taskProfiler &operator=(const taskProfiler &rhs) = delete;
+            ~taskProfiler();
+
+            void setEnabled(bool enabled);
+            bool isEnabled() const;
+
+            void record(std::uint32_t thread, const event &event);
+            // Moves everything recorded since the last collect into the collected events, dropping the oldest past c_maxCollectedEvents
+            void collect();
+            void reset();
+            const std::vector<event> &getEvents() const;
+
+            static std::int64_t now();
+            static summary summarise(const std::vector<event> &events);
+            static bool writeChromeTrace(const char *file, const std::vector<event> &events);
+
+            // Summary of the latest submission and of everything collected, with a button to export the collected events to traceFile
+            void drawImGui(const char *name, const char *traceFile);
+
+    };
@@ -0,0 +1,137 @@
+// taskScheduler.hpp
+// Process wide pool of workers every taskGraph is executed on. Workers are created once, sized to the machine and optionally pinned to
+// cores, so creating a graph never creates threads and several graphs share the cores instead of oversubscribing them
+#pragma once
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include "taskGraph.hpp"
+#include "workStealingDeque.hpp"
+
+class taskScheduler
+    {
+        public:
+            struct settings
+                {
+                    // 0 picks one per core less one, which is left for the thread that waits on graphs
+                    unsigned int m_workerCount = 0;
+                    // gives every worker a core of its own, skipping the reserved core
+                    bool m_pinWorkers = false;
+                    // core no worker is pinned to, for the main or render thread to claim with pinCurrentThread. -1 for none
+                    int m_reservedCore = -1;
+                };
+
+        private:
+            using node = taskGraph::node;
+            using executionState = taskGraph::executionState;
+
+            static constexpr std::size_t c_priorityCount = 3;
+
+            // One worker thread with a deque per priority. Nodes made ready by its own work go to the bottom of the deque for their
+            // priority, so a chain of nodes stays on one core. For each priority in turn it pops its own deque, takes nodes handed in
+            // by submissions, then steals from the top of a random other worker. A worker that keeps finding nothing parks until more
+            // work is made available
+            struct executionHandler
+                {
+                    std::array<workStealingDeque<node*>, c_priorityCount> m_deques;
+                    taskScheduler *m_scheduler = nullptr;
+                    std::thread m_thread;
+                    std::atomic<bool> m_running = false;
+                    std::uint32_t m_randomState = 1;
+                    std::uint32_t m_index = 0;
+                    // -1 when the worker is not pinned
+                    int m_core = -1;
+
+                    executionHandler(taskScheduler *scheduler, std::size_t index, int core);
+                    void start();
+                    void executionLoop();
+                    node *findWork();
+                    node *takeInjectedWork(std::size_t priority);
+                    node *stealWork(std::size_t priority);
+                    // Sleeps until woken by wakeWorkers. Returns straight away if work turns up while parking
+                    node *park();
+                    // Runs the node and pushes every child it was the last parent of
+                    void execute(node *node);
+                };
+
+            // roots handed in by submissions, by priority. Only the owner may push to a worker's deque so they go through here
+            std::array<std::vector<node*>, c_priorityCount> m_injectedNodes;
+            std::mutex m_injectedMutex;
+            std::array<std::atomic<bool>, c_priorityCount> m_hasInjectedNodes = {};
+            static constexpr std::size_t c_injectedBatchSize = 64;
+            static constexpr std::size_t c_initialInjectedCapacity = 1024;
+            // bumped and notified every time any submission finishes. Waiting threads sleep on it once there is nothing to help with
+            std::atomic<std::uint32_t> m_completionSignal = 0;
+
+            // parked workers wait on this changing. Bumped whenever work is made available while someone is asleep
+            std::atomic<std::uint32_t> m_wakeSignal = 0;
+            std::atomic<unsigned int> m_sleepingWorkers = 0;
+            // failed searches for work before a worker parks or a waiting thread sleeps
+            static constexpr int c_spinCount = 64;
+
+            // nanoseconds of background work allowed between beginFrame calls, 0 for no limit. Background nodes are only started
+            // while the time used so far is under it, so a node that is already running always finishes
+            std::atomic<std::int64_t> m_frameBudget = 0;
+            std::atomic<std::int64_t> m_backgroundTimeUsed = 0;
+
+            // submissions that have not finished plus threads helping in wait. The workers are only replaced while it is zero
+            std::atomic<std::size_t> m_outstandingWork = 0;
+
+            settings m_settings;
+            std::vector<std::unique_ptr<executionHandler>> m_workers;
+            // workers are started by the first submission unless start was called before it
+            std::atomic<bool> m_started = false;
+            std::mutex m_startMutex;
+
+            taskScheduler();
+            ~taskScheduler();
+
+            void ensureStarted();
+            void startWorkers();
+            void wakeWorkers(std::size_t count);
+            bool canStartPriority(std::size_t priority) const;
+            // Looks for work up to and including maxPriority, most urgent first
+            node *findHelpWork(std::size_t maxPriority, std::size_t &victim);
+            // Returns one of the children it made ready so the helping thread can carry on with it
+            node *runHelpWork(node *work);
+            // Runs the task, charging background nodes against the frame budget and recording it while profiling. Returns when it
+            // finished if that was measured, otherwise 0
+            std::int64_t runNode(node *node, std::uint32_t thread);
+            void markReady(node *child, node *parent, std::int64_t time);
+            void finishNode(node *node);
+            void pushInjected(node *const *nodes, std::size_t count, std::size_t priority);
+
+            // Everything past the roots is scheduled by the workers as the last parent of each node finishes
+            void inject(node *const *roots, std::size_t rootCount, taskPriority priority);
+            // Runs nodes on a thread that is not one of the workers until the submission is finished. Only nodes at the priority of the
+            // submission or a more urgent one are picked up
+            void help(executionState &state);
+
+            friend class taskGraph;
+
+        public:
+            taskScheduler(const taskScheduler &rhs) = delete;
+            taskScheduler &operator=(const taskScheduler &rhs) = delete;
+
+            static taskScheduler &get();
+
+            // Replaces the workers. Meant to be called once at startup before anything is submitted. Both refuse and return false while
+            // a submission is in flight or a thread is waiting on one
+            bool start(const settings &settings);
+            bool stop();
+            unsigned int getWorkerCount();
+
+            // Caps how long background nodes may run between two beginFrame calls. Zero removes the cap
+            void setFrameBudget(std::chrono::microseconds budget);
+            void beginFrame();
+
+            static unsigned int getCoreCount();
+            // Returns false where affinity is not supported
+            static bool pinCurrentThread(unsigned int core);
+
+    };
@@ -0,0 +1,35 @@
+// batchNoise.hpp
+// Fractal value noise that is evaluated a whole block at a time. Matches FastNoise's ValueFractal (FBM, quintic) output for the same settings
+#pragma once
+#include <cstdint>
+#include <glm/vec3.hpp>
+
+class batchNoise
+    {
+        private:
+            static constexpr int c_maxOctaves = 16;
+
+            uint8_t m_perm[512] = {};
+            float m_frequency = 0.01f;
+            float m_lacunarity = 2.f;
+            float m_gain = 0.5f;
+            float m_fractalBounding = 1.f;
+            int m_octaves = 3;
+
+            void calculateFractalBounding();
+            float sampleOctave(uint8_t offset, float x, float y, float z) const;
+
+        public:
+            batchNoise();
+
+            void setSeed(int seed);
+            void setFrequency(float frequency);
+            void setFractalOctaves(int octaves);
+            void setFractalLacunarity(float lacunarity);
+            void setFractalGain(float gain);
+
+            float sample(float x, float y, float z) const;
+            // Samples every integer position in [origin, origin + size). Values are laid out x first, then y, then z
+            void fill(float *values, const glm::ivec3 &origin, const glm::ivec3 &size) const;
+
+    };
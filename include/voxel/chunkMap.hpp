@@ -0,0 +1,556 @@
+// chunkMap.hpp
+// Flat open addressing map from chunk coordinates to chunk payloads. Coordinates are Morton encoded into a 64 bit key so neighbouring
+// chunks have neighbouring keys. The index table only holds keys and slot numbers. Payloads live in fixed size pages that never move, so
+// pointers to them stay valid until the entry is erased
+#pragma once
+#include <vector>
+#include <memory>
+#include <array>
+#include <utility>
+#include <iterator>
+#include <new>
+#include <tuple>
+#include <algorithm>
+#include <functional>
+#include <cstdint>
+#include <stdexcept>
+#include <assert.h>
+#include <glm/vec3.hpp>
+
+template<typename T>
+class chunkMap
+    {
+        public:
+            using value_type = std::pair<const glm::ivec3, T>;
+
+            // 21 bits per axis. Coordinates are biased so the range is [-2^20, 2^20)
+            static constexpr int c_axisBits = 21;
+            static constexpr int c_axisBias = 1 << (c_axisBits - 1);
+            static constexpr uint64_t c_axisMasks[3] = { 0x1249249249249249ull, 0x2492492492492492ull, 0x4924924924924924ull };
+            // same order as voxelSpace::c_neighbourDirections and voxelChunk::neighbourList
+            static constexpr glm::ivec3 c_neighbourDirections[6] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+
+        private:
+            static constexpr uint32_t c_emptySlot = ~0u;
+            static constexpr std::size_t c_pageSize = 64;
+            static constexpr std::size_t c_minimumTableSize = 16;
+
+            struct slot
+                {
+                    alignas(value_type) unsigned char m_storage[sizeof(value_type)];
+                    bool m_occupied = false;
+
+                    value_type &get() { return *std::launder(reinterpret_cast<value_type*>(m_storage)); }
+                    const value_type &get() const { return *std::launder(reinterpret_cast<const value_type*>(m_storage)); }
+                };
+
+            struct entry
+                {
+                    uint64_t m_key = 0;
+                    uint32_t m_slot = c_emptySlot;
+                };
+
+            std::vector<entry> m_table;
+            std::vector<std::unique_ptr<slot[]>> m_pages;
+            std::vector<uint32_t> m_freeSlots;
+            // slots below this have been handed out at least once. Iteration stops here
+            uint32_t m_slotCount = 0;
+            std::size_t m_size = 0;
+            unsigned int m_shift = 64;
+
+            static uint64_t spreadBits(int coordinate);
+            static int compactBits(uint64_t value);
+
+            std::size_t getBucket(uint64_t key) const;
+            std::size_t findEntry(uint64_t key) const;
+            void rehash(std::size_t tableSize);
+            slot &getSlot(uint32_t index);
+            const slot &getSlot(uint32_t index) const;
+            uint32_t allocateSlot();
+            void eraseEntry(std::size_t entryIndex);
+
+            template<typename TMap, typename TValue>
+            class iteratorBase
+                {
+                    private:
+                        TMap *m_map = nullptr;
+                        uint32_t m_slot = 0;
+
+                        void skipEmpty()
+                            {
+                                while (m_slot < m_map->m_slotCount && !m_map->getSlot(m_slot).m_occupied)
+                                    {
+                                        m_slot++;
+                                    }
+                            }
+
+                        friend class chunkMap;
+
+                    public:
+                        using iterator_category = std::forward_iterator_tag;
+                        using value_type = TValue;
+                        using difference_type = std::ptrdiff_t;
+                        using pointer = TValue*;
+                        using reference = TValue&;
+
+                        iteratorBase() = default;
+                        iteratorBase(TMap *map, uint32_t slot) : m_map(map), m_slot(slot) { skipEmpty(); }
+                        template<typename TOtherMap, typename TOtherValue>
+                        iteratorBase(const iteratorBase<TOtherMap, TOtherValue> &rhs) : m_map(rhs.m_map), m_slot(rhs.m_slot) {}
+
+                        reference operator*() const { return m_map->getSlot(m_slot).get(); }
+                        pointer operator->() const { return &m_map->getSlot(m_slot).get(); }
+                        iteratorBase &operator++() { m_slot++; skipEmpty(); return *this; }
+                        iteratorBase operator++(int) { iteratorBase previous = *this; ++*this; return previous; }
+                        bool operator==(const iteratorBase &rhs) const { return m_slot == rhs.m_slot; }
+                        bool operator!=(const iteratorBase &rhs) const { return m_slot != rhs.m_slot; }
+
+                        template<typename, typename>
+                        friend class iteratorBase;
+                };
+
+        public:
+            using iterator = iteratorBase<chunkMap, value_type>;
+            using const_iterator = iteratorBase<const chunkMap, const value_type>;
+            using neighbourList = std::array<T*, 6>;
+            using constNeighbourList = std::array<const T*, 6>;
+
+            chunkMap() = default;
+            chunkMap(const chunkMap &rhs) = delete;
+            chunkMap &operator=(const chunkMap &rhs) = delete;
+            ~chunkMap();
+
+            static uint64_t encode(const glm::ivec3 &position);
+            static glm::ivec3 decode(uint64_t key);
+            // Key of the chunk one step along c_neighbourDirections[direction] without decoding
+            static uint64_t getNeighbourKey(uint64_t key, std::size_t direction);
+
+            iterator find(const glm::ivec3 &position);
+            const_iterator find(const glm::ivec3 &position) const;
+            // Null if the position is not in the map
+            T *get(const glm::ivec3 &position);
+            const T *get(const glm::ivec3 &position) const;
+            T *getByKey(uint64_t key);
+            const T *getByKey(uint64_t key) const;
+            bool contains(const glm::ivec3 &position) const;
+            T &at(const glm::ivec3 &position);
+            const T &at(const glm::ivec3 &position) const;
+
+            // Neighbours that are not in the map are null
+            neighbourList getNeighbours(const glm::ivec3 &position);
+            constNeighbourList getNeighbours(const glm::ivec3 &position) const;
+
+            template<typename ...Args>
+            std::pair<iterator, bool> emplace(const glm::ivec3 &position, Args &&...args);
+            T &operator[](const glm::ivec3 &position);
+
+            // Returns the iterator following the erased entry. Other iterators and pointers stay valid
+            iterator erase(const_iterator it);
+            bool erase(const glm::ivec3 &position);
+            void clear();
+            void reserve(std::size_t count);
+
+            std::size_t size() const;
+            bool empty() const;
+
+            iterator begin();
+            iterator end();
+            const_iterator begin() const;
+            const_iterator end() const;
+
+    };
+
+template<typename T>
+chunkMap<T>::~chunkMap()
+    {
+        clear();
+    }
+
+template<typename T>
+inline uint64_t chunkMap<T>::spreadBits(int coordinate)
+    {
+        // the low 21 bits of the biased coordinate end up with two zero bits between each
+        uint64_t value = static_cast<uint32_t>(coordinate + c_axisBias) & ((1u << c_axisBits) - 1);
+        value = (value | (value << 32)) & 0x1f00000000ffffull;
+        value = (value | (value << 16)) & 0x1f0000ff0000ffull;
+        value = (value | (value << 8)) & 0x100f00f00f00f00full;
+        value = (value | (value << 4)) & 0x10c30c30c30c30c3ull;
+        value = (value | (value << 2)) & 0x1249249249249249ull;
+        return value;
+    }
+
+template<typename T>
+inline int chunkMap<T>::compactBits(uint64_t value)
+    {
+        value &= 0x1249249249249249ull;
+        value = (value | (value >> 2)) & 0x10c30c30c30c30c3ull;
+        value = (value | (value >> 4)) & 0x100f00f00f00f00full;
+        value = (value | (value >> 8)) & 0x1f0000ff0000ffull;
+        value = (value | (value >> 16)) & 0x1f00000000ffffull;
+        value = (value | (value >> 32)) & ((1ull << c_axisBits) - 1);
+        return static_cast<int>(value) - c_axisBias;
+    }
+
+template<typename T>
+inline uint64_t chunkMap<T>::encode(const glm::ivec3 &position)
+    {
+        return spreadBits(position.x) | (spreadBits(position.y) << 1) | (spreadBits(position.z) << 2);
+    }
+
+template<typename T>
+inline glm::ivec3 chunkMap<T>::decode(uint64_t key)
+    {
+        return { compactBits(key), compactBits(key >> 1), compactBits(key >> 2) };
+    }
+
+template<typename T>
+inline uint64_t chunkMap<T>::getNeighbourKey(uint64_t key, std::size_t direction)
+    {
+        // filling the other axes' bits with ones carries the add across them. Wraps at the edge of the range
+        const uint64_t mask = c_axisMasks[direction / 2];
+        const uint64_t axis = (direction % 2 == 0) ? ((key | ~mask) + 1) : ((key & mask) - 1);
+        return (axis & mask) | (key & ~mask);
+    }
+
+template<typename T>
+inline std::size_t chunkMap<T>::getBucket(uint64_t key) const
+    {
+        // Morton keys of nearby chunks only differ in their low bits, so they are mixed before taking the top bits
+        return static_cast<std::size_t>((key * 0x9e3779b97f4a7c15ull) >> m_shift);
+    }
+
+template<typename T>
+inline std::size_t chunkMap<T>::findEntry(uint64_t key) const
+    {
+        if (m_table.empty())
+            {
+                return m_table.size();
+            }
+
+        const std::size_t mask = m_table.size() - 1;
+        for (std::size_t i = getBucket(key);; i = (i + 1) & mask)
+            {
+                const entry &current = m_table[i];
+                if (current.m_slot == c_emptySlot)
+                    {
+                        return m_table.size();
+                    }
+                if (current.m_key == key)
+                    {
+                        return i;
+                    }
+            }
+    }
+
+template<typename T>
+void chunkMap<T>::rehash(std::size_t tableSize)
+    {
+        std::vector<entry> previous = std::move(m_table);
+        m_table.assign(tableSize, entry{});
+        m_shift = 64;
+        for (std::size_t size = tableSize; size > 1; size >>= 1)
+            {
+                m_shift--;
+            }
+
+        const std::size_t mask = tableSize - 1;
+        for (const entry &current : previous)
+            {
+                if (current.m_slot == c_emptySlot)
+                    {
+                        continue;
+                    }
+
+                std::size_t i = getBucket(current.m_key);
+                while (m_table[i].m_slot != c_emptySlot)
+                    {
+                        i = (i + 1) & mask;
+                    }
+                m_table[i] = current;
+            }
+    }
+
+template<typename T>
+inline typename chunkMap<T>::slot &chunkMap<T>::getSlot(uint32_t index)
+    {
+        return m_pages[index / c_pageSize][index % c_pageSize];
+    }
+
+template<typename T>
+inline const typename chunkMap<T>::slot &chunkMap<T>::getSlot(uint32_t index) const
+    {
+        return m_pages[index / c_pageSize][index % c_pageSize];
+    }
+
+template<typename T>
+uint32_t chunkMap<T>::allocateSlot()
+    {
+        if (!m_freeSlots.empty())
+            {
+                // lowest free slot first so live payloads stay packed at the front of the pages
+                std::pop_heap(m_freeSlots.begin(), m_freeSlots.end(), std::greater<uint32_t>());
+                uint32_t index = m_freeSlots.back();
+                m_freeSlots.pop_back();
+                return index;
+            }
+
+        if (m_slotCount == m_pages.size() * c_pageSize)
+            {
+                m_pages.push_back(std::make_unique<slot[]>(c_pageSize));
+            }
+        return m_slotCount++;
+    }
+
+template<typename T>
+void chunkMap<T>::eraseEntry(std::size_t entryIndex)
+    {
+        const uint32_t slotIndex = m_table[entryIndex].m_slot;
+        slot &erased = getSlot(slotIndex);
+        erased.get().~value_type();
+        erased.m_occupied = false;
+        m_freeSlots.push_back(slotIndex);
+        std::push_heap(m_freeSlots.begin(), m_freeSlots.end(), std::greater<uint32_t>());
+        m_size--;
+
+        // backward shift deletion. Entries after the hole move into it if their home bucket allows, so no tombstones are needed
+        const std::size_t mask = m_table.size() - 1;
+        std::size_t hole = entryIndex;
+        for (std::size_t i = (hole + 1) & mask; m_table[i].m_slot != c_emptySlot; i = (i + 1) & mask)
+            {
+                const std::size_t home = getBucket(m_table[i].m_key);
+                if (((i - home) & mask) >= ((i - hole) & mask))
+                    {
+                        m_table[hole] = m_table[i];
+                        hole = i;
+                    }
+            }
+        m_table[hole] = entry{};
+    }
+
+template<typename T>
+inline typename chunkMap<T>::iterator chunkMap<T>::find(const glm::ivec3 &position)
+    {
+        const std::size_t entryIndex = findEntry(encode(position));
+        return entryIndex == m_table.size() ? end() : iterator(this, m_table[entryIndex].m_slot);
+    }
+
+template<typename T>
+inline typename chunkMap<T>::const_iterator chunkMap<T>::find(const glm::ivec3 &position) const
+    {
+        const std::size_t entryIndex = findEntry(encode(position));
+        return entryIndex == m_table.size() ? end() : const_iterator(this, m_table[entryIndex].m_slot);
+    }
+
+template<typename T>
+inline T *chunkMap<T>::get(const glm::ivec3 &position)
+    {
+        return getByKey(encode(position));
+    }
+
+template<typename T>
+inline const T *chunkMap<T>::get(const glm::ivec3 &position) const
+    {
+        return getByKey(encode(position));
+    }
+
+template<typename T>
+inline T *chunkMap<T>::getByKey(uint64_t key)
+    {
+        const std::size_t entryIndex = findEntry(key);
+        return entryIndex == m_table.size() ? nullptr : &getSlot(m_table[entryIndex].m_slot).get().second;
+    }
+
+template<typename T>
+inline const T *chunkMap<T>::getByKey(uint64_t key) const
+    {
+        const std::size_t entryIndex = findEntry(key);
+        return entryIndex == m_table.size() ? nullptr : &getSlot(m_table[entryIndex].m_slot).get().second;
+    }
+
+template<typename T>
+inline bool chunkMap<T>::contains(const glm::ivec3 &position) const
+    {
+        return findEntry(encode(position)) != m_table.size();
+    }
+
+template<typename T>
+T &chunkMap<T>::at(const glm::ivec3 &position)
+    {
+        T *value = get(position);
+        if (!value)
+            {
+                throw std::out_of_range("chunkMap::at");
+            }
+        return *value;
+    }
+
+template<typename T>
+const T &chunkMap<T>::at(const glm::ivec3 &position) const
+    {
+        const T *value = get(position);
+        if (!value)
+            {
+                throw std::out_of_range("chunkMap::at");
+            }
+        return *value;
+    }
+
+template<typename T>
+typename chunkMap<T>::neighbourList chunkMap<T>::getNeighbours(const glm::ivec3 &position)
+    {
+        neighbourList neighbours{};
+        const uint64_t key = encode(position);
+        for (std::size_t i = 0; i < neighbours.size(); i++)
+            {
+                neighbours[i] = getByKey(getNeighbourKey(key, i));
+            }
+        return neighbours;
+    }
+
+template<typename T>
+typename chunkMap<T>::constNeighbourList chunkMap<T>::getNeighbours(const glm::ivec3 &position) const
+    {
+        constNeighbourList neighbours{};
+        const uint64_t key = encode(position);
+        for (std::size_t i = 0; i < neighbours.size(); i++)
+            {
+                neighbours[i] = getByKey(getNeighbourKey(key, i));
+            }
+        return neighbours;
+    }
+
+template<typename T>
+template<typename ...Args>
+std::pair<typename chunkMap<T>::iterator, bool> chunkMap<T>::emplace(const glm::ivec3 &position, Args &&...args)
+    {
+        const uint64_t key = encode(position);
+        const std::size_t existing = findEntry(key);
+        if (existing != m_table.size())
+            {
+                return { iterator(this, m_table[existing].m_slot), false };
+            }
+
+        // kept at most half full so probe runs stay short
+        if ((m_size + 1) * 2 > m_table.size())
+            {
+                rehash(std::max(c_minimumTableSize, m_table.size() * 2));
+            }
+
+        const uint32_t slotIndex = allocateSlot();
+        slot &inserted = getSlot(slotIndex);
+        new (inserted.m_storage) value_type(std::piecewise_construct, std::forward_as_tuple(position), std::forward_as_tuple(std::forward<Args>(args)...));
+        inserted.m_occupied = true;
+
+        const std::size_t mask = m_table.size() - 1;
+        std::size_t i = getBucket(key);
+        while (m_table[i].m_slot != c_emptySlot)
+            {
+                i = (i + 1) & mask;
+            }
+        m_table[i].m_key = key;
+        m_table[i].m_slot = slotIndex;
+        m_size++;
+
+        return { iterator(this, slotIndex), true };
+    }
+
+template<typename T>
+T &chunkMap<T>::operator[](const glm::ivec3 &position)
+    {
+        return emplace(position).first->second;
+    }
+
+template<typename T>
+typename chunkMap<T>::iterator chunkMap<T>::erase(const_iterator it)
+    {
+        assert(it.m_map == this && it.m_slot < m_slotCount);
+        const std::size_t entryIndex = findEntry(encode(it->first));
+        assert(entryIndex != m_table.size());
+        eraseEntry(entryIndex);
+        return iterator(this, it.m_slot + 1);
+    }
+
+template<typename T>
+bool chunkMap<T>::erase(const glm::ivec3 &position)
+    {
+        const std::size_t entryIndex = findEntry(encode(position));
+        if (entryIndex == m_table.size())
+            {
+                return false;
+            }
+
+        eraseEntry(entryIndex);
+        return true;
+    }
+
+template<typename T>
+void chunkMap<T>::clear()
+    {
+        for (uint32_t i = 0; i < m_slotCount; i++)
+            {
+                slot &current = getSlot(i);
+                if (current.m_occupied)
+                    {
+                        current.get().~value_type();
+                        current.m_occupied = false;
+                    }
+            }
+
+        m_table.clear();
+        m_pages.clear();
+        m_freeSlots.clear();
+        m_slotCount = 0;
+        m_size = 0;
+        m_shift = 64;
+    }
+
+template<typename T>
+void chunkMap<T>::reserve(std::size_t count)
+    {
+        std::size_t tableSize = c_minimumTableSize;
+        while (tableSize < count * 2)
+            {
+                tableSize *= 2;
+            }
+
+        if (tableSize > m_table.size())
+            {
+                rehash(tableSize);
+            }
+    }
+
+template<typename T>
+inline std::size_t chunkMap<T>::size() const
+    {
+        return m_size;
+    }
+
+template<typename T>
+inline bool chunkMap<T>::empty() const
+    {
+        return m_size == 0;
+    }
+
+template<typename T>
+inline typename chunkMap<T>::iterator chunkMap<T>::begin()
+    {
+        return iterator(this, 0);
+    }
+
+template<typename T>
+inline typename chunkMap<T>::iterator chunkMap<T>::end()
+    {
+        return iterator(this, m_slotCount);
+    }
+
+template<typename T>
+inline typename chunkMap<T>::const_iterator chunkMap<T>::begin() const
+    {
+        return const_iterator(this, 0);
+    }
+
+template<typename T>
+inline typename chunkMap<T>::const_iterator chunkMap<T>::end() const
+    {
+        return const_iterator(this, m_slotCount);
+    }
@@ -0,0 +1,90 @@
+// meshCache.hpp
+// Finished sub-chunk meshes for a 32x32 column of chunks, stored next to the region file holding their voxels. Every sub-chunk has a few
+// ways, each keyed by a hash of everything its mesh was built from, so a mesh is only reused if its inputs are unchanged. Faces are stored
+// uncompressed so a hit is a straight copy out of the file. Every way owns a slot sized to a power of two faces which is refilled in place,
+// slots that are outgrown are reused by later writes, and the file never grows past c_maxFileSize
+#pragma once
+#include <vector>
+#include <map>
+#include <string>
+#include <mutex>
+#include <cstdint>
+#include <glm/vec3.hpp>
+#include "mappedFile.hpp"
+#include "graphics/packedFace.hpp"
+
+class meshCache
+    {
+        public:
+            static constexpr uint64_t c_hashSeed = 0xcbf29ce484222325ull;
+            // a sub-chunk on the edge of a chunk is meshed against every combination of its two horizontal neighbours being loaded
+            static constexpr uint32_t c_ways = 4;
+            // meshes that would need the file to grow past this are not cached
+            static constexpr uint64_t c_maxFileSize = 256ull << 20;
+            static constexpr uint32_t c_minimumSlotSize = 64;
+
+        private:
+            struct header
+                {
+                    uint32_t m_magic = c_magic;
+                    uint32_t m_version = c_version;
+                    uint32_t m_mesherVersion = 0;
+                    uint32_t m_regionSize = 0;
+                    uint32_t m_subChunksPerChunk = 0;
+                    uint32_t m_faceSize = sizeof(packedFace);
+                    uint32_t m_ways = c_ways;
+                    uint32_t m_reserved = 0;
+                };
+
+            // A sequence of 0 means the way holds no mesh. The lowest sequence is replaced first. A capacity of 0 means the way owns no slot
+            struct indexEntry
+                {
+                    uint64_t m_key = 0;
+                    uint64_t m_offset = 0;
+                    uint32_t m_faceCount = 0;
+                    uint32_t m_sequence = 0;
+                    uint32_t m_capacity = 0;
+                    uint32_t m_reserved = 0;
+                };
+
+            static constexpr uint32_t c_magic = 0x434d5856; // VXMC
+            static constexpr uint32_t c_version = 2;
+            static constexpr std::size_t c_indexOffset = sizeof(header);
+
+            std::string m_path;
+            mappedFile m_file;
+            uint32_t m_subChunksPerChunk = 0;
+            uint32_t m_sequence = 0;
+            // slots no way points at, by offset. Rebuilt from the gaps between slots when the file is opened
+            std::map<uint64_t, uint64_t> m_freeSlots;
+
+            mutable std::mutex m_mutex;
+
+            bool reset(uint32_t mesherVersion);
+            // Offset of a free slot of the size, taken from the free slots or the end of the file. Returns false if the file would grow too large
+            bool allocateSlot(uint64_t size, uint64_t &offset);
+            void releaseSlot(uint64_t offset, uint64_t size);
+            std::size_t getDataOffset() const;
+            std::size_t getEntryIndex(const glm::ivec3 &chunkPosition, std::size_t subChunkIndex) const;
+
+        public:
+            meshCache() = default;
+            meshCache(const meshCache &rhs) = delete;
+            meshCache &operator=(const meshCache &rhs) = delete;
+            ~meshCache();
+
+            // Opens the cache file, creating it if it does not exist. A file written by another mesher version or layout is emptied
+            bool open(const char *file, uint32_t mesherVersion, uint32_t subChunksPerChunk);
+            void close();
+            bool isOpen() const;
+
+            // Replaces the faces with the cached mesh. Returns false if no way of the sub-chunk holds the key
+            bool read(const glm::ivec3 &chunkPosition, std::size_t subChunkIndex, uint64_t key, std::vector<packedFace> &faces);
+            // Replaces the oldest way of the sub-chunk with the mesh. Its slot is refilled if the mesh fits, otherwise it is released for reuse
+            bool write(const glm::ivec3 &chunkPosition, std::size_t subChunkIndex, uint64_t key, const packedFace *faces, std::size_t faceCount);
+
+            // FNV-1a, continuing from the given hash
+            static uint64_t hash(const void *data, std::size_t size, uint64_t seed = c_hashSeed);
+            static std::string getFileName(const glm::ivec3 &regionPosition);
+
+    };
@@ -2,36 +2,89 @@
 // A chunk of voxels. Designed to be quickly read to and from disk
 #pragma once
 #include <vector>
+#include <array>
+#include <cstdint>
 #include "voxel/voxelType.hpp"
 #include "graphics/quad.hpp"
+#include "graphics/packedFace.hpp"
 
 class voxelChunk
     {
         public:
             using sizeType = std::vector<voxelType>::size_type;
+            // Chunks bordering this one, used to resolve faces on the chunk boundary. Ordered +x, -x, +y, -y, +z, -z. Missing neighbours are treated as air
+            using neighbourList = std::array<const voxelChunk*, 6>;
+            // largest chunk a serialised header may claim. Anything larger is treated as corrupt rather than allocated
+            static constexpr sizeType c_maxSerialisedSize = 1024;
+            static constexpr sizeType c_maxSerialisedVolume = 1 << 24;
+
+            // Writable handle to a single voxel. Assigning through it goes through the palette
+            class reference
+                {
+                    private:
+                        voxelChunk &m_chunk;
+                        sizeType m_index;
+
+                    public:
+                        reference(voxelChunk &chunk, sizeType index);
+                        operator voxelType() const;
+                        reference &operator=(voxelType type);
+                        reference &operator=(const reference &rhs);
+                };
 
         private:
-            std::vector<voxelType> m_voxels;
-            voxelType *m_voxelData = nullptr;
+            // Voxels are stored as indices into a palette of the types present in the chunk. Indices are 0, 1, 2, 4 or 8 bits wide and
+            // never straddle a word. A width of 0 means the chunk is uniformly m_palette[0] and no indices are stored
+            std::vector<voxelType> m_palette;
+            std::vector<uint64_t> m_indices;
+            unsigned int m_bitsPerIndex = 0;
+            // log2 of the amount of indices per word
+            unsigned int m_indicesPerWordShift = 0;
 
             sizeType m_sizeX = 0;
             sizeType m_sizeY = 0;
             sizeType m_sizeZ = 0;
             float m_voxelSize = 1.f;
 
+            // Layout of a serialised chunk: this header, the palette, then runs of (palette index byte, LEB128 run length) in index order
+            struct serialisedHeader
+                {
+                    uint32_t m_sizeX = 0;
+                    uint32_t m_sizeY = 0;
+                    uint32_t m_sizeZ = 0;
+                    float m_voxelSize = 1.f;
+                    uint32_t m_paletteSize = 0;
+                };
+
+            sizeType getIndex(voxelChunk::sizeType x, voxelChunk::sizeType y, voxelChunk::sizeType z) const;
+            unsigned int getPaletteIndexAt(voxelChunk::sizeType index) const;
+            voxelType get(voxelChunk::sizeType index) const;
+            void set(voxelChunk::sizeType index, voxelType type);
+            unsigned int getPaletteIndex(voxelType type);
+            void setIndexWidth(unsigned int bitsPerIndex);
+
         public:
             voxelChunk() = default;
             voxelChunk(voxelChunk::sizeType sizeX, voxelChunk::sizeType sizeY, voxelChunk::sizeType sizeZ);
             void create(voxelChunk::sizeType sizeX, voxelChunk::sizeType sizeY, voxelChunk::sizeType sizeZ);
 
-            const voxelType &at(voxelChunk::sizeType x, voxelChunk::sizeType y, voxelChunk::sizeType z) const;
-            voxelType &at(voxelChunk::sizeType x, voxelChunk::sizeType y, voxelChunk::sizeType z);
+            voxelType at(voxelChunk::sizeType x, voxelChunk::sizeType y, voxelChunk::sizeType z) const;
+            voxelChunk::reference at(voxelChunk::sizeType x, voxelChunk::sizeType y, voxelChunk::sizeType z);
 
-            const voxelType &at(voxelChunk::sizeType index) const;
-            voxelType &at(voxelChunk::sizeType index);
+            voxelType at(voxelChunk::sizeType index) const;
+            voxelChunk::reference at(voxelChunk::sizeType index);
 
-            const voxelType &operator[](voxelChunk::sizeType index) const;
-            voxelType &operator[](voxelChunk::sizeType index);
+            voxelType operator[](voxelChunk::sizeType index) const;
+            voxelChunk::reference operator[](voxelChunk::sizeType index);
+
+            // Replaces every voxel from a flat array of getVolume() voxels laid out x, then y, then z. Builds the palette in one pass
+            void assign(const voxelType *voxels);
+            // Expands the chunk into a flat array of getVolume() voxels
+            void extract(voxelType *voxels) const;
+
+            bool uniform() const;
+            std::size_t getPaletteSize() const;
+            std::size_t getMemoryUsage() const;
 
             voxelChunk::sizeType getSizeX() const;
             voxelChunk::sizeType getSizeY() const;
@@ -41,12 +94,28 @@ class voxelChunk
             void write(const char *file);
             void read(const char *file);
 
+            // Appends the chunk as a compressed blob. Used by voxelRegion
+            void serialise(std::vector<uint8_t> &data) const;
+            // Decodes straight into packed storage. Returns false and leaves the chunk empty if the blob is malformed. The header is
+            // checked against the size of the blob before anything is allocated
+            bool deserialise(const uint8_t *data, std::size_t size);
+
             void setVoxelSize(float size);
             float getVoxelSize() const;
 
             void mesh(std::vector<quad> &quads) const;
+            void mesh(std::vector<quad> &quads, const voxelChunk::neighbourList &neighbours) const;
             void meshAtPosition(std::vector<quad> &quads, voxelChunk::sizeType x, voxelChunk::sizeType y, voxelChunk::sizeType z) const;
+            void meshAtPosition(std::vector<quad> &quads, voxelChunk::sizeType x, voxelChunk::sizeType y, voxelChunk::sizeType z, const voxelChunk::neighbourList &neighbours) const;
+            // Faces are positioned relative to the origin, which is expected to be the corner of the sub-chunk being meshed
+            void meshAtPosition(std::vector<packedFace> &faces, voxelChunk::sizeType x, voxelChunk::sizeType y, voxelChunk::sizeType z, voxelChunk::sizeType originX, voxelChunk::sizeType originY, voxelChunk::sizeType originZ, const voxelChunk::neighbourList &neighbours) const;
+
+            // Bit i is set if the face with orientation index i is exposed. Orientation indices map to +1, -1, +2, -2, +3, -3
+            unsigned char getVisibleFaces(voxelChunk::sizeType x, voxelChunk::sizeType y, voxelChunk::sizeType z, const voxelChunk::neighbourList &neighbours) const;
 
             bool withinBounds(voxelChunk::sizeType x, voxelChunk::sizeType y, voxelChunk::sizeType z) const;
+            // Position may lie one voxel outside of the chunk, in which case the relevant neighbour is sampled
+            bool emptyAt(int x, int y, int z, const voxelChunk::neighbourList &neighbours) const;
+            voxelType typeAt(int x, int y, int z, const voxelChunk::neighbourList &neighbours) const;
 
     };
@@ -0,0 +1,76 @@
+// voxelRegion.hpp
+// A single file holding a 32x32 column of chunks along x and z. An index table at the start of the file locates every chunk,
+// which is stored as a compressed blob. The file is memory mapped and chunks are only decoded when read. The file grows geometrically
+// so most writes land inside the mapping and it is only rebuilt when the file has to grow
+#pragma once
+#include <vector>
+#include <string>
+#include <mutex>
+#include <cstdint>
+#include <glm/vec3.hpp>
+#include "mappedFile.hpp"
+
+class voxelChunk;
+class voxelRegion
+    {
+        public:
+            static constexpr int c_regionSize = 32;
+
+        private:
+            struct header
+                {
+                    uint32_t m_magic = c_magic;
+                    uint32_t m_version = c_version;
+                    uint32_t m_regionSize = c_regionSize;
+                    uint32_t m_reserved = 0;
+                };
+
+            // An offset of 0 means the chunk has never been written
+            struct indexEntry
+                {
+                    uint64_t m_offset = 0;
+                    uint32_t m_size = 0;
+                    uint32_t m_reserved = 0;
+                };
+
+            static constexpr uint32_t c_magic = 0x47525856; // VXRG
+            static constexpr uint32_t c_version = 1;
+            static constexpr std::size_t c_indexOffset = sizeof(header);
+            static constexpr std::size_t c_dataOffset = c_indexOffset + c_regionSize * c_regionSize * sizeof(indexEntry);
+
+            std::string m_path;
+            mappedFile m_file;
+            // kept in memory so writes never have to go through the mapping to find an entry
+            std::vector<indexEntry> m_index;
+            // end of the last blob. Everything from here to the end of the file is spare capacity
+            uint64_t m_dataEnd = 0;
+            // blobs written past this since the mapping was built are read through the file
+            uint64_t m_mappedEnd = 0;
+
+            mutable std::mutex m_mutex;
+
+            bool map();
+            std::size_t getEntryIndex(const glm::ivec3 &chunkPosition) const;
+            indexEntry getEntry(const glm::ivec3 &chunkPosition) const;
+
+        public:
+            voxelRegion() = default;
+            voxelRegion(const voxelRegion &rhs) = delete;
+            voxelRegion &operator=(const voxelRegion &rhs) = delete;
+            ~voxelRegion();
+
+            // Opens the region file, creating an empty one if it does not exist
+            bool open(const char *file);
+            void close();
+            bool isOpen() const;
+
+            bool contains(const glm::ivec3 &chunkPosition) const;
+            // Returns false if the chunk is not stored in this region
+            bool read(const glm::ivec3 &chunkPosition, voxelChunk &chunk) const;
+            // Appends the chunk after the last blob and points its index entry at it. The previous blob is left as dead space
+            bool write(const glm::ivec3 &chunkPosition, const voxelChunk &chunk);
+
+            static glm::ivec3 getRegionPosition(const glm::ivec3 &chunkPosition);
+            static std::string getFileName(const glm::ivec3 &regionPosition);
+
+    };
@@ -2,87 +2,305 @@
 // Defines a space for a voxel subset.
 #pragma once
 #include "voxel/voxelChunk.hpp"
+#include "voxel/voxelRegion.hpp"
+#include "voxel/chunkMap.hpp"
+#include "voxel/meshCache.hpp"
 #include "graphics/vulkan/vulkanBuffer.hpp"
 #include "graphics/vertexBuffer.hpp"
 #include "graphics/indexBuffer.hpp"
-#include "graphics/quad.hpp"
+#include "graphics/packedFace.hpp"
+#include "graphics/buddyAllocator.hpp"
+#include "graphics/frustum.hpp"
+#include "graphics/occlusionBuffer.hpp"
 #include <glm/gtx/hash.hpp>
 #include <glm/gtc/quaternion.hpp>
 #include <glm/mat4x4.hpp>
 #include <vector>
+#include <array>
 #include <unordered_map>
+#include <unordered_set>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <string>
 
-#include "FastNoise.h"
+#include "voxel/batchNoise.hpp"
+#include "taskGraph.hpp"
 
 class descriptorSet;
-class taskGraph;
+class taskProfiler;
 class voxelSpace
     {
         private:
             struct chunkVoxelData
                 {
-                    std::vector<quad> m_quads;
-                    std::vector<vertex> m_vertices;
-                    std::vector<fe::index> m_indices;
-                    void *m_vertexStagingBuffer = nullptr;
-                    void *m_indexStagingBuffer = nullptr;
-                    std::size_t m_vertexCount = 0;
-                    std::size_t m_indexCount = 0;
+                    std::vector<packedFace> m_faces;
+                    std::size_t m_faceCount = 0;
+                    // range of the face region owned by this sub-chunk, in faces. Invalid while the sub-chunk has no faces
+                    buddyAllocator::allocation m_allocation;
+                    // slot in the origin region. Passed to the draw as the first instance
+                    unsigned int m_drawIndex = 0;
+                    // summary kept current by generation, loading and setAt. Meshing is skipped when the sub-chunk is empty,
+                    // or solid with every neighbouring boundary closed. Raycasts skip empty sub-chunks
+                    int m_solidCount = 0;
+                    bool m_allSolid = false;
+                    // bit i is set if boundary i holds an empty voxel. Boundaries are ordered like voxelChunk::neighbourList
+                    unsigned char m_openFaces = 0;
+                    // bit per 8x8x8 cell that is completely solid, x first. Rasterised as occluders
+                    uint64_t m_solidCells = 0;
+                    // queued for remeshing by an edit. Cleared once the remesh is submitted
+                    bool m_dirty = false;
+                    // mesh cache key of the inputs the faces were built from, zero if they are not cached. Written out when the chunk unloads
+                    uint64_t m_meshKey = 0;
                 };
 
             struct chunkData
                 {
                     voxelChunk m_chunk;
+                    // flat voxels written by the generation tasks. Packed into the chunk once generation finishes and released
+                    std::vector<voxelType> m_generationBuffer;
                     std::vector<chunkVoxelData> m_voxelData;
                     voxelChunk::sizeType m_sizeX = 0;
                     voxelChunk::sizeType m_sizeY = 0;
                     voxelChunk::sizeType m_sizeZ = 0;
-                    voxelChunk::sizeType m_positionX = 0;
-                    voxelChunk::sizeType m_positionY = 0;
-                    voxelChunk::sizeType m_positionZ = 0;
+                    int m_positionX = 0;
+                    int m_positionY = 0;
+                    int m_positionZ = 0;
                     voxelChunk::sizeType m_subSize = 0;
-                    unsigned int m_indexOffset = 0;
-                    unsigned int m_vertexCount = 0;
-                    unsigned int m_indexCount = 0;
+                    // detail level the chunk is meshed at. Each face covers (1 << m_lod) voxels to a side
+                    unsigned int m_lod = 0;
+                    bool m_generated = false;
+                    // edited since it was generated or loaded. Written back to its region when unloaded
+                    bool m_modified = false;
                 };
 
+            // A sub-chunk remeshed on the workers while the frame goes on. The mesh is built into m_mesh rather than the sub-chunk, which
+            // the frame may still be culling, and moved across once the submission has finished
+            struct remeshJob
+                {
+                    chunkData *m_chunk = nullptr;
+                    std::size_t m_subChunkIndex = 0;
+                    std::array<const chunkData*, 6> m_neighbours = {};
+                    chunkVoxelData m_mesh;
+                };
+
+            // A mesh on its way into the cache. Unloaded chunks hand theirs to the streaming thread so the frame never waits on the file
+            struct cacheWrite
+                {
+                    glm::ivec3 m_chunkPosition = {};
+                    std::size_t m_subChunkIndex = 0;
+                    uint64_t m_key = 0;
+                    std::vector<packedFace> m_faces;
+                };
+
+            // Layout: [shared index pattern][packed faces][sub-chunk origins]. Every sub-chunk owns a range of the face region and an origin slot,
+            // so one can be replaced without touching the others. The staging buffer mirrors the device buffer and only dirty ranges are copied
             struct localBuffer
                 {
-                    vulkanBuffer m_masterBuffer;
-                    vulkanBuffer m_masterStagingBuffer;
+                    struct deferredRelease
+                        {
+                            uint64_t m_frame = 0;
+                            buddyAllocator::allocation m_allocation;
+                            unsigned int m_drawIndex = 0;
+                        };
+
+                    std::unique_ptr<vulkanBuffer> m_masterBuffer;
+                    std::unique_ptr<vulkanBuffer> m_masterStagingBuffer;
                     void *m_cpuStagingBuffer = nullptr;
-                    unsigned int m_maxVertexCount = 0;
-                    unsigned int m_maxIndexCount = 0;
-                    unsigned int m_bufferSize = 0;
-                    bool m_needUpdate = false;
+                    buddyAllocator m_faceAllocator;
+                    std::vector<unsigned int> m_freeDrawIndices;
+                    unsigned int m_maxSubChunkCount = 0;
+                    VkDeviceSize m_faceOffset = 0;
+                    VkDeviceSize m_originOffset = 0;
+                    // one slot of draw commands per frame in flight, rewritten by every cull
+                    VkDeviceSize m_indirectOffset = 0;
+                    VkDeviceSize m_bufferSize = 0;
+                    std::vector<VkBufferCopy> m_dirtyRanges;
+                    // ranges and buffers a frame in flight may still read. Released once c_framesInFlight frames have passed
+                    std::vector<deferredRelease> m_deferredReleases;
+                    std::vector<std::pair<uint64_t, std::unique_ptr<vulkanBuffer>>> m_retiredBuffers;
+                    uint64_t m_frame = 0;
+                    // bumped every time the buffers are recreated, so descriptors pointing at the old ones can be rebound
+                    uint32_t m_generation = 0;
                     bool m_exists = false;
 
-                    void create(unsigned int vertexCount, unsigned int indexCount);
+                    void create(uint64_t faceCapacity, unsigned int subChunkCapacity);
+                    // Recreates the buffers to fit the allocator capacity and the slot count. Contents are carried over and the old buffers retired
+                    void resize(unsigned int subChunkCapacity);
+                    void createBuffers();
                     void destroy();
+
+                    buddyAllocator::allocation allocateFaces(std::size_t faceCount);
+                    unsigned int allocateDrawIndex();
+                    void release(const buddyAllocator::allocation &allocation, unsigned int drawIndex);
+                    void markDirty(VkDeviceSize offset, VkDeviceSize size);
+                    void nextFrame();
+                    VkDeviceSize getIndirectSlotOffset() const;
                 };
 
             static constexpr voxelChunk::sizeType c_chunkSubSize = 32;
             static constexpr glm::ivec3 c_chunkSize = { 64, 32, 64 };
             static constexpr float c_voxelSize = 1.0f;
+            // a checkerboard sub-chunk exposes every face of half of its voxels
+            static constexpr unsigned int c_maxFacesPerSubChunk = c_chunkSubSize * c_chunkSubSize * c_chunkSubSize * 3;
+            // covers minStorageBufferOffsetAlignment on all hardware we target
+            static constexpr VkDeviceSize c_storageAlignment = 256;
+            // smallest face range handed to a sub-chunk and the initial capacities of the buffer
+            static constexpr uint64_t c_minimumFaceAllocation = 64;
+            static constexpr uint64_t c_initialFaceCapacity = 1 << 18;
+            static constexpr unsigned int c_initialSubChunkCapacity = 256;
+            // matches renderer::c_maxFramesInFlight
+            static constexpr uint64_t c_framesInFlight = 3;
+            static constexpr glm::ivec3 c_neighbourDirections[6] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+            // chunks generated by the streaming thread per graph execution
+            static constexpr unsigned int c_streamingBatchSize = 4;
+            // background generation time allowed per rendered frame so streaming does not starve the frame of cores. The main loop
+            // starts each frame's allowance with taskScheduler::beginFrame
+            static constexpr std::chrono::microseconds c_streamingFrameBudget{ 8000 };
+            // distance in chunks from the camera at which each detail level starts. Levels only change once the distance
+            // passes the threshold by the hysteresis so chunks on a boundary do not flicker between meshes
+            static constexpr unsigned int c_lodLevels = 4;
+            static constexpr float c_lodDistances[c_lodLevels] = { 0.f, 3.f, 6.f, 12.f };
+            static constexpr float c_lodHysteresis = 0.5f;
+            static constexpr int c_solidCellSize = 8;
+            static constexpr int c_solidCellsPerSide = c_chunkSubSize / c_solidCellSize;
+            // occluders are taken from the nearest sub-chunks first until this many boxes have been drawn
+            static constexpr unsigned int c_maxOccluders = 1024;
+            static constexpr unsigned int c_occlusionWidth = 256;
+            static constexpr unsigned int c_occlusionHeight = 128;
+            // bump whenever the mesher output changes so cached meshes are thrown away
+            static constexpr uint32_t c_mesherVersion = 2;
             localBuffer m_localBuffer;
-            std::unordered_map<glm::ivec3, chunkData> m_loadedChunks;
+            chunkMap<chunkData> m_loadedChunks;
+            // stands in for a neighbour meshed at a coarser detail level. Uniformly solid so nothing is emitted towards it
+            chunkData m_solidNeighbour;
+
+            // one box per sub-chunk with faces, in model space. Rebuilt when sub-chunks gain or lose their allocation
+            boundingBoxes m_subChunkBounds;
+            std::vector<const chunkVoxelData*> m_boundedSubChunks;
+            bool m_boundsDirty = true;
+            VkDeviceSize m_visibleOffset = 0;
+            uint32_t m_visibleCount = 0;
+            // buffer generation the descriptors were last pointed at. Zero before any buffer exists
+            uint32_t m_boundGeneration = 0;
+            uint32_t m_occludedCount = 0;
+            uint32_t m_outsideFrustumCount = 0;
+            uint32_t m_occluderCount = 0;
+            glm::mat4 m_viewProjection = glm::mat4(1.f);
+            glm::vec3 m_cameraPosition = {};
+            occlusionBuffer m_occlusionBuffer;
+
+            taskGraph *m_graph = nullptr;
+            // Loaded chunks are not changed while the remesh is running. Streaming waits for a later frame and edits wait for it to finish
+            std::vector<remeshJob> m_remeshJobs;
+            taskGraph::executionHandle m_remeshHandle;
+            // sub-chunks edited since the last flush, by chunk position so they survive chunks being unloaded
+            std::vector<std::pair<glm::ivec3, std::size_t>> m_dirtySubChunks;
+            batchNoise m_noise;
+
+            // Chunks are generated and meshed on a dedicated thread running its own graph so the render thread never waits on them.
+            // Everything below the mutex is shared with that thread
+            std::unique_ptr<taskGraph> m_streamingGraph;
+            std::thread m_streamingThread;
+            std::mutex m_streamingMutex;
+            std::condition_variable m_streamingCondition;
+            // heap ordered so the chunk nearest to the streaming centre is at the front
+            std::vector<glm::ivec3> m_pendingChunks;
+            std::vector<std::pair<glm::ivec3, std::unique_ptr<chunkData>>> m_completedChunks;
+            std::vector<cacheWrite> m_pendingCacheWrites;
+            glm::ivec3 m_streamingCentre = { 0, 0, 0 };
+            bool m_streaming = false;
+
+            // Empty disables persistence. Regions are opened on first use and shared with the streaming thread
+            std::string m_saveDirectory;
+            std::unordered_map<glm::ivec3, std::unique_ptr<voxelRegion>> m_regions;
+            std::unordered_map<glm::ivec3, std::unique_ptr<meshCache>> m_meshCaches;
+            std::mutex m_regionMutex;
+            bool m_meshCacheEnabled = false;
+
+            // positions that are pending, being generated or waiting to be integrated. Only touched by the render thread
+            std::unordered_set<glm::ivec3> m_requestedChunks;
+            bool m_streamingCentreValid = false;
+            int m_streamingRadius = 4;
+            unsigned int m_integrationBudget = 2;
 
             glm::mat4 m_translation;
             glm::quat m_quaternion;
-            friend void buildChunkMesh(const chunkData &chunkData, chunkVoxelData &voxelData, voxelChunk::sizeType &x, voxelChunk::sizeType &y, voxelChunk::sizeType &z);
-            friend void buildChunkMesh(chunkData &chunkData);
-            friend unsigned int buildGeometry(glm::vec3 offset, chunkVoxelData &voxelData, unsigned int indexOffset);
+            friend void buildChunkMesh(const chunkData &chunkData, chunkVoxelData &voxelData, voxelChunk::sizeType &x, voxelChunk::sizeType &y, voxelChunk::sizeType &z, const voxelChunk::neighbourList &neighbours);
 
-            void updateSubChunkMemory(chunkVoxelData &chunk);
-            void updateChunkMemory(chunkData &chunk);
-            void updateChunkMemory(chunkData &chunk, void *stagingBuffer, unsigned long long vertexBufferOffset, int &vertexOffset, int &indexOffset);
-            void updateMemory();
+            // Replaces the range of the sub-chunk with one fitting its current faces and marks it dirty. Does not copy faces
+            void allocateSubChunk(chunkData *chunk, std::size_t subChunkIndex);
+            // Copies the faces into the staging range. Safe to run in parallel once every sub-chunk is allocated
+            void writeSubChunkMemory(chunkVoxelData *chunk);
+            void updateSubChunkMemory(chunkData &chunk, std::size_t subChunkIndex);
+            void rebuildBounds();
+            // Draws the solid parts of the nearest visible sub-chunks into the occlusion buffer
+            void rasteriseOccluders(const std::vector<uint32_t> &visible);
 
-            void createChunk(chunkData &chunk, const voxelChunk::sizeType sizeX, const voxelChunk::sizeType sizeY, const voxelChunk::sizeType sizeZ, const voxelChunk::sizeType posX, const voxelChunk::sizeType posY, const voxelChunk::sizeType posZ);
-            void buildChunk(chunkData &chunk, unsigned int &totalIndexOffset);
+            void createChunk(chunkData &chunk, const voxelChunk::sizeType sizeX, const voxelChunk::sizeType sizeY, const voxelChunk::sizeType sizeZ, const int posX, const int posY, const int posZ);
+            void finishChunkGeneration(chunkData *chunk);
+            void meshSubChunk(remeshJob *job);
+            // Meshes without looking at the loaded chunks so it is safe to call off the render thread. Borders are fixed up on integration
+            void meshDetachedSubChunk(chunkData *chunk, std::size_t subChunkIndex);
+            // Downsamples the sub-chunk by majority vote and meshes the result. Voxels past the border are taken from the neighbours
+            void buildLodMesh(const chunkData &chunk, std::size_t subChunkIndex, chunkVoxelData &voxelData, const voxelChunk::neighbourList &neighbours) const;
             void destroyChunk(chunkData &chunk);
 
-            void buildSlice(chunkData &chunk, unsigned int y, const FastNoise &noise);
+            glm::ivec3 getSubChunkCount(const chunkData &chunk) const;
+            std::size_t getSubChunkIndex(const chunkData &chunk, glm::ivec3 localPosition) const;
+            glm::ivec3 getSubChunkPosition(const chunkData &chunk, std::size_t subChunkIndex) const;
+            // clipped to the chunk
+            glm::ivec3 getSubChunkSize(const chunkData &chunk, std::size_t subChunkIndex) const;
+            unsigned char getOpenFaces(const chunkData &chunk, std::size_t subChunkIndex) const;
+            void summariseSubChunk(chunkData &chunk, std::size_t subChunkIndex);
+            bool solidCellFull(const chunkData &chunk, std::size_t subChunkIndex, int cell) const;
+            // nullptr if the chunk is not loaded or still being generated
+            const chunkData *findChunk(const glm::ivec3 &chunkPosition) const;
+            // Chunks at different detail levels would both close their shared border and leave a double wall. The coarser side alone closes it:
+            // a coarser neighbour is swapped for m_solidNeighbour and a finer one is left out. The finer chunk is the one nearer the camera, so
+            // the faces it gives up would only ever be seen from behind
+            std::array<const chunkData*, 6> getNeighbourChunks(const glm::ivec3 &chunkPosition, unsigned int lod) const;
+            static voxelChunk::neighbourList getNeighbours(const std::array<const chunkData*, 6> &chunks);
+            // Queue every sub-chunk whose faces could have changed due to the voxel at the global position changing
+            void markDirtyAround(glm::ivec3 globalPosition);
+            // Adds every sub-chunk edited since the last flush to the sub-chunks to remesh
+            void flushEdits(std::vector<std::pair<chunkData*, std::size_t>> &remesh);
+            // Collects the sub-chunks of the chunk at the position which lie on the face in the direction
+            void getBorderSubChunks(const glm::ivec3 &chunkPosition, const glm::ivec3 &direction, std::vector<std::pair<chunkData*, std::size_t>> &subChunks);
+            // Submits the sub-chunks to be remeshed in parallel on the graph and returns straight away. Nothing may be in flight
+            void submitRemesh(const std::vector<std::pair<chunkData*, std::size_t>> &subChunks);
+            // Moves the meshes of a finished remesh into their sub-chunks and uploads them
+            void finishRemesh();
+
+            voxelRegion *getRegion(const glm::ivec3 &chunkPosition);
+            // nullptr unless the mesh cache is enabled and there is a save directory
+            meshCache *getMeshCache(const glm::ivec3 &chunkPosition);
+            // Hash of every input the mesh of the sub-chunk depends on: its voxels and the border of voxels around it the mesher reads,
+            // its detail level and the mesher version. An edit only changes the keys of the sub-chunks it touches. Zero while the cache is off
+            uint64_t getMeshKey(const chunkData &chunk, std::size_t subChunkIndex, const std::array<const chunkData*, 6> &neighbourChunks) const;
+            // Fills the faces of the sub-chunk from the cache. Returns false on a miss
+            bool readCachedMesh(chunkVoxelData &voxelData, const glm::ivec3 &chunkPosition, std::size_t subChunkIndex, uint64_t key);
+            // Moves the meshes of the chunk that have a cache key into the writes. The chunk is about to be destroyed
+            void takeCacheWrites(chunkData &chunk, const glm::ivec3 &chunkPosition, std::vector<cacheWrite> &writes);
+            void writeCachedMeshes(std::vector<cacheWrite> &writes);
+            bool loadChunk(chunkData &chunk, const glm::ivec3 &chunkPosition);
+            // Reads the seed stored in the save directory, or stores a new random one
+            int loadSeed() const;
+            void saveChunk(const chunkData &chunk, const glm::ivec3 &chunkPosition);
+
+            bool withinStreamingRadius(const glm::ivec3 &chunkPosition, const glm::ivec3 &centre, int radius) const;
+            void requestChunks(const glm::ivec3 &centre);
+            bool unloadChunks(const glm::ivec3 &centre, std::vector<std::pair<chunkData*, std::size_t>> &remesh);
+            bool integrateChunks(const glm::ivec3 &centre, std::vector<std::pair<chunkData*, std::size_t>> &remesh, std::vector<std::pair<chunkData*, std::size_t>> &upload);
+            void streamingLoop();
+
+            unsigned int selectLod(float distance, unsigned int currentLod) const;
+            bool updateLods(const glm::vec3 &cameraPosition, std::vector<std::pair<chunkData*, std::size_t>> &remesh);
+
+            // Generates the voxels covered by one sub-chunk. Blocks of a chunk write disjoint parts of the generation buffer
+            void buildBlock(chunkData *chunk, std::size_t subChunkIndex);
             void transformSpace(glm::vec3 globalPosition, glm::ivec3 &chunkPos, glm::vec3 &localPos) const;
             void transformChunkSpace(glm::vec3 globalPosition, glm::ivec3 &chunkPos) const;
             void transformLocalSpace(glm::vec3 globalPosition, glm::vec3 &localPos) const;
@@ -93,22 +311,64 @@ class voxelSpace
             void create();
             void destroy();
 
+            // Starts streaming. Nothing is generated here, the first update requests the chunks around the camera so the render thread
+            // never waits on generation, not even at startup. Sub-chunks are remeshed on the graph, so nothing else may build on it once updates start
             void createWorld(taskGraph *graph);
+            // Streams chunks in and out around the camera. Called once per frame from the render thread. Remeshing runs in the
+            // background and is uploaded by a later update
+            void update(glm::vec3 cameraPosition);
+
+            // Radius in chunks along x and z
+            void setStreamingRadius(int radius);
+            int getStreamingRadius() const;
+            // Chunks are loaded from and saved to region files in this directory, along with the world seed. Must be set before createWorld
+            void setSaveDirectory(const char *directory);
+            // Keeps finished meshes next to the region files so unchanged sub-chunks are not remeshed when they load again. Meshes are
+            // written once their chunk unloads. Off by default. Needs a save directory and must be set before createWorld
+            void setMeshCacheEnabled(bool enabled);
+            // Maximum amount of finished chunks moved into the world per update
+            void setIntegrationBudget(unsigned int budget);
+            std::size_t getLoadedChunkCount() const;
+            std::size_t getRequestedChunkCount() const;
 
             glm::mat4 getModelTransformation() const;
+            // Returns the first non-empty voxel hit, or zero if there is none within range
             glm::vec<3, int> raycast(const glm::vec3 origin, const glm::vec3 direction);
 
-            void updateBuffers(vulkanCommandBuffer &commandBuffer);
+            // Copies the dirty ranges of the staging buffer to the device buffer and makes them visible to the draw. Record outside the render pass
+            void updateBuffers(VkCommandBuffer commandBuffer);
+            // Points the face and origin bindings of voxel_face.vert at the buffer memory. Only rebinds once the memory has been recreated.
+            // Returns false while there is no memory to bind, the descriptors must not be used until then
+            bool bindDescriptors(descriptorSet &descriptors);
             bool needsUpdate() const;
 
+            void setCamera(const glm::mat4 &viewProjection, const glm::vec3 &position);
+            // Writes a draw command for every sub-chunk inside the view frustum and not hidden behind solid terrain. Call once per
+            // frame after update and before updateBuffers. Only reads the world, so it may run on a worker while other work is recorded
+            void cull();
+            // Records the draws chosen by the last cull as one indirect draw. The bound pipeline is expected to use voxel_face.vert
+            // with a descriptor set passed through bindDescriptors. Requires the multiDrawIndirect feature, and
+            // drawIndirectFirstInstance since the shader finds the sub-chunk origin through a non-zero firstInstance
+            void draw(VkCommandBuffer commandBuffer) const;
+
             vulkanBuffer &getBufferMemory();
-            VkDeviceSize getVertexMemoryOffset() const;
             VkDeviceSize getIndexBufferSize() const;
-            VkDeviceSize getVertexBufferSize() const;
-            unsigned int getVertexCount() const;
-            unsigned int getIndexCount() const;
+            VkDeviceSize getFaceMemoryOffset() const;
+            VkDeviceSize getFaceBufferSize() const;
+            VkDeviceSize getOriginMemoryOffset() const;
+            VkDeviceSize getOriginBufferSize() const;
+            unsigned int getFaceCount() const;
+            uint32_t getVisibleSubChunkCount() const;
+            uint32_t getOccludedSubChunkCount() const;
+            uint32_t getOutsideFrustumSubChunkCount() const;
+            uint32_t getOccluderCount() const;
+            // Null until streaming has started
+            taskProfiler *getStreamingProfiler();
+            std::size_t getDrawableSubChunkCount() const;
 
-            const voxelType &at(glm::vec3 position) const;
+            voxelType at(glm::vec3 position) const;
+            // Edits are queued. The affected sub-chunks are remeshed once, in the background, starting from the next update. Waits
+            // for a remesh that is still running, since its tasks read the voxels
             void setAt(glm::vec3 position, voxelType type);
 
     };
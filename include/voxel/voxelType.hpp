@@ -6,5 +6,7 @@ enum class voxelType : unsigned char
     {
         NONE,
         DEFAULT,
-        TEST_1
+        TEST_1,
+        // not a type, the amount of types before it
+        COUNT
     };
@@ -0,0 +1,153 @@
+// workStealingDeque.hpp
+// Chase-Lev work stealing deque. The owning thread pushes and pops at the bottom without locking, any other thread may steal from the top.
+// Memory orderings follow Le et al, "Correct and Efficient Work-Stealing for Weak Memory Models". Arrays replaced by a grow are kept
+// until the deque is destroyed since a thief may still be reading from one
+#pragma once
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+template<typename T>
+class workStealingDeque
+    {
+        private:
+            struct ringBuffer
+                {
+                    std::int64_t m_capacity = 0;
+                    std::unique_ptr<std::atomic<T>[]> m_items;
+
+                    ringBuffer(std::int64_t capacity) :
+                        m_capacity(capacity),
+                        m_items(std::make_unique<std::atomic<T>[]>(static_cast<std::size_t>(capacity)))
+                        {}
+
+                    T get(std::int64_t index) const { return m_items[index & (m_capacity - 1)].load(std::memory_order_relaxed); }
+                    void put(std::int64_t index, T item) { m_items[index & (m_capacity - 1)].store(item, std::memory_order_relaxed); }
+                };
+
+            static constexpr std::int64_t c_initialCapacity = 256;
+
+            // top and bottom are written by different threads so they live on separate cache lines
+            alignas(64) std::atomic<std::int64_t> m_top = 0;
+            alignas(64) std::atomic<std::int64_t> m_bottom = 0;
+            alignas(64) std::atomic<ringBuffer*> m_buffer = nullptr;
+            std::vector<std::unique_ptr<ringBuffer>> m_buffers;
+
+            ringBuffer *grow(ringBuffer *buffer, std::int64_t top, std::int64_t bottom);
+
+        public:
+            workStealingDeque();
+            workStealingDeque(const workStealingDeque &rhs) = delete;
+            workStealingDeque &operator=(const workStealingDeque &rhs) = delete;
+
+            // Owner only
+            void push(T item);
+            // Owner only. Takes the most recently pushed item
+            bool pop(T &item);
+            // Any thread. Takes the oldest item. Fails spuriously if it races with another thief or the owner for the last item
+            bool steal(T &item);
+
+            bool empty() const;
+            std::size_t size() const;
+
+    };
+
+template<typename T>
+workStealingDeque<T>::workStealingDeque()
+    {
+        m_buffers.push_back(std::make_unique<ringBuffer>(c_initialCapacity));
+        m_buffer.store(m_buffers.back().get(), std::memory_order_relaxed);
+    }
+
+template<typename T>
+typename workStealingDeque<T>::ringBuffer *workStealingDeque<T>::grow(ringBuffer *buffer, std::int64_t top, std::int64_t bottom)
+    {
+        m_buffers.push_back(std::make_unique<ringBuffer>(buffer->m_capacity * 2));
+        ringBuffer *grown = m_buffers.back().get();
+        for (std::int64_t i = top; i < bottom; i++)
+            {
+                grown->put(i, buffer->get(i));
+            }
+        return grown;
+    }
+
+template<typename T>
+void workStealingDeque<T>::push(T item)
+    {
+        const std::int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+        const std::int64_t top = m_top.load(std::memory_order_acquire);
+        ringBuffer *buffer = m_buffer.load(std::memory_order_relaxed);
+        if (bottom - top > buffer->m_capacity - 1)
+            {
+                buffer = grow(buffer, top, bottom);
+                m_buffer.store(buffer, std::memory_order_release);
+            }
+
+        buffer->put(bottom, item);
+        std::atomic_thread_fence(std::memory_order_release);
+        m_bottom.store(bottom + 1, std::memory_order_relaxed);
+    }
+
+template<typename T>
+bool workStealingDeque<T>::pop(T &item)
+    {
+        const std::int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+        ringBuffer *buffer = m_buffer.load(std::memory_order_relaxed);
+        m_bottom.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t top = m_top.load(std::memory_order_relaxed);
+
+        if (top > bottom)
+            {
+                m_bottom.store(bottom + 1, std::memory_order_relaxed);
+                return false;
+            }
+
+        item = buffer->get(bottom);
+        if (top == bottom)
+            {
+                // last item. Whoever moves top first gets it
+                const bool won = m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+                m_bottom.store(bottom + 1, std::memory_order_relaxed);
+                return won;
+            }
+
+        return true;
+    }
+
+template<typename T>
+bool workStealingDeque<T>::steal(T &item)
+    {
+        std::int64_t top = m_top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const std::int64_t bottom = m_bottom.load(std::memory_order_acquire);
+        if (top >= bottom)
+            {
+                return false;
+            }
+
+        ringBuffer *buffer = m_buffer.load(std::memory_order_acquire);
+        T stolen = buffer->get(top);
+        if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            {
+                return false;
+            }
+
+        item = stolen;
+        return true;
+    }
+
+template<typename T>
+bool workStealingDeque<T>::empty() const
+    {
+        return size() == 0;
+    }
+
+template<typename T>
+std::size_t workStealingDeque<T>::size() const
+    {
+        const std::int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+        const std::int64_t top = m_top.load(std::memory_order_relaxed);
+        return bottom > top ? static_cast<std::size_t>(bottom - top) : 0;
+    }
@@ -0,0 +1,119 @@
+#include "graphics/buddyAllocator.hpp"
+#include <assert.h>
+
+bool buddyAllocator::allocation::valid() const
+    {
+        return m_offset != c_invalidOffset;
+    }
+
+unsigned int buddyAllocator::getOrder(uint64_t size) const
+    {
+        unsigned int order = 0;
+        while ((m_minimumSize << order) < size)
+            {
+                order++;
+            }
+
+        return order;
+    }
+
+void buddyAllocator::insertFreeBlock(uint64_t offset, unsigned int order)
+    {
+        // merge with the buddy for as long as it is free as well
+        while (order + 1 < m_freeBlocks.size())
+            {
+                const uint64_t buddy = offset ^ (m_minimumSize << order);
+                auto it = m_freeBlocks[order].find(buddy);
+                if (it == m_freeBlocks[order].end())
+                    {
+                        break;
+                    }
+
+                m_freeBlocks[order].erase(it);
+                offset = offset < buddy ? offset : buddy;
+                order++;
+            }
+
+        m_freeBlocks[order].insert(offset);
+    }
+
+buddyAllocator::buddyAllocator(uint64_t capacity, uint64_t minimumSize)
+    {
+        create(capacity, minimumSize);
+    }
+
+void buddyAllocator::create(uint64_t capacity, uint64_t minimumSize)
+    {
+        m_minimumSize = minimumSize;
+        const unsigned int maxOrder = getOrder(capacity);
+
+        m_freeBlocks.clear();
+        m_freeBlocks.resize(maxOrder + 1);
+        m_freeBlocks[maxOrder].insert(0);
+
+        m_capacity = m_minimumSize << maxOrder;
+        m_used = 0;
+    }
+
+buddyAllocator::allocation buddyAllocator::allocate(uint64_t size)
+    {
+        const unsigned int order = getOrder(size == 0 ? 1 : size);
+
+        unsigned int freeOrder = order;
+        while (freeOrder < m_freeBlocks.size() && m_freeBlocks[freeOrder].empty())
+            {
+                freeOrder++;
+            }
+
+        if (freeOrder >= m_freeBlocks.size())
+            {
+                return {};
+            }
+
+        const uint64_t offset = *m_freeBlocks[freeOrder].begin();
+        m_freeBlocks[freeOrder].erase(m_freeBlocks[freeOrder].begin());
+
+        // split down to the requested order. The upper half of every split stays free
+        while (freeOrder > order)
+            {
+                freeOrder--;
+                m_freeBlocks[freeOrder].insert(offset + (m_minimumSize << freeOrder));
+            }
+
+        allocation allocation;
+        allocation.m_offset = offset;
+        allocation.m_size = m_minimumSize << order;
+        m_used += allocation.m_size;
+        return allocation;
+    }
+
+void buddyAllocator::free(const allocation &allocation)
+    {
+        if (!allocation.valid())
+            {
+                return;
+            }
+
+        assert(m_used >= allocation.m_size);
+        m_used -= allocation.m_size;
+        insertFreeBlock(allocation.m_offset, getOrder(allocation.m_size));
+    }
+
+void buddyAllocator::grow()
+    {
+        // the current range becomes the lower buddy of the new root, so it merges back if everything is freed
+        const unsigned int oldMaxOrder = static_cast<unsigned int>(m_freeBlocks.size() - 1);
+        m_freeBlocks.emplace_back();
+        insertFreeBlock(m_capacity, oldMaxOrder);
+        m_capacity *= 2;
+    }
+
+uint64_t buddyAllocator::getCapacity() const
+    {
+        return m_capacity;
+    }
+
+uint64_t buddyAllocator::getUsed() const
+    {
+        return m_used;
+    }
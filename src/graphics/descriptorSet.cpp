@@ -106,12 +106,12 @@ void descriptorSet::bindUBO(const vulkanBuffer &buffer, VkDeviceSize range, int
         m_needsUpdate = true;
     }
 
-void descriptorSet::bindSBO(const vulkanBuffer &buffer, VkDeviceSize range, int binding)
+void descriptorSet::bindSBO(const vulkanBuffer &buffer, VkDeviceSize range, int binding, VkDeviceSize offset)
     {
         VkDescriptorBufferInfo newInfo{};
 
         newInfo.buffer = buffer;
-        newInfo.offset = 0;
+        newInfo.offset = offset;
         newInfo.range = range;
 
         if (binding >= m_bindings.size())
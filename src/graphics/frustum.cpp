@@ -0,0 +1,134 @@
+#include "graphics/frustum.hpp"
+#include <glm/geometric.hpp>
+#include <optick.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+    #define FRUSTUM_SSE 1
+    #include <emmintrin.h>
+#else
+    #define FRUSTUM_SSE 0
+#endif
+
+void boundingBoxes::clear()
+    {
+        m_minX.clear();
+        m_minY.clear();
+        m_minZ.clear();
+        m_maxX.clear();
+        m_maxY.clear();
+        m_maxZ.clear();
+    }
+
+void boundingBoxes::push(const glm::vec3 &min, const glm::vec3 &max)
+    {
+        m_minX.push_back(min.x);
+        m_minY.push_back(min.y);
+        m_minZ.push_back(min.z);
+        m_maxX.push_back(max.x);
+        m_maxY.push_back(max.y);
+        m_maxZ.push_back(max.z);
+    }
+
+std::size_t boundingBoxes::size() const
+    {
+        return m_minX.size();
+    }
+
+frustum::frustum(const glm::mat4 &viewProjection)
+    {
+        set(viewProjection);
+    }
+
+void frustum::set(const glm::mat4 &viewProjection)
+    {
+        const glm::vec4 row0 = { viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0] };
+        const glm::vec4 row1 = { viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1] };
+        const glm::vec4 row2 = { viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2] };
+        const glm::vec4 row3 = { viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3] };
+
+        m_planes[0] = row3 + row0;
+        m_planes[1] = row3 - row0;
+        m_planes[2] = row3 + row1;
+        m_planes[3] = row3 - row1;
+        // -w <= z holds for both depth conventions, so the near plane is never tighter than the projection
+        m_planes[4] = row3 + row2;
+        m_planes[5] = row3 - row2;
+
+        for (auto &plane : m_planes)
+            {
+                plane /= glm::length(glm::vec3(plane));
+            }
+    }
+
+bool frustum::intersects(const glm::vec3 &min, const glm::vec3 &max) const
+    {
+        for (const auto &plane : m_planes)
+            {
+                // the corner furthest along the normal. If that is behind the plane the whole box is
+                const glm::vec3 corner = {
+                    plane.x >= 0.f ? max.x : min.x,
+                    plane.y >= 0.f ? max.y : min.y,
+                    plane.z >= 0.f ? max.z : min.z
+                };
+
+                if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.f)
+                    {
+                        return false;
+                    }
+            }
+
+        return true;
+    }
+
+void frustum::cull(const boundingBoxes &boxes, std::vector<uint32_t> &visible) const
+    {
+        OPTICK_EVENT();
+        const std::size_t count = boxes.size();
+        std::size_t i = 0;
+
+        #if FRUSTUM_SSE
+            // the furthest corner only depends on the sign of the normal, so each plane picks whole component arrays
+            const float *cornerX[6];
+            const float *cornerY[6];
+            const float *cornerZ[6];
+            for (int p = 0; p < 6; p++)
+                {
+                    cornerX[p] = m_planes[p].x >= 0.f ? boxes.m_maxX.data() : boxes.m_minX.data();
+                    cornerY[p] = m_planes[p].y >= 0.f ? boxes.m_maxY.data() : boxes.m_minY.data();
+                    cornerZ[p] = m_planes[p].z >= 0.f ? boxes.m_maxZ.data() : boxes.m_minZ.data();
+                }
+
+            const __m128 zero = _mm_setzero_ps();
+            for (; i + 4 <= count; i += 4)
+                {
+                    __m128 outside = _mm_setzero_ps();
+                    for (int p = 0; p < 6; p++)
+                        {
+                            __m128 distance = _mm_set1_ps(m_planes[p].w);
+                            distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(m_planes[p].x), _mm_loadu_ps(cornerX[p] + i)));
+                            distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(m_planes[p].y), _mm_loadu_ps(cornerY[p] + i)));
+                            distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(m_planes[p].z), _mm_loadu_ps(cornerZ[p] + i)));
+                            outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, zero));
+                        }
+
+                    const int outsideMask = _mm_movemask_ps(outside);
+                    for (int lane = 0; lane < 4; lane++)
+                        {
+                            if (!(outsideMask & (1 << lane)))
+                                {
+                                    visible.push_back(static_cast<uint32_t>(i + lane));
+                                }
+                        }
+                }
+        #endif
+
+        for (; i < count; i++)
+            {
+                const glm::vec3 min = { boxes.m_minX[i], boxes.m_minY[i], boxes.m_minZ[i] };
+                const glm::vec3 max = { boxes.m_maxX[i], boxes.m_maxY[i], boxes.m_maxZ[i] };
+                if (intersects(min, max))
+                    {
+                        visible.push_back(static_cast<uint32_t>(i));
+                    }
+            }
+    }
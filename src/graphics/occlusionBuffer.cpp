@@ -0,0 +1,208 @@
+#include "graphics/occlusionBuffer.hpp"
+#include <glm/common.hpp>
+#include <optick.h>
+#include <algorithm>
+#include <limits>
+
+// corners of a box ordered by bit: x = bit 0, y = bit 1, z = bit 2
+static constexpr int c_boxTriangles[12][3] = {
+    { 0, 2, 3 }, { 0, 3, 1 },
+    { 4, 5, 7 }, { 4, 7, 6 },
+    { 0, 1, 5 }, { 0, 5, 4 },
+    { 2, 6, 7 }, { 2, 7, 3 },
+    { 0, 4, 6 }, { 0, 6, 2 },
+    { 1, 3, 7 }, { 1, 7, 5 }
+};
+
+bool occlusionBuffer::project(const glm::vec3 &min, const glm::vec3 &max, glm::vec3 corners[8]) const
+    {
+        const glm::vec2 size = m_levelSizes[0];
+        for (int i = 0; i < 8; i++)
+            {
+                const glm::vec4 corner = {
+                    i & 1 ? max.x : min.x,
+                    i & 2 ? max.y : min.y,
+                    i & 4 ? max.z : min.z,
+                    1.f
+                };
+
+                const glm::vec4 clip = m_viewProjection * corner;
+                if (clip.w < c_nearW)
+                    {
+                        return false;
+                    }
+
+                const glm::vec3 ndc = glm::vec3(clip) / clip.w;
+                corners[i] = { (ndc.x * 0.5f + 0.5f) * size.x, (ndc.y * 0.5f + 0.5f) * size.y, ndc.z };
+            }
+
+        return true;
+    }
+
+void occlusionBuffer::rasteriseTriangle(const glm::vec3 &a, const glm::vec3 &b, const glm::vec3 &c)
+    {
+        const float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+        if (area == 0.f)
+            {
+                return;
+            }
+
+        const glm::ivec2 size = m_levelSizes[0];
+        const int minX = std::max(static_cast<int>(std::floor(std::min({ a.x, b.x, c.x }))), 0);
+        const int minY = std::max(static_cast<int>(std::floor(std::min({ a.y, b.y, c.y }))), 0);
+        const int maxX = std::min(static_cast<int>(std::ceil(std::max({ a.x, b.x, c.x }))), size.x - 1);
+        const int maxY = std::min(static_cast<int>(std::ceil(std::max({ a.y, b.y, c.y }))), size.y - 1);
+
+        // both windings are accepted. Every face of the box is drawn, the nearer ones win the depth test
+        const float inverseArea = 1.f / area;
+        std::vector<float> &depth = m_levels[0];
+        for (int y = minY; y <= maxY; y++)
+            {
+                const float sampleY = y + 0.5f;
+                for (int x = minX; x <= maxX; x++)
+                    {
+                        const float sampleX = x + 0.5f;
+                        const float weightA = ((b.x - sampleX) * (c.y - sampleY) - (b.y - sampleY) * (c.x - sampleX)) * inverseArea;
+                        const float weightB = ((c.x - sampleX) * (a.y - sampleY) - (c.y - sampleY) * (a.x - sampleX)) * inverseArea;
+                        const float weightC = 1.f - weightA - weightB;
+                        if (weightA < 0.f || weightB < 0.f || weightC < 0.f)
+                            {
+                                continue;
+                            }
+
+                        float &texel = depth[x + y * size.x];
+                        texel = std::min(texel, weightA * a.z + weightB * b.z + weightC * c.z);
+                    }
+            }
+    }
+
+void occlusionBuffer::create(unsigned int width, unsigned int height)
+    {
+        m_levels.clear();
+        m_levelSizes.clear();
+
+        glm::ivec2 size = { std::max(width, 1u), std::max(height, 1u) };
+        while (true)
+            {
+                m_levelSizes.push_back(size);
+                m_levels.emplace_back(static_cast<std::size_t>(size.x) * size.y, std::numeric_limits<float>::max());
+                if (size.x == 1 && size.y == 1)
+                    {
+                        break;
+                    }
+                size = glm::max((size + 1) / 2, glm::ivec2(1));
+            }
+    }
+
+void occlusionBuffer::clear(const glm::mat4 &viewProjection)
+    {
+        m_viewProjection = viewProjection;
+        for (auto &level : m_levels)
+            {
+                std::fill(level.begin(), level.end(), std::numeric_limits<float>::max());
+            }
+    }
+
+void occlusionBuffer::rasteriseOccluder(const glm::vec3 &min, const glm::vec3 &max)
+    {
+        glm::vec3 corners[8];
+        if (m_levels.empty() || !project(min, max, corners))
+            {
+                return;
+            }
+
+        for (const auto &triangle : c_boxTriangles)
+            {
+                rasteriseTriangle(corners[triangle[0]], corners[triangle[1]], corners[triangle[2]]);
+            }
+    }
+
+void occlusionBuffer::buildPyramid()
+    {
+        OPTICK_EVENT();
+        for (std::size_t level = 1; level < m_levels.size(); level++)
+            {
+                const glm::ivec2 previousSize = m_levelSizes[level - 1];
+                const glm::ivec2 size = m_levelSizes[level];
+                const std::vector<float> &previous = m_levels[level - 1];
+                std::vector<float> &current = m_levels[level];
+
+                for (int y = 0; y < size.y; y++)
+                    {
+                        const int y0 = std::min(y * 2, previousSize.y - 1);
+                        const int y1 = std::min(y * 2 + 1, previousSize.y - 1);
+                        for (int x = 0; x < size.x; x++)
+                            {
+                                const int x0 = std::min(x * 2, previousSize.x - 1);
+                                const int x1 = std::min(x * 2 + 1, previousSize.x - 1);
+                                current[x + y * size.x] = std::max({
+                                    previous[x0 + y0 * previousSize.x], previous[x1 + y0 * previousSize.x],
+                                    previous[x0 + y1 * previousSize.x], previous[x1 + y1 * previousSize.x]
+                                });
+                            }
+                    }
+            }
+    }
+
+bool occlusionBuffer::visible(const glm::vec3 &min, const glm::vec3 &max) const
+    {
+        glm::vec3 corners[8];
+        if (m_levels.empty() || !project(min, max, corners))
+            {
+                return true;
+            }
+
+        glm::vec2 rectMin = glm::vec2(corners[0]);
+        glm::vec2 rectMax = glm::vec2(corners[0]);
+        float nearest = corners[0].z;
+        for (int i = 1; i < 8; i++)
+            {
+                rectMin = glm::min(rectMin, glm::vec2(corners[i]));
+                rectMax = glm::max(rectMax, glm::vec2(corners[i]));
+                nearest = std::min(nearest, corners[i].z);
+            }
+
+        const glm::ivec2 size = m_levelSizes[0];
+        const glm::ivec2 pixelMin = glm::max(glm::ivec2(glm::floor(rectMin)), glm::ivec2(0));
+        const glm::ivec2 pixelMax = glm::min(glm::ivec2(glm::floor(rectMax)), size - 1);
+        if (pixelMin.x > pixelMax.x || pixelMin.y > pixelMax.y)
+            {
+                // off screen. Left to the frustum test
+                return true;
+            }
+
+        // the coarsest level where the rectangle still only touches a couple of texels on each side
+        const int extent = std::max(pixelMax.x - pixelMin.x, pixelMax.y - pixelMin.y);
+        std::size_t level = 0;
+        while ((extent >> level) > 1 && level + 1 < m_levels.size())
+            {
+                level++;
+            }
+
+        const glm::ivec2 levelMin = pixelMin >> static_cast<int>(level);
+        const glm::ivec2 levelMax = pixelMax >> static_cast<int>(level);
+        const glm::ivec2 levelSize = m_levelSizes[level];
+        const std::vector<float> &depth = m_levels[level];
+        for (int y = levelMin.y; y <= levelMax.y; y++)
+            {
+                for (int x = levelMin.x; x <= levelMax.x; x++)
+                    {
+                        if (nearest <= depth[x + y * levelSize.x])
+                            {
+                                return true;
+                            }
+                    }
+            }
+
+        return false;
+    }
+
+glm::ivec2 occlusionBuffer::getSize() const
+    {
+        return m_levelSizes.empty() ? glm::ivec2(0) : m_levelSizes[0];
+    }
+
+const float *occlusionBuffer::getDepth() const
+    {
+        return m_levels.empty() ? nullptr : m_levels[0].data();
+    }
@@ -48,6 +48,14 @@ void renderer::recordSubmissionCommandBuffer(VkCommandBuffer submissionBuffer)
                 m_queuedComputeDispatches.pop();
             }
         
+        // the copies cannot be recorded inside the render pass, so they go ahead of it
+        if (m_voxelSpace)
+            {
+                m_voxelSpace->updateBuffers(submissionBuffer);
+                m_voxelSpace = nullptr;
+                m_voxelDescriptorSet = nullptr;
+            }
+
         vkCmdBeginRenderPass(submissionBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
         vkCmdExecuteCommands(submissionBuffer, 1, &m_commandBuffers[m_frame].m_commandBuffer.getUnderlyingCommandBuffer());
         vkCmdEndRenderPass(submissionBuffer);
@@ -138,6 +146,63 @@ renderer::renderer(window &app, descriptorSettings &settings)
                 multisampling.alphaToCoverageEnable = VK_FALSE;
                 multisampling.alphaToOneEnable = VK_FALSE;
 
+                // the raytraced image is a backdrop. Writing its depth would hide everything rasterised after it
+                depthStencil.depthWriteEnable = VK_FALSE;
+                depthStencil.depthTestEnable = VK_FALSE;
+                depthStencil.depthCompareOp = VK_COMPARE_OP_LESS;
+                depthStencil.depthBoundsTestEnable = VK_FALSE;
+                depthStencil.minDepthBounds = 0.f;
+                depthStencil.maxDepthBounds = 1.f;
+                depthStencil.stencilTestEnable = VK_FALSE;
+                depthStencil.front = {};
+                depthStencil.back = {};
+            });
+
+        shader voxelFrag;
+        shader voxelVert;
+
+        voxelFrag.load(m_device, "shaders/frag.spv");
+        voxelVert.load(m_device, "shaders/voxel_face.spv");
+
+        // matches the bindings of voxel_face.vert
+        descriptorSettings voxelSettings;
+        voxelSettings.addSetting(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT);
+        voxelSettings.addSetting(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT);
+        voxelSettings.addSetting(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT);
+
+        m_voxelSurface.create(m_device, m_swapChain, m_renderPass.getRenderPass(), voxelSettings,
+            [this, &voxelFrag, &voxelVert](std::vector<VkPipelineShaderStageCreateInfo> &shaderStages, VkPipelineVertexInputStateCreateInfo &vertexInputInfo, VkPipelineInputAssemblyStateCreateInfo &inputAssembly, VkPipelineTessellationStateCreateInfo&, VkPipelineMultisampleStateCreateInfo &multisampling, VkPipelineDepthStencilStateCreateInfo &depthStencil, VkPipelineDynamicStateCreateInfo&){
+                VkPipelineShaderStageCreateInfo vertShaderStageInfo{};
+                vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+                vertShaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
+                vertShaderStageInfo.module = voxelVert.getShaderModule();
+                vertShaderStageInfo.pName = voxelVert.getEntryPoint().c_str();
+
+                VkPipelineShaderStageCreateInfo fragShaderStageInfo{};
+                fragShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+                fragShaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+                fragShaderStageInfo.module = voxelFrag.getShaderModule();
+                fragShaderStageInfo.pName = voxelFrag.getEntryPoint().c_str();
+
+                shaderStages.push_back(vertShaderStageInfo);
+                shaderStages.push_back(fragShaderStageInfo);
+
+                // faces are pulled from the storage buffer by gl_VertexIndex, so there are no vertex attributes
+                vertexInputInfo.vertexBindingDescriptionCount = 0;
+                vertexInputInfo.pVertexBindingDescriptions = nullptr;
+                vertexInputInfo.vertexAttributeDescriptionCount = 0;
+                vertexInputInfo.pVertexAttributeDescriptions = nullptr;
+
+                inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+                inputAssembly.primitiveRestartEnable = VK_FALSE;
+
+                multisampling.sampleShadingEnable = VK_FALSE;
+                multisampling.rasterizationSamples = m_physicalDevice.getSampleCount();
+                multisampling.minSampleShading = 0.f;
+                multisampling.pSampleMask = nullptr;
+                multisampling.alphaToCoverageEnable = VK_FALSE;
+                multisampling.alphaToOneEnable = VK_FALSE;
+
                 depthStencil.depthWriteEnable = VK_TRUE;
                 depthStencil.depthTestEnable = VK_TRUE;
                 depthStencil.depthCompareOp = VK_COMPARE_OP_LESS;
@@ -291,6 +356,7 @@ void renderer::cleanup()
             }
 
         m_commandPool.cleanup();
+        m_voxelSurface.cleanup();
         m_surface.cleanup();
         m_renderPass.cleanup();
         m_swapChain.cleanup();
@@ -379,6 +445,13 @@ void renderer::draw(descriptorSet &descriptorSet)
         m_renderables.push_back({ &descriptorSet});
     }
 
+void renderer::drawVoxels(voxelSpace &space, descriptorSet &descriptorSet)
+    {
+        OPTICK_EVENT("Draw Voxels", Optick::Category::Rendering);
+        m_voxelSpace = &space;
+        m_voxelDescriptorSet = &descriptorSet;
+    }
+
 void renderer::preRecording()
     {
         OPTICK_EVENT("Pre-Record", Optick::Category::Rendering);
@@ -398,6 +471,12 @@ void renderer::preRecording()
                     }
             }
 
+        if (m_voxelDescriptorSet && m_voxelDescriptorSet->needsUpdate())
+            {
+                OPTICK_EVENT("Update Voxel Descriptors");
+                m_voxelDescriptorSet->update();
+            }
+
         if (hasUpdate)
             {
                 OPTICK_EVENT("Finish Buffer Recording");
@@ -458,6 +537,13 @@ void renderer::recordCommandBuffer()
                 vkCmdDraw(currentCommandBuffer, 3, 1, 0, 0);
             }
 
+        if (m_voxelSpace)
+            {
+                vkCmdBindPipeline(currentCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_voxelSurface.m_graphicsPipeline);
+                vkCmdBindDescriptorSets(currentCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_voxelSurface.m_pipelineLayout, 0, 1, &m_voxelDescriptorSet->getDescriptorSet(m_frame)->getUnderlyingDescriptorSet(), 0, nullptr);
+                m_voxelSpace->draw(currentCommandBuffer);
+            }
+
         if (m_imGuiEnabled)
             {
                 ImGui_ImplVulkan_RenderDrawData(m_imGuiDrawData, currentCommandBuffer);
@@ -592,6 +678,11 @@ descriptorSet *renderer::createDescriptorSet()
         return m_surface.m_descriptorHandler.createDescriptorSet();
     }
 
+descriptorSet *renderer::createVoxelDescriptorSet()
+    {
+        return m_voxelSurface.m_descriptorHandler.createDescriptorSet();
+    }
+
 descriptorSet *renderer::createComputeDescriptorSet(unsigned int pipeline)
     {
         return m_computePipelines[pipeline].m_computePipeline.m_descriptorHandler.createDescriptorSet();
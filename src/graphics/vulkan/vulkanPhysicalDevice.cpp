@@ -30,7 +30,10 @@ bool vulkanPhysicalDevice::isDeviceSuitable(VkPhysicalDevice device, VkSurfaceKH
         VkPhysicalDeviceFeatures supportedFeatures;
         vkGetPhysicalDeviceFeatures(device, &supportedFeatures);
 
-        return indices.isComplete() && extensionsSupported && swapChainAdequate && supportedFeatures.samplerAnisotropy;
+        // voxelSpace::draw issues every visible sub-chunk from one indirect draw and picks its origin with firstInstance
+        const bool indirectDrawSupported = supportedFeatures.multiDrawIndirect && supportedFeatures.drawIndirectFirstInstance;
+
+        return indices.isComplete() && extensionsSupported && swapChainAdequate && supportedFeatures.samplerAnisotropy && indirectDrawSupported;
     }
 
 bool vulkanPhysicalDevice::checkDeviceExtensionSupport(VkPhysicalDevice device)
@@ -14,6 +14,7 @@
 #include "graphics/window.hpp"
 #include "graphics/renderer.hpp"
 #include "taskGraph.hpp"
+#include "taskScheduler.hpp"
 #include "clock.hpp"
 #include "random.hpp"
 #include <string>
@@ -172,8 +173,9 @@ int main()
         float speed = 250.f;
         constexpr float rotationSpeed = 50.f;
 
-        taskGraph taskGraph(2, 500);
+        taskGraph taskGraph(500);
         voxelSpace space;
+        space.setSaveDirectory("world");
         space.createWorld(&taskGraph);
         mvpCamera.m_model = space.getModelTransformation();
 
@@ -194,6 +196,10 @@ int main()
 
         uniformBuffer lightUBO(light);
 
+        uniformBuffer mvpUBO(mvpCamera);
+        descriptorSet *voxelDescriptors = renderer.createVoxelDescriptorSet();
+        voxelDescriptors->bindUBO(mvpUBO.getUniformBuffer(), mvpUBO.getBufferSize(), 0);
+
         heightmap hm("banff_heightmap/banff_heightmap Height Map (ASTER 30m).png", renderer);
         //heightmap hm("banff_heightmap/test.jpg", renderer);
 
@@ -219,10 +225,17 @@ int main()
 
         fe::clock fpsUpdateClock;
 
+        // the same work runs every frame so it is built once. Recording waits for the cull since it draws the sub-chunks it chose
+        taskGraph::node *cull = taskGraph.addTask(task(&space, &voxelSpace::cull), nullptr, "cull");
+        taskGraph.addTask(task(&renderer, &renderer::recordCommandBuffer), cull, "recordCommandBuffer");
+        taskGraph::compiledGraph frameGraph = taskGraph.compile();
+
         double accumulator = 0.0;
         while (app.isOpen())
             {
                 OPTICK_FRAME("MainThread");
+                // the background budget is per rendered frame, however many fixed steps run in it
+                taskScheduler::get().beginFrame();
                 newTime = updateClock.getTime().asSeconds();
                 frameTime = newTime - currentTime;
                 testGrid.rayIntersects(cameraPos, cameraDir);
@@ -358,6 +371,9 @@ int main()
                 cameraPos.z = posZ;
 
                 ImGui::Text("%f", hm.getHeight(cameraPos));
+                ImGui::Text("Chunks: %zu loaded | %zu requested", space.getLoadedChunkCount(), space.getRequestedChunkCount());
+                ImGui::Text("Sub-chunks: %u visible | %u occluded | %u outside frustum", space.getVisibleSubChunkCount(), space.getOccludedSubChunkCount(), space.getOutsideFrustumSubChunkCount());
+                ImGui::Text("Occluders: %u", space.getOccluderCount());
                 
                 light.m_direction = glm::normalize(light.m_direction);
 
@@ -365,6 +381,12 @@ int main()
 
                 ImGui::End();
 
+                taskGraph.getProfiler().drawImGui("Frame Tasks", "frameTasks.json");
+                if (taskProfiler *streamingProfiler = space.getStreamingProfiler())
+                    {
+                        streamingProfiler->drawImGui("Streaming Tasks", "streamingTasks.json");
+                    }
+
                 if (slid)
                     {
                         lightUBO.bind(light);
@@ -398,12 +420,20 @@ int main()
                             }
                     }*/
 
+                space.update(cameraPos);
+                mvpCamera.m_view = glm::lookAt(cameraPos, cameraPos + cameraDir, glm::vec3(0.f, -1.f, 0.f));
+                mvpUBO.bind(mvpCamera);
+                space.setCamera(mvpCamera.m_projection * mvpCamera.m_view, cameraPos);
+
                 raytracer.dispatch();
                 raytracer.draw(true);
+                if (space.bindDescriptors(*voxelDescriptors))
+                    {
+                        renderer.drawVoxels(space, *voxelDescriptors);
+                    }
 
                 renderer.preRecording();
-                renderer.recordCommandBuffer();
-                taskGraph.execute();
+                taskGraph.execute(frameGraph, taskPriority::FRAME_CRITICAL);
 
                 renderer.display();
             }
@@ -412,8 +442,6 @@ int main()
 
         renderer.deinitImGui();
 
-        taskGraph.stop();
-
         //voxelStorageBuffer.destroy();
         //sphereBuffer.destroy();
         viewUBO.destroy();
@@ -425,7 +453,9 @@ int main()
         hm.destroy();
 
         space.destroy();
-        //mvpUBO.destroy();
+        // nothing is submitted past this point
+        taskScheduler::get().stop();
+        mvpUBO.destroy();
 
         renderer.cleanup();
         app.cleanup();
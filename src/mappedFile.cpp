@@ -0,0 +1,185 @@
+#include "mappedFile.hpp"
+
+#if defined(_WIN32)
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <Windows.h>
+#else
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
+
+mappedFile::~mappedFile()
+    {
+        close();
+    }
+
+bool mappedFile::open(const char *file)
+    {
+        close();
+
+        #if defined(_WIN32)
+            m_file = CreateFileA(file, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (m_file == INVALID_HANDLE_VALUE)
+                {
+                    m_file = nullptr;
+                    return false;
+                }
+        #else
+            m_file = ::open(file, O_RDWR | O_CREAT, 0644);
+            if (m_file < 0)
+                {
+                    return false;
+                }
+        #endif
+
+        return true;
+    }
+
+void mappedFile::close()
+    {
+        unmap();
+
+        #if defined(_WIN32)
+            if (m_file)
+                {
+                    CloseHandle(m_file);
+                    m_file = nullptr;
+                }
+        #else
+            if (m_file >= 0)
+                {
+                    ::close(m_file);
+                    m_file = -1;
+                }
+        #endif
+    }
+
+bool mappedFile::isOpen() const
+    {
+        #if defined(_WIN32)
+            return m_file != nullptr;
+        #else
+            return m_file >= 0;
+        #endif
+    }
+
+bool mappedFile::map()
+    {
+        unmap();
+        m_size = static_cast<std::size_t>(getFileSize());
+        if (m_size == 0)
+            {
+                return false;
+            }
+
+        #if defined(_WIN32)
+            m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (!m_mapping)
+                {
+                    m_size = 0;
+                    return false;
+                }
+            m_data = static_cast<const uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+        #else
+            void *data = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, m_file, 0);
+            m_data = data == MAP_FAILED ? nullptr : static_cast<const uint8_t*>(data);
+        #endif
+
+        if (!m_data)
+            {
+                unmap();
+                return false;
+            }
+
+        return true;
+    }
+
+void mappedFile::unmap()
+    {
+        #if defined(_WIN32)
+            if (m_data)
+                {
+                    UnmapViewOfFile(m_data);
+                }
+            if (m_mapping)
+                {
+                    CloseHandle(m_mapping);
+                    m_mapping = nullptr;
+                }
+        #else
+            if (m_data)
+                {
+                    munmap(const_cast<uint8_t*>(m_data), m_size);
+                }
+        #endif
+
+        m_data = nullptr;
+        m_size = 0;
+    }
+
+bool mappedFile::isMapped() const
+    {
+        return m_data != nullptr;
+    }
+
+bool mappedFile::readAt(uint64_t offset, void *data, std::size_t size) const
+    {
+        #if defined(_WIN32)
+            OVERLAPPED overlapped{};
+            overlapped.Offset = static_cast<DWORD>(offset);
+            overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+            DWORD read = 0;
+            return ReadFile(m_file, data, static_cast<DWORD>(size), &read, &overlapped) && read == size;
+        #else
+            return pread(m_file, data, size, static_cast<off_t>(offset)) == static_cast<ssize_t>(size);
+        #endif
+    }
+
+bool mappedFile::writeAt(uint64_t offset, const void *data, std::size_t size)
+    {
+        #if defined(_WIN32)
+            LARGE_INTEGER position;
+            position.QuadPart = static_cast<LONGLONG>(offset);
+            DWORD written = 0;
+            return SetFilePointerEx(m_file, position, nullptr, FILE_BEGIN) && WriteFile(m_file, data, static_cast<DWORD>(size), &written, nullptr) && written == size;
+        #else
+            return pwrite(m_file, data, size, static_cast<off_t>(offset)) == static_cast<ssize_t>(size);
+        #endif
+    }
+
+bool mappedFile::resize(uint64_t size)
+    {
+        unmap();
+
+        #if defined(_WIN32)
+            LARGE_INTEGER position;
+            position.QuadPart = static_cast<LONGLONG>(size);
+            return SetFilePointerEx(m_file, position, nullptr, FILE_BEGIN) && SetEndOfFile(m_file);
+        #else
+            return ftruncate(m_file, static_cast<off_t>(size)) == 0;
+        #endif
+    }
+
+uint64_t mappedFile::getFileSize() const
+    {
+        #if defined(_WIN32)
+            LARGE_INTEGER size;
+            return GetFileSizeEx(m_file, &size) ? static_cast<uint64_t>(size.QuadPart) : 0;
+        #else
+            struct stat status;
+            return fstat(m_file, &status) == 0 ? static_cast<uint64_t>(status.st_size) : 0;
+        #endif
+    }
+
+const uint8_t *mappedFile::getData() const
+    {
+        return m_data;
+    }
+
+std::size_t mappedFile::getMappedSize() const
+    {
+        return m_size;
+    }
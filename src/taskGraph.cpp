@@ -1,27 +1,29 @@
 #include "taskGraph.hpp"
+#include "taskScheduler.hpp"
 #include <assert.h>
 
-void taskGraph::initThreadPool(unsigned int threadCount)
-    {
-        assert(!m_executing);
-        m_threadPool.resize(threadCount);
-    }
-
 void taskGraph::initNodePool(unsigned int expectedNodeCount)
     {
-        assert(!m_executing);
+        assert(done());
 
+        // sized up front so a graph that stays within the expected count never allocates while it is being built
         m_nodePool.resize(expectedNodeCount);
+        m_nodePoolFreeIndices.reserve(expectedNodeCount);
+        m_roots.reserve(expectedNodeCount);
         for (unsigned int i = 0; i < expectedNodeCount; i++)
             {
                 m_nodePool[i] = std::make_unique<node>();
-                m_nodePoolFreeIndices.push(i);
+            }
+        // used as a stack, pushed in reverse so nodes are handed out in pool order
+        for (unsigned int i = expectedNodeCount; i > 0; i--)
+            {
+                m_nodePoolFreeIndices.push_back(i - 1);
             }
     }
 
 std::size_t taskGraph::createNode(task task)
     {
-        assert(!m_executing);
+        assert(done());
 
         if (m_nodePoolFreeIndices.empty())
             {
@@ -31,54 +33,75 @@ std::size_t taskGraph::createNode(task task)
                 for (std::size_t i = oldSize; i < newSize; i++)
                     {
                         m_nodePool[i] = std::make_unique<node>();
-                        m_nodePoolFreeIndices.push(i);
+                    }
+                for (std::size_t i = newSize; i > oldSize; i--)
+                    {
+                        m_nodePoolFreeIndices.push_back(i - 1);
                     }
             }
 
-        std::size_t index = m_nodePoolFreeIndices.front();
-        m_nodePoolFreeIndices.pop();
-        m_nodePool[index]->m_task = task;
+        std::size_t index = m_nodePoolFreeIndices.back();
+        m_nodePoolFreeIndices.pop_back();
+        m_nodePool[index]->m_task = std::move(task);
         m_nodePool[index]->m_doneExecution = false;
         m_nodePool[index]->m_inUse = true;
-        m_nodePool[index]->m_parentsDone = 0;
-        m_nodePool[index]->m_queued = false;
-        m_nodePool[index]->m_args = std::make_unique<nodeArgsBase>();
+        m_nodePool[index]->m_pendingParents = 0;
+        m_nodePool[index]->m_rootIndex = m_roots.size();
+        m_nodePool[index]->m_state = &m_executionState;
+        m_roots.push_back(m_nodePool[index].get());
+        m_nodeCount++;
         return index;
     }
 
-taskGraph::taskGraph(unsigned int expectedNodeCount)
+void taskGraph::addEdge(node *parent, node *child)
     {
-        initThreadPool(c_DEFAULT_THREAD_COUNT);
-        initNodePool(expectedNodeCount);
+        assert(done());
+        parent->m_children.push_back(child);
+        parent->m_childList = parent->m_children.data();
+        parent->m_childCount++;
+        child->m_parents.push_back(parent);
+        child->m_parentCount++;
+        child->m_pendingParents++;
+
+        if (child->m_rootIndex != c_notRoot)
+            {
+                // swap with the last root so removal stays constant time
+                node *last = m_roots.back();
+                m_roots[child->m_rootIndex] = last;
+                last->m_rootIndex = child->m_rootIndex;
+                m_roots.pop_back();
+                child->m_rootIndex = c_notRoot;
+            }
     }
 
-taskGraph::taskGraph(unsigned int threadCount, unsigned int expectedNodeCount)
+taskGraph::taskGraph(unsigned int expectedNodeCount)
     {
-        initThreadPool(threadCount);
         initNodePool(expectedNodeCount);
     }
 
 taskGraph::~taskGraph()
     {
-        stop();
+        // workers hold pointers into the node pool
+        assert(done());
     }
 
-taskGraph::node *taskGraph::addTask(task task, taskGraph::node *required)
+taskGraph::node *taskGraph::addTask(task task, taskGraph::node *required, const char *label)
     {
-        std::size_t index = createNode(task);
+        std::size_t index = createNode(std::move(task));
+        m_nodePool[index]->m_label = label;
 
         if (required)
             {
-                m_nodePool[index]->m_parents.push_back(required);
-                required->m_children.push_back(m_nodePool[index].get());
+                addEdge(required, m_nodePool[index].get());
             }
 
         return m_nodePool[index].get();
     }
 
-taskGraph::node *taskGraph::addTask(task task, std::initializer_list<taskGraph::node*> parents, std::initializer_list<taskGraph::node*> children)
+taskGraph::node *taskGraph::addTask(task task, std::initializer_list<taskGraph::node*> parents, std::initializer_list<taskGraph::node*> children, const char *label)
     {
-        std::size_t index = createNode(task);
+        std::size_t index = createNode(std::move(task));
+        m_nodePool[index]->m_label = label;
 
         addChildren(m_nodePool[index].get(), children);
         addParents(m_nodePool[index].get(), parents);
@@ -90,8 +113,7 @@ void taskGraph::addParents(taskGraph::node *base, std::initializer_list<taskGrap
     {
         for (const auto &parent : parents)
             {
-                parent->m_children.push_back(base);
-                base->m_parents.push_back(parent);
+                addEdge(parent, base);
             }
     }
 
@@ -99,8 +121,7 @@ void taskGraph::addChildren(taskGraph::node *base, std::initializer_list<taskGra
     {
         for (const auto &child : children)
             {
-                base->m_children.push_back(child);
-                child->m_parents.push_back(base);
+                addEdge(base, child);
             }
     }
 
@@ -108,128 +129,139 @@ void taskGraph::clear()
     {
         assert(done());
 
-        while (!m_nodePoolFreeIndices.empty())
+        m_nodePoolFreeIndices.clear();
+        for (std::size_t i = m_nodePool.size(); i > 0; i--)
             {
-                m_nodePoolFreeIndices.pop();
+                m_nodePoolFreeIndices.push_back(i - 1);
             }
 
         for (std::size_t i = 0; i < m_nodePool.size(); i++)
             {
-                m_nodePoolFreeIndices.push(i);
-
+                // drops whatever the task captured now rather than when the node is next reused
+                m_nodePool[i]->m_task = task();
                 m_nodePool[i]->m_doneExecution = false;
                 m_nodePool[i]->m_inUse = false;
-                m_nodePool[i]->m_parentsDone = 0;
-                m_nodePool[i]->m_queued = false;
+                m_nodePool[i]->m_pendingParents = 0;
+                m_nodePool[i]->m_rootIndex = c_notRoot;
+                m_nodePool[i]->m_childList = nullptr;
+                m_nodePool[i]->m_childCount = 0;
+                m_nodePool[i]->m_parentCount = 0;
+                m_nodePool[i]->m_label = nullptr;
+                m_nodePool[i]->m_parents.clear();
+                m_nodePool[i]->m_children.clear();
             }
 
-        m_enqueuedNodes.clear();
-        m_executing = false;
+        m_roots.clear();
+        m_nodeCount = 0;
     }
 
-void taskGraph::start(unsigned int threadCount)
+taskGraph::compiledGraph taskGraph::compile()
     {
-        initThreadPool(threadCount);
-    }
+        assert(done());
 
-void taskGraph::execute()
-    {
-        m_executing = true;
-        for (auto &node : m_nodePool)
+        compiledGraph compiled;
+        compiled.m_state = std::make_unique<executionState>();
+        std::size_t edgeCount = 0;
+        for (auto &poolNode : m_nodePool)
             {
-                if (node->m_inUse && node->m_parents.size() == 0)
+                if (poolNode->m_inUse)
                     {
-                        m_enqueuedNodes.push_back(node.get());
+                        // m_rootIndex is reused as the node's slot in the compiled array. clear() resets it below
+                        poolNode->m_rootIndex = compiled.m_nodes.size();
+                        compiled.m_nodes.emplace_back();
+                        edgeCount += poolNode->m_childCount;
                     }
             }
-        std::vector<node*> nextQueue;
-        std::vector<std::size_t> doneNodes;
 
-        while (!m_enqueuedNodes.empty())
+        // sized once so the child pointers handed out below stay valid
+        compiled.m_childList.reserve(edgeCount);
+        for (auto &poolNode : m_nodePool)
             {
-                std::size_t i = 0;
-                for (auto &enqueuedNode : m_enqueuedNodes)
+                if (!poolNode->m_inUse)
                     {
-                        if (enqueuedNode->m_parentsDone >= enqueuedNode->m_parents.size())
-                            {
-                                std::size_t best = m_threadPool[0].m_enqueuedNodes.size();
-                                executionHandler *bestHandler = &m_threadPool[0];
-                                for (std::size_t j = 1; j < m_threadPool.size(); j++)
-                                    {
-                                        if (m_threadPool[j].m_enqueuedNodes.size() < best)
-                                            {
-                                                best = m_threadPool[j].m_enqueuedNodes.size();
-                                                bestHandler = &m_threadPool[j];
-                                            }
-                                    }
-
-                                bestHandler->m_queueMutex.lock();
-                                bestHandler->m_enqueuedNodes.push(enqueuedNode);
-                                bestHandler->m_queueMutex.unlock();
-
-                                nextQueue.insert(nextQueue.end(), enqueuedNode->m_children.begin(), enqueuedNode->m_children.end());
-                                doneNodes.push_back(i);
-                            }
-                        i++;
+                        continue;
                     }
 
-                if (!doneNodes.empty())
+                node &compiledNode = compiled.m_nodes[poolNode->m_rootIndex];
+                compiledNode.m_task = std::move(poolNode->m_task);
+                compiledNode.m_inUse = true;
+                compiledNode.m_state = compiled.m_state.get();
+                compiledNode.m_label = poolNode->m_label;
+                compiledNode.m_parentCount = poolNode->m_parentCount;
+                compiledNode.m_pendingParents = poolNode->m_parentCount;
+                compiledNode.m_childCount = poolNode->m_childCount;
+                compiledNode.m_childList = compiled.m_childList.data() + compiled.m_childList.size();
+                for (std::uint32_t i = 0; i < poolNode->m_childCount; i++)
                     {
-                        for (auto it = doneNodes.rbegin(); it != doneNodes.rend(); ++it)
-                            {
-                                m_enqueuedNodes.erase(m_enqueuedNodes.begin() + *it);
-                            }
-                        doneNodes.clear();
+                        compiled.m_childList.push_back(&compiled.m_nodes[poolNode->m_childList[i]->m_rootIndex]);
                     }
 
-                if (!nextQueue.empty())
+                if (poolNode->m_parentCount == 0)
                     {
-                        for (auto &next : nextQueue)
-                            {
-                                if (!next->m_queued)
-                                    {
-                                        m_enqueuedNodes.emplace_back(std::move(next));
-                                        next->m_queued = true;
-                                    }
-                            }
-                        nextQueue.clear();
+                        compiled.m_roots.push_back(&compiledNode);
                     }
             }
 
-        bool isProcessing = true;
-        while (isProcessing)
+        clear();
+        return compiled;
+    }
+
+taskGraph::executionHandle taskGraph::submit(taskPriority priority)
+    {
+        assert(done());
+        inject(m_roots.data(), m_roots.size(), m_nodeCount, m_executionState, priority);
+        return executionHandle(&m_executionState);
+    }
+
+taskGraph::executionHandle taskGraph::submit(compiledGraph &graph, taskPriority priority)
+    {
+        if (graph.empty())
             {
-                isProcessing = false;
-                for (auto &executor : m_threadPool)
-                    {
-                        if (executor.m_isProcessing || !executor.m_enqueuedNodes.empty())
-                            {
-                                isProcessing = true;
-                                break;
-                            }
-                    }
+                return executionHandle();
             }
 
-        m_executing = false;
+        assert(graph.m_state->m_remainingNodes.load() == 0);
+        inject(graph.m_roots.data(), graph.m_roots.size(), graph.m_nodes.size(), *graph.m_state, priority);
+        return executionHandle(graph.m_state.get());
     }
 
-bool taskGraph::done() const
+void taskGraph::execute(taskPriority priority)
     {
-        return !m_executing;
+        submit(priority).wait();
     }
 
-void taskGraph::stop()
+void taskGraph::execute(compiledGraph &graph, taskPriority priority)
     {
-        for (auto &thread : m_threadPool)
-            {
-                thread.m_running = false;
-            }
-        for (auto &thread : m_threadPool)
+        submit(graph, priority).wait();
+    }
+
+void taskGraph::inject(node *const *roots, std::size_t rootCount, std::size_t nodeCount, executionState &state, taskPriority priority)
+    {
+        state.m_remainingNodes.store(nodeCount == 0 ? 0 : nodeCount + 1, std::memory_order_relaxed);
+        state.m_priority = priority;
+        state.m_profiler = &m_profiler;
+        state.m_submission = m_submissionCount.fetch_add(1, std::memory_order_relaxed) + 1;
+        if (m_profiler.isEnabled())
             {
-                thread.m_thread.join();
+                const std::int64_t time = taskProfiler::now();
+                for (std::size_t i = 0; i < rootCount; i++)
+                    {
+                        roots[i]->m_readyParent = nullptr;
+                        roots[i]->m_queuedTime = time;
+                    }
             }
-        m_threadPool.clear();
-        m_executing = false;
+
+        taskScheduler::get().inject(roots, rootCount, priority);
+    }
+
+taskProfiler &taskGraph::getProfiler()
+    {
+        return m_profiler;
+    }
+
+bool taskGraph::done() const
+    {
+        return m_executionState.m_remainingNodes.load(std::memory_order_acquire) == 0;
     }
 
 taskGraph &taskGraph::operator=(taskGraph &rhs)
@@ -242,63 +274,31 @@ taskGraph &taskGraph::operator=(taskGraph &rhs)
         m_nodePool.clear();
         for (auto &node : rhs.m_nodePool)
             {
+                node->m_state = &m_executionState;
                 m_nodePool.emplace_back(node.release());
             }
         m_nodePoolFreeIndices = rhs.m_nodePoolFreeIndices;
-        m_enqueuedNodes = rhs.m_enqueuedNodes;
-        m_threadPool = rhs.m_threadPool;
-        m_executing = rhs.m_executing;
+        m_roots = std::move(rhs.m_roots);
+        m_nodeCount = rhs.m_nodeCount;
+        rhs.m_nodeCount = 0;
 
         return *this;
     }
 
-taskGraph::executionHandler::executionHandler()
-    {
-        m_running = true;
-        m_thread = std::thread(&taskGraph::executionHandler::executionLoop, this);
-    }
-
-taskGraph::executionHandler::executionHandler(const executionHandler &rhs)
+taskGraph::executionHandle::executionHandle(executionState *state) :
+    m_state(state)
     {
-        *this = rhs;
     }
 
-void taskGraph::executionHandler::executionLoop()
+bool taskGraph::executionHandle::done() const
     {
-        while (m_running)
-            {
-                if (m_enqueuedNodes.empty())
-                    {
-                        m_isProcessing = false;
-                        std::this_thread::yield();
-                    }
-                else
-                    {
-                        m_isProcessing = true;
-
-                        m_queueMutex.lock();
-                        taskGraph::node *front = m_enqueuedNodes.front();
-                        m_queueMutex.unlock();
-
-                        front->execute();
-
-                        m_queueMutex.lock();
-                        m_enqueuedNodes.pop();
-                        m_queueMutex.unlock();
-                    }
-            }
+        return !m_state || m_state->m_remainingNodes.load(std::memory_order_acquire) == 0;
     }
 
-taskGraph::executionHandler &taskGraph::executionHandler::operator=(const executionHandler &rhs)
+void taskGraph::executionHandle::wait()
     {
-        if (this == &rhs)
+        if (m_state)
             {
-                return *this;
+                taskScheduler::get().help(*m_state);
             }
-
-        m_enqueuedNodes = rhs.m_enqueuedNodes;
-        m_running = rhs.m_running;
-        m_thread = std::thread(&taskGraph::executionHandler::executionLoop, this);
-
-        return *this;
     }
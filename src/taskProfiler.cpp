@@ -0,0 +1,353 @@
+#include "taskProfiler.hpp"
+#include <chrono>
+#include <cstring>
+#include <type_traits>
+#include <fstream>
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+#include <string_view>
+#include "imgui.h"
+#include <optick.h>
+
+namespace
+    {
+        static_assert(std::is_trivially_copyable_v<taskProfiler::event>, "events are copied through atomic words");
+
+        const char *getLabel(const taskProfiler::event &event)
+            {
+                return event.m_label ? event.m_label : "unlabelled";
+            }
+
+        double toMilliseconds(std::int64_t nanoseconds)
+            {
+                return static_cast<double>(nanoseconds) / 1'000'000.0;
+            }
+    }
+
+taskProfiler::~taskProfiler()
+    {
+        for (auto &ring : m_rings)
+            {
+                delete ring.load(std::memory_order_acquire);
+            }
+    }
+
+taskProfiler::ringBuffer &taskProfiler::getRing(std::uint32_t thread)
+    {
+        // the scheduler may have been restarted with more workers, so thread indices are not known up front
+        std::atomic<ringBuffer*> &entry = m_rings[std::min<std::size_t>(thread, c_maxRings - 1)];
+        ringBuffer *ring = entry.load(std::memory_order_acquire);
+        if (!ring)
+            {
+                std::unique_ptr<ringBuffer> created = std::make_unique<ringBuffer>();
+                created->m_slots = std::make_unique<slot[]>(c_ringCapacity);
+                // another thread sharing the index may get there first, in which case its ring is used
+                if (entry.compare_exchange_strong(ring, created.get(), std::memory_order_acq_rel, std::memory_order_acquire))
+                    {
+                        ring = created.release();
+                    }
+            }
+        return *ring;
+    }
+
+void taskProfiler::setEnabled(bool enabled)
+    {
+        m_enabled.store(enabled, std::memory_order_release);
+    }
+
+bool taskProfiler::isEnabled() const
+    {
+        return m_enabled.load(std::memory_order_acquire);
+    }
+
+void taskProfiler::record(std::uint32_t thread, const event &event)
+    {
+        ringBuffer &ring = getRing(thread);
+        // only the helper ring has more than one writer, the reservation is uncontended for workers
+        const std::uint64_t index = ring.m_head.fetch_add(1, std::memory_order_relaxed);
+        slot &slot = ring.m_slots[index & (c_ringCapacity - 1)];
+        slot.m_sequence.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::uint64_t words[c_eventWords] = {};
+        std::memcpy(words, &event, sizeof(event));
+        for (std::size_t i = 0; i < c_eventWords; i++)
+            {
+                slot.m_event[i].store(words[i], std::memory_order_relaxed);
+            }
+        slot.m_sequence.store(index + 1, std::memory_order_release);
+    }
+
+void taskProfiler::collect()
+    {
+        OPTICK_EVENT();
+        for (auto &entry : m_rings)
+            {
+                ringBuffer *ring = entry.load(std::memory_order_acquire);
+                if (!ring)
+                    {
+                        continue;
+                    }
+
+                const std::uint64_t head = ring->m_head.load(std::memory_order_acquire);
+                // anything more than a ring behind has been overwritten
+                std::uint64_t index = std::max(ring->m_readIndex, head > c_ringCapacity ? head - c_ringCapacity : 0);
+                for (; index < head; index++)
+                    {
+                        slot &slot = ring->m_slots[index & (c_ringCapacity - 1)];
+                        if (slot.m_sequence.load(std::memory_order_acquire) != index + 1)
+                            {
+                                // still being written. Picked up by the next collect
+                                break;
+                            }
+
+                        std::uint64_t words[c_eventWords];
+                        for (std::size_t i = 0; i < c_eventWords; i++)
+                            {
+                                words[i] = slot.m_event[i].load(std::memory_order_relaxed);
+                            }
+                        std::atomic_thread_fence(std::memory_order_acquire);
+                        if (slot.m_sequence.load(std::memory_order_relaxed) == index + 1)
+                            {
+                                event &event = m_events.emplace_back();
+                                std::memcpy(&event, words, sizeof(event));
+                            }
+                    }
+                ring->m_readIndex = index;
+            }
+
+        if (m_events.size() > c_maxCollectedEvents)
+            {
+                m_events.erase(m_events.begin(), m_events.end() - c_maxCollectedEvents);
+            }
+    }
+
+void taskProfiler::reset()
+    {
+        collect();
+        m_events.clear();
+        m_latestSubmission = {};
+        m_window = {};
+    }
+
+const std::vector<taskProfiler::event> &taskProfiler::getEvents() const
+    {
+        return m_events;
+    }
+
+std::int64_t taskProfiler::now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+taskProfiler::summary taskProfiler::summarise(const std::vector<event> &events)
+    {
+        OPTICK_EVENT();
+        summary summary;
+        if (events.empty())
+            {
+                return summary;
+            }
+
+        std::int64_t firstTime = events.front().m_startTime;
+        std::int64_t lastTime = events.front().m_endTime;
+        std::int64_t busyTime = 0;
+        std::int64_t totalQueueWait = 0;
+        std::int64_t maxQueueWait = 0;
+        std::size_t lastEvent = 0;
+        std::unordered_set<std::uint32_t> threads;
+        std::unordered_map<const void*, std::vector<std::size_t>> nodeEvents;
+        std::unordered_map<std::string_view, stage> stages;
+        for (std::size_t i = 0; i < events.size(); i++)
+            {
+                const event &event = events[i];
+                // nodes made ready before recording was enabled have no queue time
+                const std::int64_t queuedTime = (event.m_queuedTime > 0 && event.m_queuedTime <= event.m_startTime) ? event.m_queuedTime : event.m_startTime;
+                const std::int64_t duration = event.m_endTime - event.m_startTime;
+
+                firstTime = std::min(firstTime, queuedTime);
+                lastTime = std::max(lastTime, event.m_endTime);
+                busyTime += duration;
+                totalQueueWait += event.m_startTime - queuedTime;
+                maxQueueWait = std::max(maxQueueWait, event.m_startTime - queuedTime);
+                threads.insert(event.m_thread);
+                nodeEvents[event.m_node].push_back(i);
+                if (event.m_endTime > events[lastEvent].m_endTime)
+                    {
+                        lastEvent = i;
+                    }
+
+                stage &stage = stages[getLabel(event)];
+                stage.m_label = getLabel(event);
+                stage.m_count++;
+                stage.m_totalTime += toMilliseconds(duration);
+                stage.m_maxTime = std::max(stage.m_maxTime, toMilliseconds(duration));
+            }
+
+        summary.m_taskCount = events.size();
+        summary.m_threadCount = static_cast<unsigned int>(threads.size());
+        summary.m_wallTime = toMilliseconds(lastTime - firstTime);
+        summary.m_busyTime = toMilliseconds(busyTime);
+        summary.m_parallelEfficiency = lastTime > firstTime ? static_cast<double>(busyTime) / (static_cast<double>(lastTime - firstTime) * threads.size()) : 1.0;
+        summary.m_averageQueueWait = toMilliseconds(totalQueueWait) / events.size();
+        summary.m_maxQueueWait = toMilliseconds(maxQueueWait);
+
+        // a node re-run by a compiled graph has an event per run, so take the run of the parent that ended last before this one started
+        std::size_t current = lastEvent;
+        while (true)
+            {
+                const event &event = events[current];
+                summary.m_criticalPathTime += toMilliseconds(event.m_endTime - event.m_startTime);
+                summary.m_criticalPath.push_back(getLabel(event));
+
+                auto parent = nodeEvents.find(event.m_readyParent);
+                if (!event.m_readyParent || parent == nodeEvents.end())
+                    {
+                        break;
+                    }
+
+                std::size_t next = events.size();
+                for (const auto &candidate : parent->second)
+                    {
+                        const taskProfiler::event &parentEvent = events[candidate];
+                        if (parentEvent.m_submission == event.m_submission && parentEvent.m_endTime <= event.m_startTime &&
+                            (next == events.size() || parentEvent.m_endTime > events[next].m_endTime))
+                            {
+                                next = candidate;
+                            }
+                    }
+
+                if (next == events.size())
+                    {
+                        break;
+                    }
+                current = next;
+            }
+        std::reverse(summary.m_criticalPath.begin(), summary.m_criticalPath.end());
+
+        for (const auto &stage : stages)
+            {
+                summary.m_stages.push_back(stage.second);
+            }
+        std::sort(summary.m_stages.begin(), summary.m_stages.end(), [] (const stage &lhs, const stage &rhs) {
+            return lhs.m_totalTime > rhs.m_totalTime;
+        });
+
+        return summary;
+    }
+
+bool taskProfiler::writeChromeTrace(const char *file, const std::vector<event> &events)
+    {
+        OPTICK_EVENT();
+        std::ofstream out(file);
+        if (!out)
+            {
+                return false;
+            }
+
+        std::int64_t firstTime = events.empty() ? 0 : events.front().m_startTime;
+        std::unordered_set<std::uint32_t> threads;
+        for (const auto &event : events)
+            {
+                firstTime = std::min(firstTime, event.m_startTime);
+                threads.insert(event.m_thread);
+            }
+
+        // chrome://tracing and Perfetto both read the JSON array format. Timestamps are microseconds
+        out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        bool first = true;
+        for (const auto &thread : threads)
+            {
+                out << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << thread << ",\"args\":{\"name\":\"thread " << thread << "\"}}";
+                first = false;
+            }
+
+        out.setf(std::ios::fixed);
+        out.precision(3);
+        for (const auto &event : events)
+            {
+                out << (first ? "" : ",") << "\n{\"name\":\"";
+                for (const char *c = getLabel(event); *c; c++)
+                    {
+                        if (*c == '"' || *c == '\\')
+                            {
+                                out << '\\';
+                            }
+                        out << *c;
+                    }
+
+                const std::int64_t queuedTime = (event.m_queuedTime > 0 && event.m_queuedTime <= event.m_startTime) ? event.m_queuedTime : event.m_startTime;
+                out << "\",\"cat\":\"task\",\"ph\":\"X\",\"pid\":0,\"tid\":" << event.m_thread
+                    << ",\"ts\":" << (event.m_startTime - firstTime) / 1000.0
+                    << ",\"dur\":" << (event.m_endTime - event.m_startTime) / 1000.0
+                    << ",\"args\":{\"submission\":" << event.m_submission << ",\"queueWaitUs\":" << (event.m_startTime - queuedTime) / 1000.0 << "}}";
+                first = false;
+            }
+        out << "\n]}\n";
+
+        return static_cast<bool>(out);
+    }
+
+void taskProfiler::drawImGui(const char *name, const char *traceFile)
+    {
+        OPTICK_EVENT();
+        ImGui::Begin(name);
+
+        bool enabled = isEnabled();
+        if (ImGui::Checkbox("Record", &enabled))
+            {
+                setEnabled(enabled);
+            }
+
+        collect();
+        const std::int64_t time = now();
+        if (time - m_lastSummaryTime >= c_summaryInterval && !m_events.empty())
+            {
+                m_lastSummaryTime = time;
+                auto last = std::max_element(m_events.begin(), m_events.end(), [] (const event &lhs, const event &rhs) {
+                    return lhs.m_endTime < rhs.m_endTime;
+                });
+
+                std::vector<event> latest;
+                std::copy_if(m_events.begin(), m_events.end(), std::back_inserter(latest), [submission = last->m_submission] (const event &event) {
+                    return event.m_submission == submission;
+                });
+                m_latestSubmission = summarise(latest);
+                m_window = summarise(m_events);
+            }
+
+        ImGui::Text("Latest submission: %zu tasks on %u threads", m_latestSubmission.m_taskCount, m_latestSubmission.m_threadCount);
+        ImGui::Text("Wall %.3f ms | busy %.3f ms | efficiency %.0f%%", m_latestSubmission.m_wallTime, m_latestSubmission.m_busyTime, m_latestSubmission.m_parallelEfficiency * 100.0);
+        ImGui::Text("Queue wait: %.3f ms average | %.3f ms max", m_latestSubmission.m_averageQueueWait, m_latestSubmission.m_maxQueueWait);
+        ImGui::Text("Critical path: %.3f ms over %zu tasks", m_latestSubmission.m_criticalPathTime, m_latestSubmission.m_criticalPath.size());
+        // long chains are cut short, the trace has all of it
+        constexpr std::size_t maxPathLength = 16;
+        for (std::size_t i = 0; i < std::min(maxPathLength, m_latestSubmission.m_criticalPath.size()); i++)
+            {
+                ImGui::BulletText("%s", m_latestSubmission.m_criticalPath[i]);
+            }
+        if (m_latestSubmission.m_criticalPath.size() > maxPathLength)
+            {
+                ImGui::BulletText("... %zu more", m_latestSubmission.m_criticalPath.size() - maxPathLength);
+            }
+
+        ImGui::NewLine();
+        ImGui::Text("Stages over the last %zu tasks", m_window.m_taskCount);
+        for (const auto &stage : m_window.m_stages)
+            {
+                ImGui::Text("%-24s %6zu x | %9.3f ms total | %7.3f ms max", stage.m_label, stage.m_count, stage.m_totalTime, stage.m_maxTime);
+            }
+
+        ImGui::NewLine();
+        if (ImGui::Button("Export Chrome trace"))
+            {
+                writeChromeTrace(traceFile, m_events);
+            }
+        ImGui::SameLine();
+        if (ImGui::Button("Reset"))
+            {
+                reset();
+            }
+
+        ImGui::End();
+    }
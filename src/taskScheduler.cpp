@@ -0,0 +1,572 @@
+#include "taskScheduler.hpp"
+#include <algorithm>
+#include <assert.h>
+
+#if defined(_WIN32)
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <Windows.h>
+#elif defined(__linux__)
+    #include <pthread.h>
+    #include <sched.h>
+#endif
+
+taskScheduler::taskScheduler()
+    {
+        // kept between submissions so the injected lists stop allocating once they have grown to the widest graph
+        for (auto &injected : m_injectedNodes)
+            {
+                injected.reserve(c_initialInjectedCapacity);
+            }
+    }
+
+taskScheduler::~taskScheduler()
+    {
+        stop();
+    }
+
+taskScheduler &taskScheduler::get()
+    {
+        static taskScheduler scheduler;
+        return scheduler;
+    }
+
+void taskScheduler::ensureStarted()
+    {
+        if (m_started.load(std::memory_order_acquire))
+            {
+                return;
+            }
+
+        std::lock_guard<std::mutex> lock(m_startMutex);
+        if (!m_started.load(std::memory_order_relaxed))
+            {
+                startWorkers();
+            }
+    }
+
+void taskScheduler::startWorkers()
+    {
+        const unsigned int coreCount = getCoreCount();
+        const bool reserved = m_settings.m_reservedCore >= 0 && static_cast<unsigned int>(m_settings.m_reservedCore) < coreCount;
+        const unsigned int workerCount = m_settings.m_workerCount != 0 ? m_settings.m_workerCount : std::max(coreCount - 1, 1u);
+        const unsigned int pinnableCores = coreCount - (reserved ? 1 : 0);
+
+        // every handler exists before any thread starts since workers look at each other to steal
+        for (unsigned int i = 0; i < workerCount; i++)
+            {
+                int core = -1;
+                if (m_settings.m_pinWorkers && pinnableCores > 0)
+                    {
+                        core = static_cast<int>(i % pinnableCores);
+                        if (reserved && core >= m_settings.m_reservedCore)
+                            {
+                                core++;
+                            }
+                    }
+                m_workers.push_back(std::make_unique<executionHandler>(this, i, core));
+            }
+        for (auto &worker : m_workers)
+            {
+                worker->start();
+            }
+
+        m_started.store(true, std::memory_order_release);
+    }
+
+bool taskScheduler::start(const settings &settings)
+    {
+        std::lock_guard<std::mutex> lock(m_startMutex);
+        if (!stop())
+            {
+                return false;
+            }
+
+        m_settings = settings;
+        startWorkers();
+        return true;
+    }
+
+bool taskScheduler::stop()
+    {
+        // queued nodes would never run and waiting threads walk the workers to steal from them
+        const bool idle = m_outstandingWork.load(std::memory_order_acquire) == 0;
+        assert(idle && "taskScheduler stopped while work is outstanding");
+        if (!idle)
+            {
+                return false;
+            }
+
+        for (auto &worker : m_workers)
+            {
+                worker->m_running = false;
+            }
+        m_wakeSignal.fetch_add(1, std::memory_order_release);
+        m_wakeSignal.notify_all();
+        for (auto &worker : m_workers)
+            {
+                if (worker->m_thread.joinable())
+                    {
+                        worker->m_thread.join();
+                    }
+            }
+        m_workers.clear();
+        m_started.store(false, std::memory_order_release);
+        return true;
+    }
+
+unsigned int taskScheduler::getWorkerCount()
+    {
+        ensureStarted();
+        return static_cast<unsigned int>(m_workers.size());
+    }
+
+void taskScheduler::setFrameBudget(std::chrono::microseconds budget)
+    {
+        m_frameBudget.store(std::chrono::duration_cast<std::chrono::nanoseconds>(budget).count(), std::memory_order_relaxed);
+        // a raised or removed cap may let parked workers start background work again
+        wakeWorkers(m_workers.size());
+    }
+
+void taskScheduler::beginFrame()
+    {
+        const bool wasOverBudget = !canStartPriority(static_cast<std::size_t>(taskPriority::BACKGROUND));
+        m_backgroundTimeUsed.store(0, std::memory_order_relaxed);
+        // workers that ran out of background work they were allowed to start are asleep
+        if (wasOverBudget)
+            {
+                wakeWorkers(m_workers.size());
+            }
+    }
+
+unsigned int taskScheduler::getCoreCount()
+    {
+        // hardware_concurrency may report 0 when it cannot tell
+        return std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+bool taskScheduler::pinCurrentThread(unsigned int core)
+    {
+        #if defined(_WIN32)
+            if (core >= sizeof(DWORD_PTR) * 8)
+                {
+                    return false;
+                }
+            return SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << core) != 0;
+        #elif defined(__linux__)
+            if (core >= CPU_SETSIZE)
+                {
+                    return false;
+                }
+            cpu_set_t cores;
+            CPU_ZERO(&cores);
+            CPU_SET(core, &cores);
+            return pthread_setaffinity_np(pthread_self(), sizeof(cores), &cores) == 0;
+        #else
+            (void)core;
+            return false;
+        #endif
+    }
+
+bool taskScheduler::canStartPriority(std::size_t priority) const
+    {
+        if (priority != static_cast<std::size_t>(taskPriority::BACKGROUND))
+            {
+                return true;
+            }
+
+        const std::int64_t budget = m_frameBudget.load(std::memory_order_relaxed);
+        return budget == 0 || m_backgroundTimeUsed.load(std::memory_order_relaxed) < budget;
+    }
+
+void taskScheduler::inject(node *const *roots, std::size_t rootCount, taskPriority priority)
+    {
+        ensureStarted();
+        if (rootCount > 0)
+            {
+                m_outstandingWork.fetch_add(1, std::memory_order_relaxed);
+                pushInjected(roots, rootCount, static_cast<std::size_t>(priority));
+            }
+    }
+
+void taskScheduler::pushInjected(node *const *nodes, std::size_t count, std::size_t priority)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_injectedMutex);
+            m_injectedNodes[priority].insert(m_injectedNodes[priority].end(), nodes, nodes + count);
+            m_hasInjectedNodes[priority].store(true, std::memory_order_release);
+        }
+        wakeWorkers(count);
+    }
+
+void taskScheduler::help(executionState &state)
+    {
+        // only work at least as urgent as the submission is picked up, so waiting on a frame never runs background nodes
+        const std::size_t priority = static_cast<std::size_t>(state.m_priority);
+        m_outstandingWork.fetch_add(1, std::memory_order_relaxed);
+        std::size_t victim = 0;
+        node *work = nullptr;
+        int failedSearches = 0;
+        while (state.m_remainingNodes.load(std::memory_order_acquire) > 0)
+            {
+                if (!work)
+                    {
+                        work = findHelpWork(priority, victim);
+                    }
+
+                if (work)
+                    {
+                        work = runHelpWork(work);
+                        failedSearches = 0;
+                    }
+                else if (failedSearches < c_spinCount)
+                    {
+                        failedSearches++;
+                        std::this_thread::yield();
+                    }
+                else
+                    {
+                        // the rest is already running on the workers
+                        const std::uint32_t signal = m_completionSignal.load(std::memory_order_acquire);
+                        if (state.m_remainingNodes.load(std::memory_order_acquire) > 0)
+                            {
+                                m_completionSignal.wait(signal, std::memory_order_acquire);
+                            }
+                        failedSearches = 0;
+                    }
+            }
+
+        // a child made ready by the last node run here belongs to another submission. The workers take it from here
+        if (work)
+            {
+                pushInjected(&work, 1, static_cast<std::size_t>(work->m_state->m_priority));
+            }
+        m_outstandingWork.fetch_sub(1, std::memory_order_release);
+    }
+
+taskScheduler::node *taskScheduler::findHelpWork(std::size_t maxPriority, std::size_t &victim)
+    {
+        for (std::size_t priority = 0; priority <= maxPriority && canStartPriority(priority); priority++)
+            {
+                if (m_hasInjectedNodes[priority].load(std::memory_order_acquire))
+                    {
+                        std::lock_guard<std::mutex> lock(m_injectedMutex);
+                        std::vector<node*> &injected = m_injectedNodes[priority];
+                        if (!injected.empty())
+                            {
+                                node *work = injected.back();
+                                injected.pop_back();
+                                m_hasInjectedNodes[priority].store(!injected.empty(), std::memory_order_relaxed);
+                                return work;
+                            }
+                    }
+
+                for (std::size_t i = 0; i < m_workers.size(); i++)
+                    {
+                        victim = (victim + 1) % m_workers.size();
+                        node *work = nullptr;
+                        if (m_workers[victim]->m_deques[priority].steal(work))
+                            {
+                                return work;
+                            }
+                    }
+            }
+
+        return nullptr;
+    }
+
+taskScheduler::node *taskScheduler::runHelpWork(node *work)
+    {
+        const std::size_t priority = static_cast<std::size_t>(work->m_state->m_priority);
+        work->m_pendingParents.store(work->m_parentCount, std::memory_order_relaxed);
+        const std::int64_t endTime = runNode(work, static_cast<std::uint32_t>(m_workers.size()));
+
+        // this thread has no deque, so anything past the first ready child goes back through the injected list
+        node *next = nullptr;
+        std::size_t injectedCount = 0;
+        std::unique_lock<std::mutex> lock(m_injectedMutex, std::defer_lock);
+        for (std::uint32_t i = 0; i < work->m_childCount; i++)
+            {
+                node *child = work->m_childList[i];
+                if (child->m_pendingParents.fetch_sub(1, std::memory_order_acq_rel) != 1)
+                    {
+                        continue;
+                    }
+                markReady(child, work, endTime);
+
+                if (!next)
+                    {
+                        next = child;
+                        continue;
+                    }
+
+                if (!lock.owns_lock())
+                    {
+                        lock.lock();
+                    }
+                m_injectedNodes[priority].push_back(child);
+                injectedCount++;
+            }
+
+        if (lock.owns_lock())
+            {
+                m_hasInjectedNodes[priority].store(true, std::memory_order_release);
+                lock.unlock();
+                wakeWorkers(injectedCount);
+            }
+
+        finishNode(work);
+        return next;
+    }
+
+std::int64_t taskScheduler::runNode(node *node, std::uint32_t thread)
+    {
+        taskProfiler *profiler = node->m_state->m_profiler;
+        const bool profiling = profiler && profiler->isEnabled();
+        const bool budgeted = node->m_state->m_priority == taskPriority::BACKGROUND && m_frameBudget.load(std::memory_order_relaxed) != 0;
+        if (!profiling && !budgeted)
+            {
+                node->execute();
+                return 0;
+            }
+
+        const std::int64_t startTime = taskProfiler::now();
+        node->execute();
+        const std::int64_t endTime = taskProfiler::now();
+
+        if (budgeted)
+            {
+                m_backgroundTimeUsed.fetch_add(endTime - startTime, std::memory_order_relaxed);
+            }
+
+        if (profiling)
+            {
+                taskProfiler::event event;
+                event.m_node = node;
+                event.m_readyParent = node->m_readyParent;
+                event.m_label = node->m_label;
+                event.m_submission = node->m_state->m_submission;
+                event.m_thread = thread;
+                event.m_queuedTime = node->m_queuedTime;
+                event.m_startTime = startTime;
+                event.m_endTime = endTime;
+                profiler->record(thread, event);
+            }
+
+        return endTime;
+    }
+
+void taskScheduler::markReady(node *child, node *parent, std::int64_t time)
+    {
+        // only worth the writes while something is recording
+        if (time != 0)
+            {
+                child->m_readyParent = parent;
+                child->m_queuedTime = time;
+            }
+    }
+
+void taskScheduler::finishNode(node *node)
+    {
+        // nothing from the node or its submission is touched after the last decrement since the waiter may free them straight away
+        executionState *state = node->m_state;
+        if (state->m_remainingNodes.fetch_sub(1, std::memory_order_acq_rel) == 2)
+            {
+                // the extra count keeps the submission from looking finished until the scheduler has stopped counting it, so stop
+                // is never refused for work the caller has already seen finish
+                m_outstandingWork.fetch_sub(1, std::memory_order_release);
+                state->m_remainingNodes.store(0, std::memory_order_release);
+                m_completionSignal.fetch_add(1, std::memory_order_release);
+                m_completionSignal.notify_all();
+            }
+    }
+
+void taskScheduler::wakeWorkers(std::size_t count)
+    {
+        // pairs with the fence in park. Either the sleeper sees the new work or we see the sleeper
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const unsigned int sleeping = m_sleepingWorkers.load(std::memory_order_relaxed);
+        if (sleeping == 0 || count == 0)
+            {
+                return;
+            }
+
+        m_wakeSignal.fetch_add(1, std::memory_order_release);
+        if (count >= sleeping)
+            {
+                m_wakeSignal.notify_all();
+            }
+        else
+            {
+                for (std::size_t i = 0; i < count; i++)
+                    {
+                        m_wakeSignal.notify_one();
+                    }
+            }
+    }
+
+taskScheduler::executionHandler::executionHandler(taskScheduler *scheduler, std::size_t index, int core) :
+    m_scheduler(scheduler),
+    m_randomState(static_cast<std::uint32_t>(index) * 0x9e3779b9u + 1),
+    m_index(static_cast<std::uint32_t>(index)),
+    m_core(core)
+    {
+    }
+
+void taskScheduler::executionHandler::start()
+    {
+        m_running = true;
+        m_thread = std::thread(&taskScheduler::executionHandler::executionLoop, this);
+    }
+
+void taskScheduler::executionHandler::executionLoop()
+    {
+        if (m_core >= 0)
+            {
+                pinCurrentThread(static_cast<unsigned int>(m_core));
+            }
+
+        int failedSearches = 0;
+        while (m_running)
+            {
+                node *work = findWork();
+                if (!work && failedSearches >= c_spinCount)
+                    {
+                        work = park();
+                        failedSearches = 0;
+                    }
+
+                if (work)
+                    {
+                        execute(work);
+                        failedSearches = 0;
+                    }
+                else
+                    {
+                        failedSearches++;
+                        std::this_thread::yield();
+                    }
+            }
+    }
+
+taskScheduler::node *taskScheduler::executionHandler::park()
+    {
+        // the signal is read before the last look for work so a wake between the two is not lost
+        const std::uint32_t signal = m_scheduler->m_wakeSignal.load(std::memory_order_acquire);
+        m_scheduler->m_sleepingWorkers.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        node *work = findWork();
+        if (!work && m_running)
+            {
+                m_scheduler->m_wakeSignal.wait(signal, std::memory_order_acquire);
+            }
+
+        m_scheduler->m_sleepingWorkers.fetch_sub(1, std::memory_order_relaxed);
+        return work;
+    }
+
+taskScheduler::node *taskScheduler::executionHandler::findWork()
+    {
+        for (std::size_t priority = 0; priority < c_priorityCount && m_scheduler->canStartPriority(priority); priority++)
+            {
+                node *work = nullptr;
+                if (m_deques[priority].pop(work))
+                    {
+                        return work;
+                    }
+
+                work = takeInjectedWork(priority);
+                if (work)
+                    {
+                        return work;
+                    }
+
+                work = stealWork(priority);
+                if (work)
+                    {
+                        return work;
+                    }
+            }
+
+        return nullptr;
+    }
+
+taskScheduler::node *taskScheduler::executionHandler::takeInjectedWork(std::size_t priority)
+    {
+        if (!m_scheduler->m_hasInjectedNodes[priority].load(std::memory_order_acquire))
+            {
+                return nullptr;
+            }
+
+        std::lock_guard<std::mutex> lock(m_scheduler->m_injectedMutex);
+        std::vector<node*> &injected = m_scheduler->m_injectedNodes[priority];
+        if (injected.empty())
+            {
+                return nullptr;
+            }
+
+        // take a batch at a time so a wide graph is spread over the workers without growing any one deque
+        const std::size_t batchStart = injected.size() > c_injectedBatchSize ? injected.size() - c_injectedBatchSize : 0;
+        node *work = injected.back();
+        for (std::size_t i = batchStart; i < injected.size() - 1; i++)
+            {
+                m_deques[priority].push(injected[i]);
+            }
+        injected.resize(batchStart);
+        m_scheduler->m_hasInjectedNodes[priority].store(!injected.empty(), std::memory_order_relaxed);
+        return work;
+    }
+
+taskScheduler::node *taskScheduler::executionHandler::stealWork(std::size_t priority)
+    {
+        const std::size_t workerCount = m_scheduler->m_workers.size();
+        if (workerCount < 2)
+            {
+                return nullptr;
+            }
+
+        // xorshift picks the first victim, then every other worker is tried once
+        m_randomState ^= m_randomState << 13;
+        m_randomState ^= m_randomState >> 17;
+        m_randomState ^= m_randomState << 5;
+        const std::size_t first = m_randomState % workerCount;
+        for (std::size_t i = 0; i < workerCount; i++)
+            {
+                executionHandler *victim = m_scheduler->m_workers[(first + i) % workerCount].get();
+                node *work = nullptr;
+                if (victim != this && victim->m_deques[priority].steal(work))
+                    {
+                        return work;
+                    }
+            }
+
+        return nullptr;
+    }
+
+void taskScheduler::executionHandler::execute(node *node)
+    {
+        // every parent is done so nothing else touches the counter. Restoring it lets the graph run again without a reset pass
+        const std::size_t priority = static_cast<std::size_t>(node->m_state->m_priority);
+        node->m_pendingParents.store(node->m_parentCount, std::memory_order_relaxed);
+        const std::int64_t endTime = m_scheduler->runNode(node, m_index);
+        std::size_t readyCount = 0;
+        for (std::uint32_t i = 0; i < node->m_childCount; i++)
+            {
+                taskScheduler::node *child = node->m_childList[i];
+                if (child->m_pendingParents.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                    {
+                        m_scheduler->markReady(child, node, endTime);
+                        m_deques[priority].push(child);
+                        readyCount++;
+                    }
+            }
+
+        // this worker takes one of them itself
+        if (readyCount > 1)
+            {
+                m_scheduler->wakeWorkers(readyCount - 1);
+            }
+
+        m_scheduler->finishNode(node);
+    }
@@ -0,0 +1,281 @@
+#include "voxel/batchNoise.hpp"
+#include <optick.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+    #define BATCH_NOISE_SSE 1
+    #include <emmintrin.h>
+#else
+    #define BATCH_NOISE_SSE 0
+#endif
+
+// lattice values, copied from FastNoise so both generators agree
+static constexpr float c_valueTable[256] =
+    {
+        0.3490196078f, 0.4352941176f, -0.4509803922f, 0.6392156863f, 0.5843137255f, -0.1215686275f, 0.7176470588f, -0.1058823529f,
+        0.3960784314f, 0.0431372549f, -0.03529411765f, 0.3176470588f, 0.7254901961f, 0.137254902f, 0.8588235294f, -0.8196078431f,
+        -0.7960784314f, -0.3333333333f, -0.6705882353f, -0.3882352941f, 0.262745098f, 0.3254901961f, -0.6470588235f, -0.9215686275f,
+        -0.5294117647f, 0.5294117647f, -0.4666666667f, 0.8117647059f, 0.3803921569f, 0.662745098f, 0.03529411765f, -0.6156862745f,
+        -0.01960784314f, -0.3568627451f, -0.09019607843f, 0.7490196078f, 0.8352941176f, -0.4039215686f, -0.7490196078f, 0.9529411765f,
+        -0.0431372549f, -0.9294117647f, -0.6549019608f, 0.9215686275f, -0.06666666667f, -0.4431372549f, 0.4117647059f, -0.4196078431f,
+        -0.7176470588f, -0.8117647059f, -0.2549019608f, 0.4901960784f, 0.9137254902f, 0.7882352941f, -1.0f, -0.4745098039f,
+        0.7960784314f, 0.8509803922f, -0.6784313725f, 0.4588235294f, 1.0f, -0.1843137255f, 0.4509803922f, 0.1450980392f,
+        -0.231372549f, -0.968627451f, -0.8588235294f, 0.4274509804f, 0.003921568627f, -0.003921568627f, 0.2156862745f, 0.5058823529f,
+        0.7647058824f, 0.2078431373f, -0.5921568627f, 0.5764705882f, -0.1921568627f, -0.937254902f, 0.08235294118f, -0.08235294118f,
+        0.9058823529f, 0.8274509804f, 0.02745098039f, -0.168627451f, -0.7803921569f, 0.1137254902f, -0.9450980392f, 0.2f,
+        0.01960784314f, 0.5607843137f, 0.2705882353f, 0.4431372549f, -0.9607843137f, 0.6156862745f, 0.9294117647f, -0.07450980392f,
+        0.3098039216f, 0.9921568627f, -0.9137254902f, -0.2941176471f, -0.3411764706f, -0.6235294118f, -0.7647058824f, -0.8901960784f,
+        0.05882352941f, 0.2392156863f, 0.7333333333f, 0.6549019608f, 0.2470588235f, 0.231372549f, -0.3960784314f, -0.05098039216f,
+        -0.2235294118f, -0.3725490196f, 0.6235294118f, 0.7019607843f, -0.8274509804f, 0.4196078431f, 0.07450980392f, 0.8666666667f,
+        -0.537254902f, -0.5058823529f, -0.8039215686f, 0.09019607843f, -0.4823529412f, 0.6705882353f, -0.7882352941f, 0.09803921569f,
+        -0.6078431373f, 0.8039215686f, -0.6f, -0.3254901961f, -0.4117647059f, -0.01176470588f, 0.4823529412f, 0.168627451f,
+        0.8745098039f, -0.3647058824f, -0.1607843137f, 0.568627451f, -0.9921568627f, 0.9450980392f, 0.5137254902f, 0.01176470588f,
+        -0.1450980392f, -0.5529411765f, -0.5764705882f, -0.1137254902f, 0.5215686275f, 0.1607843137f, 0.3725490196f, -0.2f,
+        -0.7254901961f, 0.631372549f, 0.7098039216f, -0.568627451f, 0.1294117647f, -0.3098039216f, 0.7411764706f, -0.8509803922f,
+        0.2549019608f, -0.6392156863f, -0.5607843137f, -0.3176470588f, 0.937254902f, 0.9843137255f, 0.5921568627f, 0.6941176471f,
+        0.2862745098f, -0.5215686275f, 0.1764705882f, 0.537254902f, -0.4901960784f, -0.4588235294f, -0.2078431373f, -0.2156862745f,
+        0.7725490196f, 0.3647058824f, -0.2392156863f, 0.2784313725f, -0.8823529412f, 0.8980392157f, 0.1215686275f, 0.1058823529f,
+        -0.8745098039f, -0.9843137255f, -0.7019607843f, 0.9607843137f, 0.2941176471f, 0.3411764706f, 0.1529411765f, 0.06666666667f,
+        -0.9764705882f, 0.3019607843f, 0.6470588235f, -0.5843137255f, 0.05098039216f, -0.5137254902f, -0.137254902f, 0.3882352941f,
+        -0.262745098f, -0.3019607843f, -0.1764705882f, -0.7568627451f, 0.1843137255f, -0.5450980392f, -0.4980392157f, -0.2784313725f,
+        -0.9529411765f, -0.09803921569f, 0.8901960784f, -0.2862745098f, -0.3803921569f, 0.5529411765f, 0.7803921569f, -0.8352941176f,
+        0.6862745098f, 0.7568627451f, 0.4980392157f, -0.6862745098f, -0.8980392157f, -0.7725490196f, -0.7098039216f, -0.2470588235f,
+        -0.9058823529f, 0.9764705882f, 0.1921568627f, 0.8431372549f, -0.05882352941f, 0.3568627451f, 0.6078431373f, 0.5450980392f,
+        0.4039215686f, -0.7333333333f, -0.4274509804f, 0.6f, 0.6784313725f, -0.631372549f, -0.02745098039f, -0.1294117647f,
+        0.3333333333f, -0.8431372549f, 0.2235294118f, -0.3490196078f, -0.6941176471f, 0.8823529412f, 0.4745098039f, 0.4666666667f,
+        -0.7411764706f, -0.2705882353f, 0.968627451f, 0.8196078431f, -0.662745098f, -0.4352941176f, -0.8666666667f, -0.1529411765f,
+    };
+
+static int fastFloor(float f)
+    {
+        // same rounding as FastNoise, including the off by one for negative integers
+        return f >= 0 ? static_cast<int>(f) : static_cast<int>(f) - 1;
+    }
+
+static float interpolateQuintic(float t)
+    {
+        return t * t * t * (t * (t * 6 - 15) + 10);
+    }
+
+static float lerp(float a, float b, float t)
+    {
+        return a + t * (b - a);
+    }
+
+void batchNoise::calculateFractalBounding()
+    {
+        float amplitude = m_gain;
+        float fractalAmplitude = 1.f;
+        for (int i = 1; i < m_octaves; i++)
+            {
+                fractalAmplitude += amplitude;
+                amplitude *= m_gain;
+            }
+        m_fractalBounding = 1.f / fractalAmplitude;
+    }
+
+float batchNoise::sampleOctave(uint8_t offset, float x, float y, float z) const
+    {
+        const int x0 = fastFloor(x);
+        const int y0 = fastFloor(y);
+        const int z0 = fastFloor(z);
+
+        const float xs = interpolateQuintic(x - static_cast<float>(x0));
+        const float ys = interpolateQuintic(y - static_cast<float>(y0));
+        const float zs = interpolateQuintic(z - static_cast<float>(z0));
+
+        auto value = [this, offset](int x, int y, int z) {
+            return c_valueTable[m_perm[(x & 0xff) + m_perm[(y & 0xff) + m_perm[(z & 0xff) + offset]]]];
+        };
+
+        const float xf00 = lerp(value(x0, y0, z0), value(x0 + 1, y0, z0), xs);
+        const float xf10 = lerp(value(x0, y0 + 1, z0), value(x0 + 1, y0 + 1, z0), xs);
+        const float xf01 = lerp(value(x0, y0, z0 + 1), value(x0 + 1, y0, z0 + 1), xs);
+        const float xf11 = lerp(value(x0, y0 + 1, z0 + 1), value(x0 + 1, y0 + 1, z0 + 1), xs);
+
+        return lerp(lerp(xf00, xf10, ys), lerp(xf01, xf11, ys), zs);
+    }
+
+batchNoise::batchNoise()
+    {
+        setSeed(1337);
+        calculateFractalBounding();
+    }
+
+void batchNoise::setSeed(int seed)
+    {
+        // identical shuffle to FastNoise::SetSeed so the same seed gives the same terrain
+        std::mt19937_64 generator(seed);
+        for (int i = 0; i < 256; i++)
+            {
+                m_perm[i] = static_cast<uint8_t>(i);
+            }
+
+        for (int j = 0; j < 256; j++)
+            {
+                int k = static_cast<int>(generator() % (256 - j)) + j;
+                uint8_t swap = m_perm[j];
+                m_perm[j] = m_perm[j + 256] = m_perm[k];
+                m_perm[k] = swap;
+            }
+    }
+
+void batchNoise::setFrequency(float frequency)
+    {
+        m_frequency = frequency;
+    }
+
+void batchNoise::setFractalOctaves(int octaves)
+    {
+        m_octaves = std::clamp(octaves, 1, c_maxOctaves);
+        calculateFractalBounding();
+    }
+
+void batchNoise::setFractalLacunarity(float lacunarity)
+    {
+        m_lacunarity = lacunarity;
+    }
+
+void batchNoise::setFractalGain(float gain)
+    {
+        m_gain = gain;
+        calculateFractalBounding();
+    }
+
+float batchNoise::sample(float x, float y, float z) const
+    {
+        x *= m_frequency;
+        y *= m_frequency;
+        z *= m_frequency;
+
+        float sum = sampleOctave(m_perm[0], x, y, z);
+        float amplitude = 1.f;
+        for (int i = 1; i < m_octaves; i++)
+            {
+                x *= m_lacunarity;
+                y *= m_lacunarity;
+                z *= m_lacunarity;
+
+                amplitude *= m_gain;
+                sum += sampleOctave(m_perm[i], x, y, z) * amplitude;
+            }
+
+        return sum * m_fractalBounding;
+    }
+
+void batchNoise::fill(float *values, const glm::ivec3 &origin, const glm::ivec3 &size) const
+    {
+        OPTICK_EVENT();
+        const std::size_t count = static_cast<std::size_t>(size.x) * size.y * size.z;
+        std::fill(values, values + count, 0.f);
+        if (count == 0)
+            {
+                return;
+            }
+
+        // coordinates are scaled exactly as sample() scales them so every voxel lands in the same cell
+        std::vector<float> coordinates[3];
+        std::vector<int> cells[3];
+        std::vector<float> fractions[3];
+        for (int axis = 0; axis < 3; axis++)
+            {
+                coordinates[axis].resize(size[axis]);
+                cells[axis].resize(size[axis]);
+                fractions[axis].resize(size[axis]);
+                for (int i = 0; i < size[axis]; i++)
+                    {
+                        coordinates[axis][i] = static_cast<float>(origin[axis] + i) * m_frequency;
+                    }
+            }
+
+        // trilinear interpolation is separable. Every row along x interpolates y and z once per lattice point,
+        // which leaves a single lerp per voxel that runs four lanes at a time
+        std::vector<float> lattice;
+        std::vector<int> latticeIndex(size.x);
+        float amplitude = 1.f;
+        for (int octave = 0; octave < m_octaves; octave++)
+            {
+                if (octave > 0)
+                    {
+                        amplitude *= m_gain;
+                        for (auto &axisCoordinates : coordinates)
+                            {
+                                for (float &coordinate : axisCoordinates)
+                                    {
+                                        coordinate *= m_lacunarity;
+                                    }
+                            }
+                    }
+
+                for (int axis = 0; axis < 3; axis++)
+                    {
+                        for (int i = 0; i < size[axis]; i++)
+                            {
+                                cells[axis][i] = fastFloor(coordinates[axis][i]);
+                                fractions[axis][i] = interpolateQuintic(coordinates[axis][i] - static_cast<float>(cells[axis][i]));
+                            }
+                    }
+
+                const auto [minimumX, maximumX] = std::minmax_element(cells[0].begin(), cells[0].end());
+                const int latticeStart = *minimumX;
+                lattice.resize(*maximumX - latticeStart + 2);
+                for (int x = 0; x < size.x; x++)
+                    {
+                        latticeIndex[x] = cells[0][x] - latticeStart;
+                    }
+
+                const uint8_t offset = m_perm[octave];
+                for (int z = 0; z < size.z; z++)
+                    {
+                        const int zHash0 = m_perm[(cells[2][z] & 0xff) + offset];
+                        const int zHash1 = m_perm[((cells[2][z] + 1) & 0xff) + offset];
+                        const float zs = fractions[2][z];
+
+                        for (int y = 0; y < size.y; y++)
+                            {
+                                const int y0 = cells[1][y] & 0xff;
+                                const int y1 = (cells[1][y] + 1) & 0xff;
+                                const int hash00 = m_perm[y0 + zHash0];
+                                const int hash10 = m_perm[y1 + zHash0];
+                                const int hash01 = m_perm[y0 + zHash1];
+                                const int hash11 = m_perm[y1 + zHash1];
+                                const float ys = fractions[1][y];
+
+                                for (std::size_t i = 0; i < lattice.size(); i++)
+                                    {
+                                        const int x = (latticeStart + static_cast<int>(i)) & 0xff;
+                                        const float z0 = lerp(c_valueTable[m_perm[x + hash00]], c_valueTable[m_perm[x + hash10]], ys);
+                                        const float z1 = lerp(c_valueTable[m_perm[x + hash01]], c_valueTable[m_perm[x + hash11]], ys);
+                                        lattice[i] = lerp(z0, z1, zs);
+                                    }
+
+                                float *row = values + static_cast<std::size_t>(size.x) * (y + static_cast<std::size_t>(size.y) * z);
+                                const float *xs = fractions[0].data();
+                                const int *index = latticeIndex.data();
+
+                                int x = 0;
+                                #if BATCH_NOISE_SSE
+                                    const __m128 amplitudes = _mm_set1_ps(amplitude);
+                                    for (; x + 4 <= size.x; x += 4)
+                                        {
+                                            const __m128 lower = _mm_setr_ps(lattice[index[x]], lattice[index[x + 1]], lattice[index[x + 2]], lattice[index[x + 3]]);
+                                            const __m128 upper = _mm_setr_ps(lattice[index[x] + 1], lattice[index[x + 1] + 1], lattice[index[x + 2] + 1], lattice[index[x + 3] + 1]);
+                                            const __m128 value = _mm_add_ps(lower, _mm_mul_ps(_mm_loadu_ps(xs + x), _mm_sub_ps(upper, lower)));
+                                            _mm_storeu_ps(row + x, _mm_add_ps(_mm_loadu_ps(row + x), _mm_mul_ps(value, amplitudes)));
+                                        }
+                                #endif
+                                for (; x < size.x; x++)
+                                    {
+                                        row[x] += lerp(lattice[index[x]], lattice[index[x] + 1], xs[x]) * amplitude;
+                                    }
+                            }
+                    }
+            }
+
+        for (std::size_t i = 0; i < count; i++)
+            {
+                values[i] *= m_fractalBounding;
+            }
+    }
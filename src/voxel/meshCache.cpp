@@ -0,0 +1,286 @@
+#include "voxel/meshCache.hpp"
+#include "voxel/voxelRegion.hpp"
+#include <optick.h>
+#include <cstring>
+#include <algorithm>
+#include <iterator>
+
+bool meshCache::reset(uint32_t mesherVersion)
+    {
+        header fileHeader;
+        fileHeader.m_mesherVersion = mesherVersion;
+        fileHeader.m_regionSize = voxelRegion::c_regionSize;
+        fileHeader.m_subChunksPerChunk = m_subChunksPerChunk;
+
+        std::vector<indexEntry> index(getDataOffset() / sizeof(indexEntry));
+        return m_file.resize(0) && m_file.writeAt(0, &fileHeader, sizeof(fileHeader)) && m_file.writeAt(c_indexOffset, index.data(), getDataOffset() - c_indexOffset);
+    }
+
+bool meshCache::allocateSlot(uint64_t size, uint64_t &offset)
+    {
+        // the smallest free slot that fits keeps large ones for large meshes
+        auto best = m_freeSlots.end();
+        for (auto it = m_freeSlots.begin(); it != m_freeSlots.end(); ++it)
+            {
+                if (it->second >= size && (best == m_freeSlots.end() || it->second < best->second))
+                    {
+                        best = it;
+                    }
+            }
+
+        if (best != m_freeSlots.end())
+            {
+                offset = best->first;
+                const uint64_t remaining = best->second - size;
+                m_freeSlots.erase(best);
+                if (remaining > 0)
+                    {
+                        m_freeSlots.emplace(offset + size, remaining);
+                    }
+                return true;
+            }
+
+        offset = m_file.getFileSize();
+        if (offset + size > c_maxFileSize)
+            {
+                return false;
+            }
+
+        // the slot is reserved up front so a mesh smaller than it does not leave its tail to the next append
+        return m_file.resize(offset + size);
+    }
+
+void meshCache::releaseSlot(uint64_t offset, uint64_t size)
+    {
+        auto next = m_freeSlots.lower_bound(offset);
+        if (next != m_freeSlots.end() && offset + size == next->first)
+            {
+                size += next->second;
+                next = m_freeSlots.erase(next);
+            }
+
+        if (next != m_freeSlots.begin())
+            {
+                auto previous = std::prev(next);
+                if (previous->first + previous->second == offset)
+                    {
+                        previous->second += size;
+                        return;
+                    }
+            }
+
+        m_freeSlots.emplace(offset, size);
+    }
+
+std::size_t meshCache::getDataOffset() const
+    {
+        return c_indexOffset + voxelRegion::c_regionSize * voxelRegion::c_regionSize * m_subChunksPerChunk * c_ways * sizeof(indexEntry);
+    }
+
+std::size_t meshCache::getEntryIndex(const glm::ivec3 &chunkPosition, std::size_t subChunkIndex) const
+    {
+        const glm::ivec3 regionPosition = voxelRegion::getRegionPosition(chunkPosition);
+        const int x = chunkPosition.x - regionPosition.x * voxelRegion::c_regionSize;
+        const int z = chunkPosition.z - regionPosition.z * voxelRegion::c_regionSize;
+        return (static_cast<std::size_t>(x + z * voxelRegion::c_regionSize) * m_subChunksPerChunk + subChunkIndex) * c_ways;
+    }
+
+meshCache::~meshCache()
+    {
+        close();
+    }
+
+bool meshCache::open(const char *file, uint32_t mesherVersion, uint32_t subChunksPerChunk)
+    {
+        OPTICK_EVENT();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_path = file;
+        m_subChunksPerChunk = subChunksPerChunk;
+
+        if (!m_file.open(file))
+            {
+                return false;
+            }
+
+        header fileHeader;
+        bool valid = m_file.map() && m_file.getMappedSize() >= getDataOffset();
+        if (valid)
+            {
+                std::memcpy(&fileHeader, m_file.getData(), sizeof(fileHeader));
+                valid =
+                    fileHeader.m_magic == c_magic &&
+                    fileHeader.m_version == c_version &&
+                    fileHeader.m_mesherVersion == mesherVersion &&
+                    fileHeader.m_regionSize == voxelRegion::c_regionSize &&
+                    fileHeader.m_subChunksPerChunk == subChunksPerChunk &&
+                    fileHeader.m_faceSize == sizeof(packedFace) &&
+                    fileHeader.m_ways == c_ways;
+            }
+
+        // every cached mesh is stale once the mesher changes, so the file starts over
+        if (!valid && (!reset(mesherVersion) || !m_file.map()))
+            {
+                // <error>
+                m_file.close();
+                return false;
+            }
+
+        m_sequence = 0;
+        std::vector<std::pair<uint64_t, uint64_t>> slots;
+        const std::size_t entryCount = (getDataOffset() - c_indexOffset) / sizeof(indexEntry);
+        for (std::size_t i = 0; i < entryCount; i++)
+            {
+                indexEntry entry;
+                std::memcpy(&entry, m_file.getData() + c_indexOffset + i * sizeof(indexEntry), sizeof(indexEntry));
+                m_sequence = std::max(m_sequence, entry.m_sequence);
+                if (entry.m_capacity > 0)
+                    {
+                        slots.emplace_back(entry.m_offset, static_cast<uint64_t>(entry.m_capacity) * sizeof(packedFace));
+                    }
+            }
+
+        // whatever lies between the slots was owned by meshes that have since moved
+        std::sort(slots.begin(), slots.end());
+        m_freeSlots.clear();
+        uint64_t end = getDataOffset();
+        for (const auto &slot : slots)
+            {
+                if (slot.first > end)
+                    {
+                        m_freeSlots.emplace(end, slot.first - end);
+                    }
+                end = std::max(end, slot.first + slot.second);
+            }
+        if (m_file.getFileSize() > end)
+            {
+                m_freeSlots.emplace(end, m_file.getFileSize() - end);
+            }
+        return true;
+    }
+
+void meshCache::close()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_file.close();
+        m_freeSlots.clear();
+    }
+
+bool meshCache::isOpen() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_file.isOpen();
+    }
+
+bool meshCache::read(const glm::ivec3 &chunkPosition, std::size_t subChunkIndex, uint64_t key, std::vector<packedFace> &faces)
+    {
+        OPTICK_EVENT();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        indexEntry ways[c_ways];
+        if (!m_file.isOpen() || !m_file.readAt(c_indexOffset + getEntryIndex(chunkPosition, subChunkIndex) * sizeof(indexEntry), ways, sizeof(ways)))
+            {
+                return false;
+            }
+
+        for (const indexEntry &entry : ways)
+            {
+                if (entry.m_sequence == 0 || entry.m_key != key)
+                    {
+                        continue;
+                    }
+
+                // slots are rewritten in place, which the mapping is not guaranteed to see
+                faces.resize(entry.m_faceCount);
+                return entry.m_faceCount == 0 || m_file.readAt(entry.m_offset, faces.data(), entry.m_faceCount * sizeof(packedFace));
+            }
+
+        return false;
+    }
+
+bool meshCache::write(const glm::ivec3 &chunkPosition, std::size_t subChunkIndex, uint64_t key, const packedFace *faces, std::size_t faceCount)
+    {
+        OPTICK_EVENT();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const std::size_t firstEntry = getEntryIndex(chunkPosition, subChunkIndex);
+        indexEntry ways[c_ways];
+        if (!m_file.isOpen() || !m_file.readAt(c_indexOffset + firstEntry * sizeof(indexEntry), ways, sizeof(ways)))
+            {
+                return false;
+            }
+
+        std::size_t replaced = 0;
+        for (std::size_t way = 0; way < c_ways; way++)
+            {
+                if (ways[way].m_sequence < ways[replaced].m_sequence)
+                    {
+                        replaced = way;
+                    }
+            }
+
+        const uint64_t entryOffset = c_indexOffset + (firstEntry + replaced) * sizeof(indexEntry);
+        const indexEntry previous = ways[replaced];
+        indexEntry entry = previous;
+        entry.m_key = key;
+        entry.m_faceCount = static_cast<uint32_t>(faceCount);
+        entry.m_sequence = ++m_sequence;
+
+        const bool moved = faceCount > previous.m_capacity;
+        if (moved)
+            {
+                uint64_t capacity = c_minimumSlotSize;
+                while (capacity < faceCount)
+                    {
+                        capacity *= 2;
+                    }
+                if (!allocateSlot(capacity * sizeof(packedFace), entry.m_offset))
+                    {
+                        return false;
+                    }
+                entry.m_capacity = static_cast<uint32_t>(capacity);
+            }
+        else
+            {
+                // the old mesh is overwritten, so the way is emptied first in case the faces do not make it
+                indexEntry emptied = previous;
+                emptied.m_sequence = 0;
+                if (!m_file.writeAt(entryOffset, &emptied, sizeof(emptied)))
+                    {
+                        return false;
+                    }
+            }
+
+        // faces first, so a failed write never leaves the entry pointing at garbage
+        bool written = faceCount == 0 || m_file.writeAt(entry.m_offset, faces, faceCount * sizeof(packedFace));
+        if (written)
+            {
+                written = m_file.writeAt(entryOffset, &entry, sizeof(entry));
+            }
+
+        if (moved)
+            {
+                // whichever slot the way does not point at is free again
+                const indexEntry &released = written ? previous : entry;
+                if (released.m_capacity > 0)
+                    {
+                        releaseSlot(released.m_offset, static_cast<uint64_t>(released.m_capacity) * sizeof(packedFace));
+                    }
+            }
+
+        return written;
+    }
+
+uint64_t meshCache::hash(const void *data, std::size_t size, uint64_t seed)
+    {
+        uint64_t hash = seed;
+        const uint8_t *bytes = static_cast<const uint8_t*>(data);
+        for (std::size_t i = 0; i < size; i++)
+            {
+                hash ^= bytes[i];
+                hash *= 0x100000001b3ull;
+            }
+        return hash;
+    }
+
+std::string meshCache::getFileName(const glm::ivec3 &regionPosition)
+    {
+        return "r." + std::to_string(regionPosition.x) + "." + std::to_string(regionPosition.y) + "." + std::to_string(regionPosition.z) + ".vxm";
+    }
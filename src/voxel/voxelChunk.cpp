@@ -1,6 +1,8 @@
 #include "voxel/voxelChunk.hpp"
 #include <optick.h>
 #include <fstream>
+#include <algorithm>
+#include <cstring>
 
 voxelChunk::voxelChunk(voxelChunk::sizeType sizeX, voxelChunk::sizeType sizeY, voxelChunk::sizeType sizeZ)
     {
@@ -9,43 +11,216 @@ voxelChunk::voxelChunk(voxelChunk::sizeType sizeX, voxelChunk::sizeType sizeY, v
 
 void voxelChunk::create(voxelChunk::sizeType sizeX, voxelChunk::sizeType sizeY, voxelChunk::sizeType sizeZ)
     {
-        m_voxels.resize(sizeY * sizeX * sizeZ);
+        m_palette = { voxelType::NONE };
+        m_indices.clear();
+        m_bitsPerIndex = 0;
+        m_indicesPerWordShift = 0;
+
         m_sizeX = sizeX;
         m_sizeY = sizeY;
         m_sizeZ = sizeZ;
-        m_voxelData = m_voxels.data();
     }
 
-const voxelType &voxelChunk::at(voxelChunk::sizeType x, voxelChunk::sizeType y, voxelChunk::sizeType z) const
+voxelChunk::sizeType voxelChunk::getIndex(voxelChunk::sizeType x, voxelChunk::sizeType y, voxelChunk::sizeType z) const
     {
-        return m_voxelData[x + m_sizeX * (y + m_sizeY * z)];
+        return x + m_sizeX * (y + m_sizeY * z);
     }
 
-voxelType &voxelChunk::at(voxelChunk::sizeType x, voxelChunk::sizeType y, voxelChunk::sizeType z)
+unsigned int voxelChunk::getPaletteIndexAt(voxelChunk::sizeType index) const
     {
-        return m_voxelData[x + m_sizeX * (y + m_sizeY * z)];
+        if (m_bitsPerIndex == 0)
+            {
+                return 0;
+            }
+
+        const uint64_t word = m_indices[index >> m_indicesPerWordShift];
+        const unsigned int shift = static_cast<unsigned int>(index & ((1ull << m_indicesPerWordShift) - 1)) * m_bitsPerIndex;
+        return static_cast<unsigned int>((word >> shift) & ((1ull << m_bitsPerIndex) - 1));
     }
 
-const voxelType &voxelChunk::at(sizeType index) const
+voxelType voxelChunk::get(voxelChunk::sizeType index) const
     {
-        return m_voxelData[index];
+        return m_palette[getPaletteIndexAt(index)];
     }
 
-voxelType &voxelChunk::at(sizeType index)
+void voxelChunk::set(voxelChunk::sizeType index, voxelType type)
     {
-        return m_voxelData[index];
+        const unsigned int paletteIndex = getPaletteIndex(type);
+        if (m_bitsPerIndex == 0)
+            {
+                return;
+            }
+
+        uint64_t &word = m_indices[index >> m_indicesPerWordShift];
+        const unsigned int shift = static_cast<unsigned int>(index & ((1ull << m_indicesPerWordShift) - 1)) * m_bitsPerIndex;
+        const uint64_t mask = ((1ull << m_bitsPerIndex) - 1) << shift;
+        word = (word & ~mask) | (static_cast<uint64_t>(paletteIndex) << shift);
     }
 
-const voxelType &voxelChunk::operator[](sizeType index) const
+unsigned int voxelChunk::getPaletteIndex(voxelType type)
+    {
+        for (unsigned int i = 0; i < m_palette.size(); i++)
+            {
+                if (m_palette[i] == type)
+                    {
+                        return i;
+                    }
+            }
+
+        m_palette.push_back(type);
+        unsigned int bitsPerIndex = m_bitsPerIndex;
+        while ((1u << bitsPerIndex) < m_palette.size())
+            {
+                bitsPerIndex = bitsPerIndex == 0 ? 1 : bitsPerIndex * 2;
+            }
+
+        if (bitsPerIndex != m_bitsPerIndex)
+            {
+                setIndexWidth(bitsPerIndex);
+            }
+
+        return static_cast<unsigned int>(m_palette.size() - 1);
+    }
+
+void voxelChunk::setIndexWidth(unsigned int bitsPerIndex)
+    {
+        OPTICK_EVENT();
+        std::vector<uint64_t> oldIndices = std::move(m_indices);
+        const unsigned int oldBitsPerIndex = m_bitsPerIndex;
+        const unsigned int oldIndicesPerWordShift = m_indicesPerWordShift;
+
+        m_bitsPerIndex = bitsPerIndex;
+        m_indicesPerWordShift = 0;
+        while ((64u >> m_indicesPerWordShift) > m_bitsPerIndex)
+            {
+                m_indicesPerWordShift++;
+            }
+
+        m_indices.assign(((getVolume() * m_bitsPerIndex) + 63) / 64, 0);
+        if (oldBitsPerIndex == 0)
+            {
+                // everything was palette entry 0, which is what the zeroed words already say
+                return;
+            }
+
+        const uint64_t oldMask = (1ull << oldBitsPerIndex) - 1;
+        for (sizeType i = 0; i < getVolume(); i++)
+            {
+                const uint64_t oldWord = oldIndices[i >> oldIndicesPerWordShift];
+                const unsigned int oldShift = static_cast<unsigned int>(i & ((1ull << oldIndicesPerWordShift) - 1)) * oldBitsPerIndex;
+                const uint64_t paletteIndex = (oldWord >> oldShift) & oldMask;
+
+                const unsigned int shift = static_cast<unsigned int>(i & ((1ull << m_indicesPerWordShift) - 1)) * m_bitsPerIndex;
+                m_indices[i >> m_indicesPerWordShift] |= paletteIndex << shift;
+            }
+    }
+
+voxelType voxelChunk::at(voxelChunk::sizeType x, voxelChunk::sizeType y, voxelChunk::sizeType z) const
+    {
+        return get(getIndex(x, y, z));
+    }
+
+voxelChunk::reference voxelChunk::at(voxelChunk::sizeType x, voxelChunk::sizeType y, voxelChunk::sizeType z)
+    {
+        return reference(*this, getIndex(x, y, z));
+    }
+
+voxelType voxelChunk::at(sizeType index) const
+    {
+        return get(index);
+    }
+
+voxelChunk::reference voxelChunk::at(sizeType index)
+    {
+        return reference(*this, index);
+    }
+
+voxelType voxelChunk::operator[](sizeType index) const
     {
         return at(index);
     }
 
-voxelType &voxelChunk::operator[](sizeType index)
+voxelChunk::reference voxelChunk::operator[](sizeType index)
     {
         return at(index);
     }
 
+void voxelChunk::assign(const voxelType *voxels)
+    {
+        OPTICK_EVENT();
+        // voxelType is a byte so a direct lookup table covers every possible type
+        std::array<int, 256> lookup;
+        lookup.fill(-1);
+
+        m_palette.clear();
+        const sizeType volume = getVolume();
+        for (sizeType i = 0; i < volume; i++)
+            {
+                int &entry = lookup[static_cast<unsigned char>(voxels[i])];
+                if (entry < 0)
+                    {
+                        entry = static_cast<int>(m_palette.size());
+                        m_palette.push_back(voxels[i]);
+                    }
+            }
+
+        if (m_palette.empty())
+            {
+                m_palette.push_back(voxelType::NONE);
+            }
+
+        unsigned int bitsPerIndex = 0;
+        while ((1u << bitsPerIndex) < m_palette.size())
+            {
+                bitsPerIndex = bitsPerIndex == 0 ? 1 : bitsPerIndex * 2;
+            }
+
+        m_bitsPerIndex = 0;
+        m_indices.clear();
+        if (bitsPerIndex == 0)
+            {
+                return;
+            }
+
+        setIndexWidth(bitsPerIndex);
+        for (sizeType i = 0; i < volume; i++)
+            {
+                const unsigned int shift = static_cast<unsigned int>(i & ((1ull << m_indicesPerWordShift) - 1)) * m_bitsPerIndex;
+                m_indices[i >> m_indicesPerWordShift] |= static_cast<uint64_t>(lookup[static_cast<unsigned char>(voxels[i])]) << shift;
+            }
+    }
+
+void voxelChunk::extract(voxelType *voxels) const
+    {
+        OPTICK_EVENT();
+        const sizeType volume = getVolume();
+        if (m_bitsPerIndex == 0)
+            {
+                std::fill(voxels, voxels + volume, m_palette[0]);
+                return;
+            }
+
+        for (sizeType i = 0; i < volume; i++)
+            {
+                voxels[i] = get(i);
+            }
+    }
+
+bool voxelChunk::uniform() const
+    {
+        return m_bitsPerIndex == 0;
+    }
+
+std::size_t voxelChunk::getPaletteSize() const
+    {
+        return m_palette.size();
+    }
+
+std::size_t voxelChunk::getMemoryUsage() const
+    {
+        return m_indices.size() * sizeof(uint64_t) + m_palette.size() * sizeof(voxelType);
+    }
+
 voxelChunk::sizeType voxelChunk::getSizeX() const
     {
         return m_sizeX;
@@ -69,11 +244,11 @@ voxelChunk::sizeType voxelChunk::getVolume() const
 void voxelChunk::write(const char *file)
     {
         OPTICK_EVENT();
-        std::vector<char> voxelBuffer(m_voxels.size() * sizeof(std::underlying_type<voxelType>::type));
-        std::memcpy(voxelBuffer.data(), m_voxels.data(), m_voxels.size());
+        std::vector<voxelType> voxelBuffer(getVolume());
+        extract(voxelBuffer.data());
 
         std::ofstream out(file, std::ios::trunc | std::ios::binary);
-        out.write(voxelBuffer.data(), voxelBuffer.size());
+        out.write(reinterpret_cast<const char*>(voxelBuffer.data()), voxelBuffer.size() * sizeof(std::underlying_type<voxelType>::type));
         out.close();
     }
 
@@ -82,13 +257,163 @@ void voxelChunk::read(const char *file)
         OPTICK_EVENT();
         std::ifstream in(file, std::ios::ate | std::ios::binary);
         std::size_t fileSize = static_cast<std::size_t>(in.tellg());
-        std::vector<char> buffer(fileSize);
+        // the file is the raw voxels. Anything past the volume of the chunk is ignored and missing voxels are air
+        std::vector<voxelType> buffer(std::max(getVolume(), fileSize / sizeof(std::underlying_type<voxelType>::type)), voxelType::NONE);
         in.seekg(0);
-        in.read(buffer.data(), fileSize);
+        in.read(reinterpret_cast<char*>(buffer.data()), fileSize);
         in.close();
 
-        m_voxels.resize(buffer.size() / sizeof(std::underlying_type<voxelType>::type));
-        std::memcpy(m_voxels.data(), buffer.data(), buffer.size());
+        assign(buffer.data());
+    }
+
+void voxelChunk::serialise(std::vector<uint8_t> &data) const
+    {
+        OPTICK_EVENT();
+        serialisedHeader header;
+        header.m_sizeX = static_cast<uint32_t>(m_sizeX);
+        header.m_sizeY = static_cast<uint32_t>(m_sizeY);
+        header.m_sizeZ = static_cast<uint32_t>(m_sizeZ);
+        header.m_voxelSize = m_voxelSize;
+        header.m_paletteSize = static_cast<uint32_t>(m_palette.size());
+
+        const uint8_t *headerData = reinterpret_cast<const uint8_t*>(&header);
+        data.insert(data.end(), headerData, headerData + sizeof(header));
+        for (const auto &type : m_palette)
+            {
+                data.push_back(static_cast<uint8_t>(type));
+            }
+
+        const sizeType volume = getVolume();
+        sizeType i = 0;
+        while (i < volume)
+            {
+                const unsigned int paletteIndex = getPaletteIndexAt(i);
+                sizeType runLength = 1;
+                if (m_bitsPerIndex == 0)
+                    {
+                        runLength = volume;
+                    }
+                else
+                    {
+                        while (i + runLength < volume && getPaletteIndexAt(i + runLength) == paletteIndex)
+                            {
+                                runLength++;
+                            }
+                    }
+
+                data.push_back(static_cast<uint8_t>(paletteIndex));
+                sizeType length = runLength;
+                do
+                    {
+                        uint8_t byte = length & 0x7f;
+                        length >>= 7;
+                        data.push_back(length ? byte | 0x80 : byte);
+                    } while (length);
+
+                i += runLength;
+            }
+    }
+
+bool voxelChunk::deserialise(const uint8_t *data, std::size_t size)
+    {
+        OPTICK_EVENT();
+        serialisedHeader header;
+        if (size < sizeof(header))
+            {
+                return false;
+            }
+        std::memcpy(&header, data, sizeof(header));
+
+        if (header.m_paletteSize == 0 || header.m_paletteSize > 256 || size < sizeof(header) + header.m_paletteSize)
+            {
+                return false;
+            }
+
+        if (header.m_sizeX == 0 || header.m_sizeY == 0 || header.m_sizeZ == 0 ||
+            header.m_sizeX > c_maxSerialisedSize || header.m_sizeY > c_maxSerialisedSize || header.m_sizeZ > c_maxSerialisedSize)
+            {
+                return false;
+            }
+
+        const uint64_t headerVolume = static_cast<uint64_t>(header.m_sizeX) * header.m_sizeY * header.m_sizeZ;
+        if (headerVolume > c_maxSerialisedVolume)
+            {
+                return false;
+            }
+
+        // the runs need an index byte and the LEB128 length of the volume at the very least
+        std::size_t minimumRunSize = 2;
+        for (uint64_t length = headerVolume >> 7; length; length >>= 7)
+            {
+                minimumRunSize++;
+            }
+        if (size - sizeof(header) - header.m_paletteSize < minimumRunSize)
+            {
+                return false;
+            }
+
+        create(header.m_sizeX, header.m_sizeY, header.m_sizeZ);
+        setVoxelSize(header.m_voxelSize);
+
+        const uint8_t *palette = data + sizeof(header);
+        m_palette.assign(reinterpret_cast<const voxelType*>(palette), reinterpret_cast<const voxelType*>(palette) + header.m_paletteSize);
+
+        unsigned int bitsPerIndex = 0;
+        while ((1u << bitsPerIndex) < m_palette.size())
+            {
+                bitsPerIndex = bitsPerIndex == 0 ? 1 : bitsPerIndex * 2;
+            }
+        if (bitsPerIndex != 0)
+            {
+                setIndexWidth(bitsPerIndex);
+            }
+
+        const uint8_t *read = palette + header.m_paletteSize;
+        const uint8_t *end = data + size;
+        const sizeType volume = getVolume();
+        sizeType i = 0;
+        while (i < volume)
+            {
+                if (read >= end)
+                    {
+                        create(0, 0, 0);
+                        return false;
+                    }
+
+                const unsigned int paletteIndex = *read++;
+                sizeType runLength = 0;
+                unsigned int shift = 0;
+                bool terminated = false;
+                while (read < end && shift < 64)
+                    {
+                        const uint8_t byte = *read++;
+                        runLength |= static_cast<sizeType>(byte & 0x7f) << shift;
+                        shift += 7;
+                        if (!(byte & 0x80))
+                            {
+                                terminated = true;
+                                break;
+                            }
+                    }
+
+                if (!terminated || paletteIndex >= m_palette.size() || runLength > volume - i)
+                    {
+                        create(0, 0, 0);
+                        return false;
+                    }
+
+                if (m_bitsPerIndex != 0 && paletteIndex != 0)
+                    {
+                        for (sizeType j = i; j < i + runLength; j++)
+                            {
+                                const unsigned int bitShift = static_cast<unsigned int>(j & ((1ull << m_indicesPerWordShift) - 1)) * m_bitsPerIndex;
+                                m_indices[j >> m_indicesPerWordShift] |= static_cast<uint64_t>(paletteIndex) << bitShift;
+                            }
+                    }
+                i += runLength;
+            }
+
+        return true;
     }
 
 void voxelChunk::setVoxelSize(float size)
@@ -102,6 +427,11 @@ float voxelChunk::getVoxelSize() const
     }
 
 void voxelChunk::mesh(std::vector<quad> &quads) const
+    {
+        mesh(quads, {});
+    }
+
+void voxelChunk::mesh(std::vector<quad> &quads, const voxelChunk::neighbourList &neighbours) const
     {
         OPTICK_EVENT();
         for (int y = 0; y < m_sizeY; y++)
@@ -110,26 +440,33 @@ void voxelChunk::mesh(std::vector<quad> &quads) const
                     {
                         for (int z = 0; z < m_sizeZ; z++)
                             {
-                                meshAtPosition(quads, x, y, z);
+                                meshAtPosition(quads, x, y, z, neighbours);
                             }
                     }
             }
     }
 
 void voxelChunk::meshAtPosition(std::vector<quad> &quads, voxelChunk::sizeType x, voxelChunk::sizeType y, voxelChunk::sizeType z) const
+    {
+        meshAtPosition(quads, x, y, z, {});
+    }
+
+void voxelChunk::meshAtPosition(std::vector<quad> &quads, voxelChunk::sizeType x, voxelChunk::sizeType y, voxelChunk::sizeType z, const voxelChunk::neighbourList &neighbours) const
     {
         if (!withinBounds(x, y, z) || at(x, y, z) == voxelType::NONE) { return; }
         float posX = x * m_voxelSize;
         float posY = y * m_voxelSize;
         float posZ = z * m_voxelSize;
 
+        const unsigned char visibleFaces = getVisibleFaces(x, y, z, neighbours);
+
         quad q = {};
         q.m_colour = {1.f, 1.f, 1.f};
         if (at(x, y, z) == voxelType::TEST_1) { q.m_colour = {0.f, 0.f, 0.f}; }
 
         q.m_size = { m_voxelSize, m_voxelSize };
         // front/back plane
-        if ((z + 1) >= m_sizeZ || at(x, y, z + 1) == voxelType::NONE)
+        if (visibleFaces & (1 << 0))
             {
                 q.m_orientation = 1;
                 q.m_position.x = posX;
@@ -138,7 +475,7 @@ void voxelChunk::meshAtPosition(std::vector<quad> &quads, voxelChunk::sizeType x
                 quads.push_back(q);
             }
 
-        if (z <= 0 || at(x, y, z - 1) == voxelType::NONE)
+        if (visibleFaces & (1 << 1))
             {
                 q.m_orientation = -1;
                 q.m_position.x = posX;
@@ -148,7 +485,7 @@ void voxelChunk::meshAtPosition(std::vector<quad> &quads, voxelChunk::sizeType x
             }
 
         // top/bottom plane
-        if (y <= 0 || at(x, y - 1, z) == voxelType::NONE)
+        if (visibleFaces & (1 << 2))
             {
                 q.m_orientation = 2;
                 q.m_position.x = posX;
@@ -157,7 +494,7 @@ void voxelChunk::meshAtPosition(std::vector<quad> &quads, voxelChunk::sizeType x
                 quads.push_back(q);
             }
 
-        if ((y + 1) >= m_sizeY || at(x, y + 1, z) == voxelType::NONE)
+        if (visibleFaces & (1 << 3))
             {
                 q.m_orientation = -2;
                 q.m_position.x = posX;
@@ -167,7 +504,7 @@ void voxelChunk::meshAtPosition(std::vector<quad> &quads, voxelChunk::sizeType x
             }
 
         // left/right plane
-        if ((x + 1) >= m_sizeX || at(x + 1, y, z) == voxelType::NONE)
+        if (visibleFaces & (1 << 4))
             {
                 q.m_orientation = 3;
                 q.m_position.x = posY;
@@ -176,7 +513,7 @@ void voxelChunk::meshAtPosition(std::vector<quad> &quads, voxelChunk::sizeType x
                 quads.push_back(q);
             }
 
-        if (x <= 0 || at(x - 1, y, z) == voxelType::NONE)
+        if (visibleFaces & (1 << 5))
             {
                 q.m_orientation = -3;
                 q.m_position.x = posY;
@@ -186,7 +523,124 @@ void voxelChunk::meshAtPosition(std::vector<quad> &quads, voxelChunk::sizeType x
             }
     }
 
+void voxelChunk::meshAtPosition(std::vector<packedFace> &faces, voxelChunk::sizeType x, voxelChunk::sizeType y, voxelChunk::sizeType z, voxelChunk::sizeType originX, voxelChunk::sizeType originY, voxelChunk::sizeType originZ, const voxelChunk::neighbourList &neighbours) const
+    {
+        if (!withinBounds(x, y, z) || at(x, y, z) == voxelType::NONE) { return; }
+
+        const unsigned char visibleFaces = getVisibleFaces(x, y, z, neighbours);
+        if (visibleFaces == 0) { return; }
+
+        // offset of the face corner from the voxel corner for each orientation
+        constexpr unsigned int cornerOffsets[6][3] = {
+            { 0, 0, 1 },
+            { 0, 0, 0 },
+            { 0, 0, 0 },
+            { 0, 1, 0 },
+            { 1, 0, 0 },
+            { 0, 0, 0 }
+        };
+
+        const unsigned int localX = static_cast<unsigned int>(x - originX);
+        const unsigned int localY = static_cast<unsigned int>(y - originY);
+        const unsigned int localZ = static_cast<unsigned int>(z - originZ);
+        const unsigned int material = static_cast<unsigned int>(at(x, y, z));
+
+        for (unsigned int i = 0; i < 6; i++)
+            {
+                if (visibleFaces & (1 << i))
+                    {
+                        faces.push_back(packedFace::create(localX + cornerOffsets[i][0], localY + cornerOffsets[i][1], localZ + cornerOffsets[i][2], i, 1, 1, material));
+                    }
+            }
+    }
+
+unsigned char voxelChunk::getVisibleFaces(voxelChunk::sizeType x, voxelChunk::sizeType y, voxelChunk::sizeType z, const voxelChunk::neighbourList &neighbours) const
+    {
+        const int ix = static_cast<int>(x);
+        const int iy = static_cast<int>(y);
+        const int iz = static_cast<int>(z);
+
+        unsigned char visibleFaces = 0;
+        visibleFaces |= emptyAt(ix, iy, iz + 1, neighbours) << 0;
+        visibleFaces |= emptyAt(ix, iy, iz - 1, neighbours) << 1;
+        visibleFaces |= emptyAt(ix, iy - 1, iz, neighbours) << 2;
+        visibleFaces |= emptyAt(ix, iy + 1, iz, neighbours) << 3;
+        visibleFaces |= emptyAt(ix + 1, iy, iz, neighbours) << 4;
+        visibleFaces |= emptyAt(ix - 1, iy, iz, neighbours) << 5;
+
+        return visibleFaces;
+    }
+
 bool voxelChunk::withinBounds(voxelChunk::sizeType x, voxelChunk::sizeType y, voxelChunk::sizeType z) const
     {
         return (x >= 0 && x < m_sizeX) && (y >= 0 && y < m_sizeY) && (z >= 0 && z < m_sizeZ);
     }
+
+bool voxelChunk::emptyAt(int x, int y, int z, const voxelChunk::neighbourList &neighbours) const
+    {
+        return typeAt(x, y, z, neighbours) == voxelType::NONE;
+    }
+
+voxelType voxelChunk::typeAt(int x, int y, int z, const voxelChunk::neighbourList &neighbours) const
+    {
+        const voxelChunk *chunk = this;
+        if (x >= static_cast<int>(m_sizeX))
+            {
+                chunk = neighbours[0];
+                x -= static_cast<int>(m_sizeX);
+            }
+        else if (x < 0)
+            {
+                chunk = neighbours[1];
+                x += chunk ? static_cast<int>(chunk->m_sizeX) : 0;
+            }
+        else if (y >= static_cast<int>(m_sizeY))
+            {
+                chunk = neighbours[2];
+                y -= static_cast<int>(m_sizeY);
+            }
+        else if (y < 0)
+            {
+                chunk = neighbours[3];
+                y += chunk ? static_cast<int>(chunk->m_sizeY) : 0;
+            }
+        else if (z >= static_cast<int>(m_sizeZ))
+            {
+                chunk = neighbours[4];
+                z -= static_cast<int>(m_sizeZ);
+            }
+        else if (z < 0)
+            {
+                chunk = neighbours[5];
+                z += chunk ? static_cast<int>(chunk->m_sizeZ) : 0;
+            }
+
+        if (!chunk || x < 0 || y < 0 || z < 0 || !chunk->withinBounds(x, y, z))
+            {
+                return voxelType::NONE;
+            }
+
+        return chunk->at(x, y, z);
+    }
+
+voxelChunk::reference::reference(voxelChunk &chunk, sizeType index) :
+    m_chunk(chunk),
+    m_index(index)
+    {
+    }
+
+voxelChunk::reference::operator voxelType() const
+    {
+        return m_chunk.get(m_index);
+    }
+
+voxelChunk::reference &voxelChunk::reference::operator=(voxelType type)
+    {
+        m_chunk.set(m_index, type);
+        return *this;
+    }
+
+voxelChunk::reference &voxelChunk::reference::operator=(const reference &rhs)
+    {
+        return *this = static_cast<voxelType>(rhs);
+    }
@@ -0,0 +1,185 @@
+#include "voxel/voxelRegion.hpp"
+#include "voxel/voxelChunk.hpp"
+#include <glm/common.hpp>
+#include <optick.h>
+#include <cstring>
+#include <algorithm>
+
+bool voxelRegion::map()
+    {
+        if (!m_file.map())
+            {
+                return false;
+            }
+
+        // a file too short for its index table is treated as unreadable
+        if (m_file.getMappedSize() < c_dataOffset)
+            {
+                m_file.unmap();
+                return false;
+            }
+
+        m_mappedEnd = m_dataEnd;
+        return true;
+    }
+
+std::size_t voxelRegion::getEntryIndex(const glm::ivec3 &chunkPosition) const
+    {
+        const glm::ivec3 regionPosition = getRegionPosition(chunkPosition);
+        const int x = chunkPosition.x - regionPosition.x * c_regionSize;
+        const int z = chunkPosition.z - regionPosition.z * c_regionSize;
+        return static_cast<std::size_t>(x + z * c_regionSize);
+    }
+
+voxelRegion::indexEntry voxelRegion::getEntry(const glm::ivec3 &chunkPosition) const
+    {
+        return m_index.empty() ? indexEntry{} : m_index[getEntryIndex(chunkPosition)];
+    }
+
+voxelRegion::~voxelRegion()
+    {
+        close();
+    }
+
+bool voxelRegion::open(const char *file)
+    {
+        OPTICK_EVENT();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_path = file;
+
+        if (!m_file.open(file))
+            {
+                return false;
+            }
+
+        if (m_file.getFileSize() == 0)
+            {
+                header fileHeader;
+                std::vector<indexEntry> index(c_regionSize * c_regionSize);
+                m_file.writeAt(0, &fileHeader, sizeof(fileHeader));
+                m_file.writeAt(c_indexOffset, index.data(), index.size() * sizeof(indexEntry));
+            }
+
+        if (!map())
+            {
+                return false;
+            }
+
+        header fileHeader;
+        std::memcpy(&fileHeader, m_file.getData(), sizeof(fileHeader));
+        if (fileHeader.m_magic != c_magic || fileHeader.m_version != c_version || fileHeader.m_regionSize != c_regionSize)
+            {
+                // <error>
+                m_file.unmap();
+                return false;
+            }
+
+        // the tail of the file may be spare capacity, so the data ends after the furthest blob
+        m_index.resize(c_regionSize * c_regionSize);
+        std::memcpy(m_index.data(), m_file.getData() + c_indexOffset, m_index.size() * sizeof(indexEntry));
+        m_dataEnd = c_dataOffset;
+        for (const indexEntry &entry : m_index)
+            {
+                m_dataEnd = std::max<uint64_t>(m_dataEnd, entry.m_offset + entry.m_size);
+            }
+        m_mappedEnd = m_dataEnd;
+        return true;
+    }
+
+void voxelRegion::close()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_file.close();
+        m_index.clear();
+        m_dataEnd = 0;
+        m_mappedEnd = 0;
+    }
+
+bool voxelRegion::isOpen() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_file.isMapped();
+    }
+
+bool voxelRegion::contains(const glm::ivec3 &chunkPosition) const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return getEntry(chunkPosition).m_offset != 0;
+    }
+
+bool voxelRegion::read(const glm::ivec3 &chunkPosition, voxelChunk &chunk) const
+    {
+        OPTICK_EVENT();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const indexEntry entry = getEntry(chunkPosition);
+        if (entry.m_offset == 0 || entry.m_offset + entry.m_size > m_dataEnd)
+            {
+                return false;
+            }
+
+        if (entry.m_offset + entry.m_size <= m_mappedEnd)
+            {
+                return chunk.deserialise(m_file.getData() + entry.m_offset, entry.m_size);
+            }
+
+        // written after the mapping was built, so it may not show through it yet
+        std::vector<uint8_t> blob(entry.m_size);
+        return m_file.readAt(entry.m_offset, blob.data(), blob.size()) && chunk.deserialise(blob.data(), blob.size());
+    }
+
+bool voxelRegion::write(const glm::ivec3 &chunkPosition, const voxelChunk &chunk)
+    {
+        OPTICK_EVENT();
+        std::vector<uint8_t> blob;
+        chunk.serialise(blob);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_file.isMapped())
+            {
+                return false;
+            }
+
+        const std::size_t entryIndex = getEntryIndex(chunkPosition);
+        indexEntry entry;
+        entry.m_offset = m_dataEnd;
+        entry.m_size = static_cast<uint32_t>(blob.size());
+
+        // the mapping can not grow with the file, so it is only rebuilt when the spare capacity runs out
+        const uint64_t capacity = m_file.getFileSize();
+        if (entry.m_offset + entry.m_size > capacity)
+            {
+                const bool grown = m_file.resize(std::max(capacity * 2, entry.m_offset + entry.m_size));
+                if (!map() || !grown)
+                    {
+                        return false;
+                    }
+            }
+
+        // blob first, so a failed write never leaves the entry pointing at garbage
+        bool written = m_file.writeAt(entry.m_offset, blob.data(), blob.size());
+        if (written)
+            {
+                written = m_file.writeAt(c_indexOffset + entryIndex * sizeof(indexEntry), &entry, sizeof(entry));
+            }
+
+        if (written)
+            {
+                m_index[entryIndex] = entry;
+                m_dataEnd = entry.m_offset + entry.m_size;
+            }
+        return written;
+    }
+
+glm::ivec3 voxelRegion::getRegionPosition(const glm::ivec3 &chunkPosition)
+    {
+        return {
+            static_cast<int>(glm::floor(chunkPosition.x / static_cast<float>(c_regionSize))),
+            chunkPosition.y,
+            static_cast<int>(glm::floor(chunkPosition.z / static_cast<float>(c_regionSize)))
+        };
+    }
+
+std::string voxelRegion::getFileName(const glm::ivec3 &regionPosition)
+    {
+        return "r." + std::to_string(regionPosition.x) + "." + std::to_string(regionPosition.y) + "." + std::to_string(regionPosition.z) + ".vxr";
+    }
@@ -1,6 +1,5 @@
 #include "voxel/voxelSpace.hpp"
-#include "graphics/vertex.hpp"
-#include "graphics/quad.hpp"
+#include "graphics/packedFace.hpp"
 #include "graphics/descriptorSet.hpp"
 #include "typeDefines.hpp"
 #include "random.hpp"
@@ -9,371 +8,1770 @@
 #include <vk_mem_alloc.h>
 #include <vector>
 #include <array>
+#include <algorithm>
 #include <glm/gtx/quaternion.hpp>
+#include <glm/gtx/norm.hpp>
+#include <filesystem>
+#include <fstream>
+#include <limits>
 
 #include "taskGraph.hpp"
+#include "taskScheduler.hpp"
 #include "task.hpp"
 #include <optick.h>
 
-void voxelSpace::updateSubChunkMemory(chunkVoxelData &voxelData)
+constexpr VkDeviceSize alignTo(VkDeviceSize value, VkDeviceSize alignment) noexcept
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+void voxelSpace::allocateSubChunk(chunkData *chunk, std::size_t subChunkIndex)
     {
         OPTICK_EVENT();
-        unsigned long long indexSize = voxelData.m_indexCount * sizeof(fe::index);
-        unsigned long long vertexSize = voxelData.m_vertexCount * sizeof(vertex);
+        chunkVoxelData &voxelData = chunk->m_voxelData[subChunkIndex];
+        m_boundsDirty = true;
+        // never written in place. Frames in flight may still be drawing the old range
+        if (voxelData.m_allocation.valid())
+            {
+                m_localBuffer.release(voxelData.m_allocation, voxelData.m_drawIndex);
+                voxelData.m_allocation = {};
+            }
+
+        if (voxelData.m_faceCount == 0)
+            {
+                return;
+            }
 
-        std::memcpy(voxelData.m_indexStagingBuffer, voxelData.m_indices.data(), indexSize);
-        std::memcpy(voxelData.m_vertexStagingBuffer, voxelData.m_vertices.data(), vertexSize);
-        m_localBuffer.m_needUpdate = true;
+        voxelData.m_allocation = m_localBuffer.allocateFaces(voxelData.m_faceCount);
+        voxelData.m_drawIndex = m_localBuffer.allocateDrawIndex();
+
+        const glm::vec3 chunkOrigin(chunk->m_positionX, chunk->m_positionY, chunk->m_positionZ);
+        const float voxelSize = chunk->m_chunk.getVoxelSize();
+        const float faceScale = voxelSize * static_cast<float>(1 << chunk->m_lod);
+        const VkDeviceSize originOffset = m_localBuffer.m_originOffset + voxelData.m_drawIndex * sizeof(glm::vec4);
+        glm::vec4 *origin = reinterpret_cast<glm::vec4*>(static_cast<fe::uInt8*>(m_localBuffer.m_cpuStagingBuffer) + originOffset);
+        *origin = glm::vec4(chunkOrigin + glm::vec3(getSubChunkPosition(*chunk, subChunkIndex)) * voxelSize, faceScale);
+
+        m_localBuffer.markDirty(originOffset, sizeof(glm::vec4));
+        m_localBuffer.markDirty(m_localBuffer.m_faceOffset + voxelData.m_allocation.m_offset * sizeof(packedFace), voxelData.m_faceCount * sizeof(packedFace));
     }
 
-void voxelSpace::updateChunkMemory(chunkData &chunk)
+void voxelSpace::writeSubChunkMemory(chunkVoxelData *voxelData)
     {
         OPTICK_EVENT();
-        OPTICK_TAG("Preset Buffers | Voxel Data Count:", chunk.m_voxelData.size());
-        for (auto &voxelData : chunk.m_voxelData)
+        if (!voxelData->m_allocation.valid())
+            {
+                return;
+            }
+
+        fe::uInt8 *faces = static_cast<fe::uInt8*>(m_localBuffer.m_cpuStagingBuffer) + m_localBuffer.m_faceOffset + voxelData->m_allocation.m_offset * sizeof(packedFace);
+        std::memcpy(faces, voxelData->m_faces.data(), voxelData->m_faceCount * sizeof(packedFace));
+    }
+
+// bit i is set for every boundary of the box the position lies on, ordered like voxelChunk::neighbourList
+static unsigned char getBoundaryFaces(const glm::ivec3 &position, const glm::ivec3 &size)
+    {
+        unsigned char faces = 0;
+        faces |= (position.x == size.x - 1) << 0;
+        faces |= (position.x == 0) << 1;
+        faces |= (position.y == size.y - 1) << 2;
+        faces |= (position.y == 0) << 3;
+        faces |= (position.z == size.z - 1) << 4;
+        faces |= (position.z == 0) << 5;
+        return faces;
+    }
+
+static int getSolidCellIndex(const glm::ivec3 &positionInSubChunk, int cellSize, int cellsPerSide)
+    {
+        const glm::ivec3 cell = positionInSubChunk / cellSize;
+        return cell.x + cellsPerSide * (cell.y + cellsPerSide * cell.z);
+    }
+
+static glm::ivec3 floorDivide(const glm::ivec3 &value, const glm::ivec3 &divisor)
+    {
+        return {
+            value.x >= 0 ? value.x / divisor.x : (value.x - divisor.x + 1) / divisor.x,
+            value.y >= 0 ? value.y / divisor.y : (value.y - divisor.y + 1) / divisor.y,
+            value.z >= 0 ? value.z / divisor.z : (value.z - divisor.z + 1) / divisor.z
+        };
+    }
+
+void voxelSpace::updateSubChunkMemory(chunkData &chunk, std::size_t subChunkIndex)
+    {
+        allocateSubChunk(&chunk, subChunkIndex);
+        writeSubChunkMemory(&chunk.m_voxelData[subChunkIndex]);
+    }
+
+void voxelSpace::createChunk(chunkData &chunk, const voxelChunk::sizeType sizeX, const voxelChunk::sizeType sizeY, const voxelChunk::sizeType sizeZ, const int posX, const int posY, const int posZ)
+    {
+        chunk.m_chunk.create(sizeX, sizeY, sizeZ);
+        chunk.m_chunk.setVoxelSize(c_voxelSize);
+        chunk.m_generationBuffer.assign(chunk.m_chunk.getVolume(), voxelType::NONE);
+
+        voxelChunk::sizeType subChunkCountX = static_cast<voxelChunk::sizeType>(std::ceil(static_cast<float>(sizeX) / c_chunkSubSize));
+        voxelChunk::sizeType subChunkCountY = static_cast<voxelChunk::sizeType>(std::ceil(static_cast<float>(sizeY) / c_chunkSubSize));
+        voxelChunk::sizeType subChunkCountZ = static_cast<voxelChunk::sizeType>(std::ceil(static_cast<float>(sizeZ) / c_chunkSubSize));
+
+        chunk.m_voxelData.resize(static_cast<std::size_t>(subChunkCountX * subChunkCountY * subChunkCountZ));
+        chunk.m_subSize = c_chunkSubSize;
+
+        chunk.m_sizeX = sizeX;
+        chunk.m_sizeY = sizeY;
+        chunk.m_sizeZ = sizeZ;
+
+        chunk.m_positionX = posX;
+        chunk.m_positionY = posY;
+        chunk.m_positionZ = posZ;
+    }
+
+void voxelSpace::finishChunkGeneration(chunkData *chunk)
+    {
+        OPTICK_EVENT();
+        // slices are generated in parallel so they write into a flat buffer. Packed storage can not be written from several threads.
+        // Chunks loaded from disk have already released theirs
+        if (!chunk->m_generationBuffer.empty())
+            {
+                chunk->m_chunk.assign(chunk->m_generationBuffer.data());
+            }
+        std::vector<voxelType>().swap(chunk->m_generationBuffer);
+        chunk->m_generated = true;
+    }
+
+void voxelSpace::meshSubChunk(remeshJob *job)
+    {
+        OPTICK_CATEGORY("VoxelChunkCreation", Optick::Category::Rendering);
+        OPTICK_EVENT();
+        const chunkData &chunk = *job->m_chunk;
+        glm::ivec3 subChunkPosition = getSubChunkPosition(chunk, job->m_subChunkIndex);
+        voxelChunk::sizeType x = subChunkPosition.x;
+        voxelChunk::sizeType y = subChunkPosition.y;
+        voxelChunk::sizeType z = subChunkPosition.z;
+
+        glm::ivec3 chunkPosition{};
+        transformChunkSpace(glm::vec3(chunk.m_positionX, chunk.m_positionY, chunk.m_positionZ), chunkPosition);
+
+        const uint64_t key = getMeshKey(chunk, job->m_subChunkIndex, job->m_neighbours);
+        if (readCachedMesh(job->m_mesh, chunkPosition, job->m_subChunkIndex, key))
+            {
+                job->m_mesh.m_meshKey = key;
+                return;
+            }
+
+        if (chunk.m_lod > 0)
             {
-                updateSubChunkMemory(voxelData);
+                buildLodMesh(chunk, job->m_subChunkIndex, job->m_mesh, getNeighbours(job->m_neighbours));
             }
-        m_localBuffer.m_needUpdate = true;
+        else
+            {
+                buildChunkMesh(chunk, job->m_mesh, x, y, z, getNeighbours(job->m_neighbours));
+            }
+
+        job->m_mesh.m_meshKey = key;
+    }
+
+void voxelSpace::meshDetachedSubChunk(chunkData *chunk, std::size_t subChunkIndex)
+    {
+        OPTICK_EVENT();
+        glm::ivec3 subChunkPosition = getSubChunkPosition(*chunk, subChunkIndex);
+        voxelChunk::sizeType x = subChunkPosition.x;
+        voxelChunk::sizeType y = subChunkPosition.y;
+        voxelChunk::sizeType z = subChunkPosition.z;
+
+        glm::ivec3 chunkPosition{};
+        transformChunkSpace(glm::vec3(chunk->m_positionX, chunk->m_positionY, chunk->m_positionZ), chunkPosition);
+
+        chunkVoxelData &voxelData = chunk->m_voxelData[subChunkIndex];
+        const uint64_t key = getMeshKey(*chunk, subChunkIndex, {});
+        voxelData.m_meshKey = key;
+        if (readCachedMesh(voxelData, chunkPosition, subChunkIndex, key))
+            {
+                return;
+            }
+
+        if (chunk->m_lod > 0)
+            {
+                buildLodMesh(*chunk, subChunkIndex, voxelData, {});
+            }
+        else
+            {
+                buildChunkMesh(*chunk, voxelData, x, y, z, {});
+            }
+
     }
 
-void voxelSpace::updateChunkMemory(chunkData &chunk, void *stagingBuffer, unsigned long long vertexBufferOffset, int &vertexOffset, int &indexOffset)
+void voxelSpace::buildLodMesh(const chunkData &chunk, std::size_t subChunkIndex, chunkVoxelData &voxelData, const voxelChunk::neighbourList &neighbours) const
     {
         OPTICK_EVENT();
-        fe::uInt8 *cpuStagingBuffer = static_cast<fe::uInt8*>(m_localBuffer.m_cpuStagingBuffer);
+        voxelData.m_faces.clear();
+        voxelData.m_faceCount = 0;
+        if (voxelData.m_solidCount == 0)
+            {
+                return;
+            }
+
+        const int factor = 1 << chunk.m_lod;
+        const glm::ivec3 origin = getSubChunkPosition(chunk, subChunkIndex);
+        const glm::ivec3 coarseSize = (getSubChunkSize(chunk, subChunkIndex) + factor - 1) / factor;
+
+        // one cell of padding on every side holds the downsampled neighbours. Coarse cells line up across chunks, so two
+        // neighbours at the same level agree on their shared border
+        const glm::ivec3 paddedSize = coarseSize + 2;
+        std::vector<voxelType> cells(static_cast<std::size_t>(paddedSize.x) * paddedSize.y * paddedSize.z, voxelType::NONE);
+        for (int z = -1; z <= coarseSize.z; z++)
+            {
+                for (int y = -1; y <= coarseSize.y; y++)
+                    {
+                        for (int x = -1; x <= coarseSize.x; x++)
+                            {
+                                const glm::ivec3 cell = { x, y, z };
+                                const glm::bvec3 outside = glm::lessThan(cell, glm::ivec3(0)) || glm::greaterThanEqual(cell, coarseSize);
+                                if (outside.x + outside.y + outside.z > 1)
+                                    {
+                                        // edges and corners of the padding are never sampled by the mesher
+                                        continue;
+                                    }
+
+                                int votes[static_cast<int>(voxelType::COUNT)] = {};
+                                const glm::ivec3 fineOrigin = origin + cell * factor;
+                                for (int fineZ = 0; fineZ < factor; fineZ++)
+                                    {
+                                        for (int fineY = 0; fineY < factor; fineY++)
+                                            {
+                                                for (int fineX = 0; fineX < factor; fineX++)
+                                                    {
+                                                        const glm::ivec3 fine = fineOrigin + glm::ivec3{ fineX, fineY, fineZ };
+                                                        votes[static_cast<int>(chunk.m_chunk.typeAt(fine.x, fine.y, fine.z, neighbours))]++;
+                                                    }
+                                            }
+                                    }
+
+                                // ties go to solid so thin terrain does not disappear at a distance. A solid cell takes the most common
+                                // non-empty type, the lowest one on a tie
+                                voxelType type = voxelType::NONE;
+                                if ((factor * factor * factor - votes[static_cast<int>(voxelType::NONE)]) * 2 >= factor * factor * factor)
+                                    {
+                                        int majority = static_cast<int>(voxelType::NONE) + 1;
+                                        for (int candidate = majority + 1; candidate < static_cast<int>(voxelType::COUNT); candidate++)
+                                            {
+                                                if (votes[candidate] > votes[majority])
+                                                    {
+                                                        majority = candidate;
+                                                    }
+                                            }
+                                        type = static_cast<voxelType>(majority);
+                                    }
+                                cells[(x + 1) + paddedSize.x * ((y + 1) + paddedSize.y * (z + 1))] = type;
+                            }
+                    }
+            }
+
+        voxelChunk coarse;
+        coarse.create(paddedSize.x, paddedSize.y, paddedSize.z);
+        coarse.assign(cells.data());
+        for (voxelChunk::sizeType y = 1; y <= static_cast<voxelChunk::sizeType>(coarseSize.y); y++)
+            {
+                for (voxelChunk::sizeType x = 1; x <= static_cast<voxelChunk::sizeType>(coarseSize.x); x++)
+                    {
+                        for (voxelChunk::sizeType z = 1; z <= static_cast<voxelChunk::sizeType>(coarseSize.z); z++)
+                            {
+                                coarse.meshAtPosition(voxelData.m_faces, x, y, z, 1, 1, 1, {});
+                            }
+                    }
+            }
+        voxelData.m_faceCount = voxelData.m_faces.size();
+    }
+
+void voxelSpace::destroyChunk(chunkData &chunk)
+    {
+        m_boundsDirty = true;
         for (auto &voxelData : chunk.m_voxelData)
             {
-                unsigned long long indexSize = voxelData.m_indexCount * sizeof(fe::index);
-                unsigned long long vertexSize = voxelData.m_vertexCount * sizeof(vertex);
+                if (voxelData.m_allocation.valid())
+                    {
+                        m_localBuffer.release(voxelData.m_allocation, voxelData.m_drawIndex);
+                        voxelData.m_allocation = {};
+                    }
+                voxelData.m_faces.clear();
+            }
+    }
+
+glm::ivec3 voxelSpace::getSubChunkCount(const chunkData &chunk) const
+    {
+        return {
+            static_cast<int>((chunk.m_sizeX + c_chunkSubSize - 1) / c_chunkSubSize),
+            static_cast<int>((chunk.m_sizeY + c_chunkSubSize - 1) / c_chunkSubSize),
+            static_cast<int>((chunk.m_sizeZ + c_chunkSubSize - 1) / c_chunkSubSize)
+        };
+    }
+
+std::size_t voxelSpace::getSubChunkIndex(const chunkData &chunk, glm::ivec3 localPosition) const
+    {
+        glm::ivec3 subChunkCount = getSubChunkCount(chunk);
+        glm::ivec3 subChunk = localPosition / static_cast<int>(c_chunkSubSize);
+        return subChunk.x + subChunkCount.x * (subChunk.y + subChunkCount.y * subChunk.z);
+    }
+
+glm::ivec3 voxelSpace::getSubChunkPosition(const chunkData &chunk, std::size_t subChunkIndex) const
+    {
+        glm::ivec3 subChunkCount = getSubChunkCount(chunk);
+        glm::ivec3 subChunk = {
+            subChunkIndex % subChunkCount.x,
+            (subChunkIndex / subChunkCount.x) % subChunkCount.y,
+            subChunkIndex / (subChunkCount.x * subChunkCount.y)
+        };
+
+        return subChunk * static_cast<int>(chunk.m_subSize);
+    }
+
+glm::ivec3 voxelSpace::getSubChunkSize(const chunkData &chunk, std::size_t subChunkIndex) const
+    {
+        const glm::ivec3 chunkSize = { chunk.m_sizeX, chunk.m_sizeY, chunk.m_sizeZ };
+        return glm::min(glm::ivec3(static_cast<int>(chunk.m_subSize)), chunkSize - getSubChunkPosition(chunk, subChunkIndex));
+    }
+
+unsigned char voxelSpace::getOpenFaces(const chunkData &chunk, std::size_t subChunkIndex) const
+    {
+        const glm::ivec3 origin = getSubChunkPosition(chunk, subChunkIndex);
+        const glm::ivec3 size = getSubChunkSize(chunk, subChunkIndex);
+
+        auto layerOpen = [&](int face) {
+            const int axis = face / 2;
+            const int u = (axis + 1) % 3;
+            const int v = (axis + 2) % 3;
+
+            glm::ivec3 position{};
+            position[axis] = face % 2 == 0 ? origin[axis] + size[axis] - 1 : origin[axis];
+            for (position[u] = origin[u]; position[u] < origin[u] + size[u]; position[u]++)
+                {
+                    for (position[v] = origin[v]; position[v] < origin[v] + size[v]; position[v]++)
+                        {
+                            if (chunk.m_chunk.at(position.x, position.y, position.z) == voxelType::NONE)
+                                {
+                                    return true;
+                                }
+                        }
+                }
+            return false;
+        };
+
+        unsigned char openFaces = 0;
+        for (int face = 0; face < 6; face++)
+            {
+                if (layerOpen(face))
+                    {
+                        openFaces |= 1 << face;
+                    }
+            }
+        return openFaces;
+    }
+
+void voxelSpace::summariseSubChunk(chunkData &chunk, std::size_t subChunkIndex)
+    {
+        OPTICK_EVENT();
+        chunkVoxelData &voxelData = chunk.m_voxelData[subChunkIndex];
+        const glm::ivec3 origin = getSubChunkPosition(chunk, subChunkIndex);
+        const glm::ivec3 size = getSubChunkSize(chunk, subChunkIndex);
+        const int volume = size.x * size.y * size.z;
+
+        int solidCount = 0;
+        int cellCounts[c_solidCellsPerSide * c_solidCellsPerSide * c_solidCellsPerSide] = {};
+        const bool uniform = chunk.m_chunk.uniform();
+        for (int z = 0; z < size.z; z++)
+            {
+                for (int y = 0; y < size.y; y++)
+                    {
+                        for (int x = 0; x < size.x; x++)
+                            {
+                                const glm::ivec3 position = origin + glm::ivec3{ x, y, z };
+                                // a uniform palette answers every voxel the same, so one lookup is enough
+                                const bool solid = uniform ? chunk.m_chunk.at(0, 0, 0) != voxelType::NONE : chunk.m_chunk.at(position.x, position.y, position.z) != voxelType::NONE;
+                                if (solid)
+                                    {
+                                        solidCount++;
+                                        cellCounts[getSolidCellIndex({ x, y, z }, c_solidCellSize, c_solidCellsPerSide)]++;
+                                    }
+                            }
+                    }
+            }
+
+        voxelData.m_solidCount = solidCount;
+        voxelData.m_allSolid = solidCount == volume;
+        voxelData.m_openFaces = voxelData.m_allSolid ? 0 : (uniform ? 0x3f : getOpenFaces(chunk, subChunkIndex));
+        voxelData.m_solidCells = 0;
+        for (int cell = 0; cell < c_solidCellsPerSide * c_solidCellsPerSide * c_solidCellsPerSide; cell++)
+            {
+                if (cellCounts[cell] == c_solidCellSize * c_solidCellSize * c_solidCellSize)
+                    {
+                        voxelData.m_solidCells |= 1ull << cell;
+                    }
+            }
+    }
+
+bool voxelSpace::solidCellFull(const chunkData &chunk, std::size_t subChunkIndex, int cell) const
+    {
+        const glm::ivec3 cellPosition = {
+            cell % c_solidCellsPerSide,
+            (cell / c_solidCellsPerSide) % c_solidCellsPerSide,
+            cell / (c_solidCellsPerSide * c_solidCellsPerSide)
+        };
+        const glm::ivec3 origin = getSubChunkPosition(chunk, subChunkIndex) + cellPosition * c_solidCellSize;
+        if (glm::any(glm::greaterThan(cellPosition * c_solidCellSize + c_solidCellSize, getSubChunkSize(chunk, subChunkIndex))))
+            {
+                return false;
+            }
+
+        for (int z = origin.z; z < origin.z + c_solidCellSize; z++)
+            {
+                for (int y = origin.y; y < origin.y + c_solidCellSize; y++)
+                    {
+                        for (int x = origin.x; x < origin.x + c_solidCellSize; x++)
+                            {
+                                if (chunk.m_chunk.at(x, y, z) == voxelType::NONE)
+                                    {
+                                        return false;
+                                    }
+                            }
+                    }
+            }
+        return true;
+    }
+
+const voxelSpace::chunkData *voxelSpace::findChunk(const glm::ivec3 &chunkPosition) const
+    {
+        const chunkData *chunk = m_loadedChunks.get(chunkPosition);
+        if (!chunk || !chunk->m_generated)
+            {
+                return nullptr;
+            }
+
+        return chunk;
+    }
+
+voxelChunk::neighbourList voxelSpace::getNeighbours(const std::array<const chunkData*, 6> &chunks)
+    {
+        voxelChunk::neighbourList neighbours{};
+        for (std::size_t i = 0; i < neighbours.size(); i++)
+            {
+                neighbours[i] = chunks[i] ? &chunks[i]->m_chunk : nullptr;
+            }
+
+        return neighbours;
+    }
+
+std::array<const voxelSpace::chunkData*, 6> voxelSpace::getNeighbourChunks(const glm::ivec3 &chunkPosition, unsigned int lod) const
+    {
+        std::array<const chunkData*, 6> neighbours = m_loadedChunks.getNeighbours(chunkPosition);
+        for (auto &neighbour : neighbours)
+            {
+                if (!neighbour || !neighbour->m_generated || neighbour->m_lod < lod)
+                    {
+                        neighbour = nullptr;
+                    }
+                else if (neighbour->m_lod > lod)
+                    {
+                        neighbour = &m_solidNeighbour;
+                    }
+            }
+
+        return neighbours;
+    }
+
+void voxelSpace::markDirtyAround(glm::ivec3 globalPosition)
+    {
+        // the voxel itself and its six neighbours can touch at most four sub-chunks
+        for (int i = -1; i < 6; i++)
+            {
+                glm::ivec3 position = globalPosition;
+                if (i >= 0)
+                    {
+                        position += c_neighbourDirections[i];
+                    }
+
+                glm::ivec3 chunkPosition{};
+                glm::vec3 localPosition{};
+                transformSpace(position, chunkPosition, localPosition);
+
+                chunkData *chunk = m_loadedChunks.get(chunkPosition);
+                if (!chunk)
+                    {
+                        continue;
+                    }
+
+                const std::size_t subChunkIndex = getSubChunkIndex(*chunk, localPosition);
+                chunkVoxelData &voxelData = chunk->m_voxelData[subChunkIndex];
+                if (!voxelData.m_dirty)
+                    {
+                        voxelData.m_dirty = true;
+                        m_dirtySubChunks.emplace_back(chunkPosition, subChunkIndex);
+                    }
+            }
+    }
+
+void voxelSpace::flushEdits(std::vector<std::pair<chunkData*, std::size_t>> &remesh)
+    {
+        OPTICK_EVENT();
+        // m_dirty stays set until the remesh is submitted so the job knows it came from an edit
+        for (auto &subChunk : m_dirtySubChunks)
+            {
+                chunkData *chunk = m_loadedChunks.get(subChunk.first);
+                if (chunk)
+                    {
+                        remesh.emplace_back(chunk, subChunk.second);
+                    }
+            }
+        m_dirtySubChunks.clear();
+    }
+
+void voxelSpace::getBorderSubChunks(const glm::ivec3 &chunkPosition, const glm::ivec3 &direction, std::vector<std::pair<chunkData*, std::size_t>> &subChunks)
+    {
+        chunkData *found = m_loadedChunks.get(chunkPosition);
+        if (!found)
+            {
+                return;
+            }
+
+        chunkData &chunk = *found;
+        glm::ivec3 subChunkCount = getSubChunkCount(chunk);
+        for (std::size_t i = 0; i < chunk.m_voxelData.size(); i++)
+            {
+                glm::ivec3 subChunk = {
+                    i % subChunkCount.x,
+                    (i / subChunkCount.x) % subChunkCount.y,
+                    i / (subChunkCount.x * subChunkCount.y)
+                };
+
+                bool onBorder = false;
+                for (int axis = 0; axis < 3; axis++)
+                    {
+                        if (direction[axis] > 0) { onBorder = subChunk[axis] == subChunkCount[axis] - 1; }
+                        if (direction[axis] < 0) { onBorder = subChunk[axis] == 0; }
+                    }
+
+                std::pair<chunkData*, std::size_t> border = { &chunk, i };
+                if (onBorder && std::find(subChunks.begin(), subChunks.end(), border) == subChunks.end())
+                    {
+                        subChunks.push_back(border);
+                    }
+            }
+    }
 
-                voxelData.m_indexStagingBuffer = cpuStagingBuffer + indexOffset;
-                voxelData.m_vertexStagingBuffer = cpuStagingBuffer + vertexBufferOffset + vertexOffset;
+void voxelSpace::submitRemesh(const std::vector<std::pair<chunkData*, std::size_t>> &subChunks)
+    {
+        OPTICK_EVENT();
+        OPTICK_TAG("Sub-chunk count", subChunks.size());
+        assert(m_remeshJobs.empty());
+        if (subChunks.empty())
+            {
+                return;
+            }
+
+        // every job is in place before the first task is added, so the tasks can point at them
+        m_remeshJobs.resize(subChunks.size());
+        for (std::size_t i = 0; i < subChunks.size(); i++)
+            {
+                remeshJob &job = m_remeshJobs[i];
+                chunkVoxelData &voxelData = subChunks[i].first->m_voxelData[subChunks[i].second];
+                glm::ivec3 chunkPosition{};
+                transformChunkSpace(glm::vec3(subChunks[i].first->m_positionX, subChunks[i].first->m_positionY, subChunks[i].first->m_positionZ), chunkPosition);
+
+                job.m_chunk = subChunks[i].first;
+                job.m_subChunkIndex = subChunks[i].second;
+                job.m_neighbours = getNeighbourChunks(chunkPosition, job.m_chunk->m_lod);
+                job.m_mesh.m_solidCount = voxelData.m_solidCount;
+                job.m_mesh.m_allSolid = voxelData.m_allSolid;
+                job.m_mesh.m_openFaces = voxelData.m_openFaces;
+                job.m_mesh.m_solidCells = voxelData.m_solidCells;
+                voxelData.m_dirty = false;
+            }
+
+        for (remeshJob &job : m_remeshJobs)
+            {
+                m_graph->addTask(task(this, &voxelSpace::meshSubChunk, &job), nullptr, "meshSubChunk");
+            }
+        m_remeshHandle = m_graph->submit();
+    }
+
+void voxelSpace::finishRemesh()
+    {
+        OPTICK_EVENT();
+        assert(m_remeshHandle.done());
+        if (m_remeshJobs.empty())
+            {
+                return;
+            }
 
-                indexOffset += indexSize;
-                vertexOffset += vertexSize;
+        m_graph->clear();
+        for (remeshJob &job : m_remeshJobs)
+            {
+                chunkVoxelData &voxelData = job.m_chunk->m_voxelData[job.m_subChunkIndex];
+                voxelData.m_faces = std::move(job.m_mesh.m_faces);
+                voxelData.m_faceCount = job.m_mesh.m_faceCount;
+                voxelData.m_meshKey = job.m_mesh.m_meshKey;
+                updateSubChunkMemory(*job.m_chunk, job.m_subChunkIndex);
+            }
+        m_remeshJobs.clear();
+    }
+
+voxelRegion *voxelSpace::getRegion(const glm::ivec3 &chunkPosition)
+    {
+        if (m_saveDirectory.empty())
+            {
+                return nullptr;
+            }
+
+        const glm::ivec3 regionPosition = voxelRegion::getRegionPosition(chunkPosition);
+        std::lock_guard<std::mutex> lock(m_regionMutex);
+        std::unique_ptr<voxelRegion> &region = m_regions[regionPosition];
+        if (!region)
+            {
+                region = std::make_unique<voxelRegion>();
+                region->open((std::filesystem::path(m_saveDirectory) / voxelRegion::getFileName(regionPosition)).string().c_str());
             }
 
-        updateChunkMemory(chunk);
+        return region->isOpen() ? region.get() : nullptr;
     }
 
-void voxelSpace::updateMemory()
-    {
-        OPTICK_EVENT();
-        // over-allocate for worst case scenario so that we can have set memory block sizes.
-        // ceil(n^3 / 2) will result in worst case voxel count. Multiply by 8 to get vertices. Multiply by 6*8 to get indices
-        unsigned int totalVertexCount = getVertexCount();
-        unsigned int totalIndexCount = getIndexCount();
+meshCache *voxelSpace::getMeshCache(const glm::ivec3 &chunkPosition)
+    {
+        if (!m_meshCacheEnabled || m_saveDirectory.empty())
+            {
+                return nullptr;
+            }
+
+        const glm::ivec3 regionPosition = voxelRegion::getRegionPosition(chunkPosition);
+        std::lock_guard<std::mutex> lock(m_regionMutex);
+        std::unique_ptr<meshCache> &cache = m_meshCaches[regionPosition];
+        if (!cache)
+            {
+                const glm::ivec3 subChunkCount = (c_chunkSize + static_cast<int>(c_chunkSubSize) - 1) / static_cast<int>(c_chunkSubSize);
+                cache = std::make_unique<meshCache>();
+                cache->open((std::filesystem::path(m_saveDirectory) / meshCache::getFileName(regionPosition)).string().c_str(), c_mesherVersion, subChunkCount.x * subChunkCount.y * subChunkCount.z);
+            }
+
+        return cache->isOpen() ? cache.get() : nullptr;
+    }
+
+uint64_t voxelSpace::getMeshKey(const chunkData &chunk, std::size_t subChunkIndex, const std::array<const chunkData*, 6> &neighbourChunks) const
+    {
+        if (!m_meshCacheEnabled || m_saveDirectory.empty())
+            {
+                return 0;
+            }
+
+        OPTICK_EVENT();
+        const glm::ivec3 subChunkMin = getSubChunkPosition(chunk, subChunkIndex);
+        const glm::ivec3 subChunkMax = subChunkMin + getSubChunkSize(chunk, subChunkIndex);
+        struct
+            {
+                glm::ivec3 m_min;
+                glm::ivec3 m_max;
+                uint32_t m_lod;
+                uint32_t m_mesherVersion;
+            } inputs = { subChunkMin, subChunkMax, chunk.m_lod, c_mesherVersion };
+        uint64_t key = meshCache::hash(&inputs, sizeof(inputs));
+
+        // the mesher reads one cell of (1 << lod) voxels past every face of the sub-chunk, but never past an edge or a corner.
+        // Voxels across a chunk boundary come from the same neighbours the mesher is given
+        const voxelChunk::neighbourList neighbours = getNeighbours(neighbourChunks);
+        const glm::ivec3 chunkSize = { chunk.m_sizeX, chunk.m_sizeY, chunk.m_sizeZ };
+        const int border = 1 << chunk.m_lod;
+        std::vector<voxelType> voxels;
+        voxels.reserve(static_cast<std::size_t>(subChunkMax.x - subChunkMin.x + 2 * border) * (subChunkMax.y - subChunkMin.y + 2 * border) * (subChunkMax.z - subChunkMin.z + 2 * border));
+        for (int z = subChunkMin.z - border; z < subChunkMax.z + border; z++)
+            {
+                for (int y = subChunkMin.y - border; y < subChunkMax.y + border; y++)
+                    {
+                        for (int x = subChunkMin.x - border; x < subChunkMax.x + border; x++)
+                            {
+                                const glm::ivec3 position = { x, y, z };
+                                const glm::bvec3 outside = glm::lessThan(position, subChunkMin) || glm::greaterThanEqual(position, subChunkMax);
+                                if (outside.x + outside.y + outside.z > 1)
+                                    {
+                                        continue;
+                                    }
+
+                                const bool inChunk = glm::all(glm::greaterThanEqual(position, glm::ivec3(0))) && glm::all(glm::lessThan(position, chunkSize));
+                                voxels.push_back(inChunk ? chunk.m_chunk.at(x, y, z) : chunk.m_chunk.typeAt(x, y, z, neighbours));
+                            }
+                    }
+            }
+        key = meshCache::hash(voxels.data(), voxels.size() * sizeof(voxelType), key);
+
+        // zero is reserved for meshes that are never cached
+        return key == 0 ? 1 : key;
+    }
+
+bool voxelSpace::readCachedMesh(chunkVoxelData &voxelData, const glm::ivec3 &chunkPosition, std::size_t subChunkIndex, uint64_t key)
+    {
+        if (key == 0)
+            {
+                return false;
+            }
+
+        meshCache *cache = getMeshCache(chunkPosition);
+        if (!cache || !cache->read(chunkPosition, subChunkIndex, key, voxelData.m_faces))
+            {
+                return false;
+            }
+
+        voxelData.m_faceCount = voxelData.m_faces.size();
+        return true;
+    }
+
+void voxelSpace::takeCacheWrites(chunkData &chunk, const glm::ivec3 &chunkPosition, std::vector<cacheWrite> &writes)
+    {
+        for (std::size_t i = 0; i < chunk.m_voxelData.size(); i++)
+            {
+                chunkVoxelData &voxelData = chunk.m_voxelData[i];
+                if (voxelData.m_meshKey == 0 || voxelData.m_faceCount == 0)
+                    {
+                        continue;
+                    }
+
+                cacheWrite &write = writes.emplace_back();
+                write.m_chunkPosition = chunkPosition;
+                write.m_subChunkIndex = i;
+                write.m_key = voxelData.m_meshKey;
+                write.m_faces = std::move(voxelData.m_faces);
+            }
+    }
+
+void voxelSpace::writeCachedMeshes(std::vector<cacheWrite> &writes)
+    {
+        OPTICK_EVENT();
+        for (cacheWrite &write : writes)
+            {
+                meshCache *cache = getMeshCache(write.m_chunkPosition);
+                if (cache)
+                    {
+                        cache->write(write.m_chunkPosition, write.m_subChunkIndex, write.m_key, write.m_faces.data(), write.m_faces.size());
+                    }
+            }
+        writes.clear();
+    }
+
+bool voxelSpace::loadChunk(chunkData &chunk, const glm::ivec3 &chunkPosition)
+    {
+        OPTICK_EVENT();
+        voxelRegion *region = getRegion(chunkPosition);
+        if (!region || !region->read(chunkPosition, chunk.m_chunk))
+            {
+                return false;
+            }
+
+        if (chunk.m_chunk.getSizeX() != chunk.m_sizeX || chunk.m_chunk.getSizeY() != chunk.m_sizeY || chunk.m_chunk.getSizeZ() != chunk.m_sizeZ)
+            {
+                // saved with a different chunk size. Regenerate instead
+                chunk.m_chunk.create(chunk.m_sizeX, chunk.m_sizeY, chunk.m_sizeZ);
+                chunk.m_chunk.setVoxelSize(c_voxelSize);
+                return false;
+            }
+
+        for (std::size_t i = 0; i < chunk.m_voxelData.size(); i++)
+            {
+                summariseSubChunk(chunk, i);
+            }
+
+        std::vector<voxelType>().swap(chunk.m_generationBuffer);
+        chunk.m_generated = true;
+        return true;
+    }
+
+void voxelSpace::saveChunk(const chunkData &chunk, const glm::ivec3 &chunkPosition)
+    {
+        OPTICK_EVENT();
+        voxelRegion *region = getRegion(chunkPosition);
+        if (region)
+            {
+                region->write(chunkPosition, chunk.m_chunk);
+            }
+    }
+
+bool voxelSpace::withinStreamingRadius(const glm::ivec3 &chunkPosition, const glm::ivec3 &centre, int radius) const
+    {
+        glm::ivec2 offset = { chunkPosition.x - centre.x, chunkPosition.z - centre.z };
+        return chunkPosition.y == 0 && offset.x * offset.x + offset.y * offset.y <= radius * radius;
+    }
+
+void voxelSpace::requestChunks(const glm::ivec3 &centre)
+    {
+        OPTICK_EVENT();
+        auto nearestFirst = [centre](const glm::ivec3 &lhs, const glm::ivec3 &rhs) {
+            return glm::length2(glm::vec3(lhs - centre)) > glm::length2(glm::vec3(rhs - centre));
+        };
+
+        std::lock_guard<std::mutex> lock(m_streamingMutex);
+
+        // anything that is still waiting to be generated but is now out of range is dropped
+        for (auto it = m_pendingChunks.begin(); it != m_pendingChunks.end();)
+            {
+                if (!withinStreamingRadius(*it, centre, m_streamingRadius))
+                    {
+                        m_requestedChunks.erase(*it);
+                        it = m_pendingChunks.erase(it);
+                    }
+                else
+                    {
+                        ++it;
+                    }
+            }
+
+        for (int x = centre.x - m_streamingRadius; x <= centre.x + m_streamingRadius; x++)
+            {
+                for (int z = centre.z - m_streamingRadius; z <= centre.z + m_streamingRadius; z++)
+                    {
+                        glm::ivec3 position = { x, 0, z };
+                        if (!withinStreamingRadius(position, centre, m_streamingRadius) || m_loadedChunks.contains(position) || m_requestedChunks.find(position) != m_requestedChunks.end())
+                            {
+                                continue;
+                            }
+
+                        m_requestedChunks.insert(position);
+                        m_pendingChunks.push_back(position);
+                    }
+            }
+
+        m_streamingCentre = centre;
+        std::make_heap(m_pendingChunks.begin(), m_pendingChunks.end(), nearestFirst);
+        m_streamingCondition.notify_one();
+    }
+
+bool voxelSpace::unloadChunks(const glm::ivec3 &centre, std::vector<std::pair<chunkData*, std::size_t>> &remesh)
+    {
+        OPTICK_EVENT();
+        // one chunk of slack so chunks on the edge of the radius do not thrash as the camera moves back and forth
+        std::vector<glm::ivec3> unloaded;
+        std::vector<cacheWrite> cacheWrites;
+        for (auto it = m_loadedChunks.begin(); it != m_loadedChunks.end();)
+            {
+                if (!withinStreamingRadius(it->first, centre, m_streamingRadius + 1))
+                    {
+                        if (it->second.m_modified)
+                            {
+                                saveChunk(it->second, it->first);
+                            }
+
+                        // edits to the chunk are already in its saved voxels, its mesh is not needed any more
+                        chunkData *chunk = &it->second;
+                        remesh.erase(std::remove_if(remesh.begin(), remesh.end(), [chunk](const auto &subChunk) { return subChunk.first == chunk; }), remesh.end());
+
+                        unloaded.push_back(it->first);
+                        takeCacheWrites(it->second, it->first, cacheWrites);
+                        destroyChunk(it->second);
+                        it = m_loadedChunks.erase(it);
+                    }
+                else
+                    {
+                        ++it;
+                    }
+            }
+
+        if (!cacheWrites.empty())
+            {
+                    {
+                        std::lock_guard<std::mutex> lock(m_streamingMutex);
+                        std::move(cacheWrites.begin(), cacheWrites.end(), std::back_inserter(m_pendingCacheWrites));
+                    }
+                m_streamingCondition.notify_one();
+            }
+
+        // neighbours used to cull against the unloaded chunks and now have exposed borders
+        for (auto &position : unloaded)
+            {
+                for (const auto &direction : c_neighbourDirections)
+                    {
+                        getBorderSubChunks(position + direction, -direction, remesh);
+                    }
+            }
+
+        return !unloaded.empty();
+    }
+
+bool voxelSpace::integrateChunks(const glm::ivec3 &centre, std::vector<std::pair<chunkData*, std::size_t>> &remesh, std::vector<std::pair<chunkData*, std::size_t>> &upload)
+    {
+        OPTICK_EVENT();
+        std::vector<std::pair<glm::ivec3, std::unique_ptr<chunkData>>> finished;
+            {
+                std::lock_guard<std::mutex> lock(m_streamingMutex);
+                std::size_t count = std::min<std::size_t>(m_integrationBudget, m_completedChunks.size());
+                std::move(m_completedChunks.begin(), m_completedChunks.begin() + count, std::back_inserter(finished));
+                m_completedChunks.erase(m_completedChunks.begin(), m_completedChunks.begin() + count);
+            }
+
+        bool integrated = false;
+        for (auto &chunk : finished)
+            {
+                m_requestedChunks.erase(chunk.first);
+                if (!withinStreamingRadius(chunk.first, centre, m_streamingRadius + 1))
+                    {
+                        continue;
+                    }
+
+                chunkData &loaded = m_loadedChunks.emplace(chunk.first, std::move(*chunk.second)).first->second;
+                integrated = true;
+                for (std::size_t i = 0; i < loaded.m_voxelData.size(); i++)
+                    {
+                        upload.emplace_back(&loaded, i);
+                    }
+
+                // the chunk was meshed as if it had no neighbours. Both sides of every shared face have to be redone
+                for (const auto &direction : c_neighbourDirections)
+                    {
+                        if (m_loadedChunks.contains(chunk.first + direction))
+                            {
+                                getBorderSubChunks(chunk.first, direction, remesh);
+                                getBorderSubChunks(chunk.first + direction, -direction, remesh);
+                            }
+                    }
+            }
+
+        return integrated;
+    }
+
+void voxelSpace::streamingLoop()
+    {
+        while (true)
+            {
+                std::vector<glm::ivec3> batch;
+                std::vector<cacheWrite> cacheWrites;
+                glm::ivec3 centre{};
+                    {
+                        std::unique_lock<std::mutex> lock(m_streamingMutex);
+                        m_streamingCondition.wait(lock, [this] { return !m_streaming || !m_pendingChunks.empty() || !m_pendingCacheWrites.empty(); });
+                        if (!m_streaming)
+                            {
+                                return;
+                            }
+
+                        cacheWrites.swap(m_pendingCacheWrites);
+
+                        centre = m_streamingCentre;
+                        auto nearestFirst = [centre](const glm::ivec3 &lhs, const glm::ivec3 &rhs) {
+                            return glm::length2(glm::vec3(lhs - centre)) > glm::length2(glm::vec3(rhs - centre));
+                        };
+
+                        while (!m_pendingChunks.empty() && batch.size() < c_streamingBatchSize)
+                            {
+                                std::pop_heap(m_pendingChunks.begin(), m_pendingChunks.end(), nearestFirst);
+                                batch.push_back(m_pendingChunks.back());
+                                m_pendingChunks.pop_back();
+                            }
+                    }
+
+                // meshes of unloaded chunks go out before the batch, which may be about to load the same chunks back
+                writeCachedMeshes(cacheWrites);
+                if (batch.empty())
+                    {
+                        continue;
+                    }
+
+                OPTICK_EVENT("voxelSpace::streamingLoop - batch");
+                std::vector<std::pair<glm::ivec3, std::unique_ptr<chunkData>>> generated;
+                for (auto &position : batch)
+                    {
+                        std::unique_ptr<chunkData> chunk = std::make_unique<chunkData>();
+                        createChunk(*chunk, c_chunkSize.x, c_chunkSize.y, c_chunkSize.z, position.x * c_chunkSize.x, position.y * c_chunkSize.y, position.z * c_chunkSize.z);
+                        // far chunks are meshed coarse straight away. update() settles the level against the real camera position
+                        chunk->m_lod = selectLod(glm::length(glm::vec2(position.x - centre.x, position.z - centre.z)), 0);
+
+                        if (loadChunk(*chunk, position))
+                            {
+                                for (std::size_t i = 0; i < chunk->m_voxelData.size(); i++)
+                                    {
+                                        m_streamingGraph->addTask(task(this, &voxelSpace::meshDetachedSubChunk, chunk.get(), i), nullptr, "meshDetachedSubChunk");
+                                    }
+
+                                generated.emplace_back(position, std::move(chunk));
+                                continue;
+                            }
+
+                        taskGraph::nodeHandle generatedNode = m_streamingGraph->addTask(task(this, &voxelSpace::finishChunkGeneration, chunk.get()), nullptr, "finishChunkGeneration");
+                        for (std::size_t i = 0; i < chunk->m_voxelData.size(); i++)
+                            {
+                                taskGraph::nodeHandle blockNode = m_streamingGraph->addTask(task(this, &voxelSpace::buildBlock, chunk.get(), i), nullptr, "buildBlock");
+                                m_streamingGraph->addParents(generatedNode, { blockNode });
+                            }
+
+                        for (std::size_t i = 0; i < chunk->m_voxelData.size(); i++)
+                            {
+                                m_streamingGraph->addTask(task(this, &voxelSpace::meshDetachedSubChunk, chunk.get(), i), generatedNode, "meshDetachedSubChunk");
+                            }
+
+                        generated.emplace_back(position, std::move(chunk));
+                    }
+
+                m_streamingGraph->execute(taskPriority::BACKGROUND);
+                m_streamingGraph->clear();
+
+                std::lock_guard<std::mutex> lock(m_streamingMutex);
+                std::move(generated.begin(), generated.end(), std::back_inserter(m_completedChunks));
+            }
+    }
+
+void voxelSpace::buildBlock(chunkData *chunk, std::size_t subChunkIndex)
+    {
+        OPTICK_EVENT();
+        const glm::ivec3 blockPosition = getSubChunkPosition(*chunk, subChunkIndex);
+        const glm::ivec3 blockSize = getSubChunkSize(*chunk, subChunkIndex);
+
+        std::vector<float> surface(static_cast<std::size_t>(blockSize.x) * blockSize.y * blockSize.z);
+        m_noise.fill(surface.data(), glm::ivec3{ chunk->m_positionX, chunk->m_positionY, chunk->m_positionZ } + blockPosition, blockSize);
+
+        // blocks line up with sub-chunks so the summary is gathered here rather than in a separate pass
+        int solidCount = 0;
+        int cellCounts[c_solidCellsPerSide * c_solidCellsPerSide * c_solidCellsPerSide] = {};
+        unsigned char openFaces = 0;
+        const float *value = surface.data();
+        for (int z = 0; z < blockSize.z; z++)
+            {
+                for (int y = 0; y < blockSize.y; y++)
+                    {
+                        voxelType *row = &chunk->m_generationBuffer[blockPosition.x + chunk->m_sizeX * ((blockPosition.y + y) + chunk->m_sizeY * (blockPosition.z + z))];
+                        for (int x = 0; x < blockSize.x; x++)
+                            {
+                                // noise is in [-1, 1], everything below the midpoint is solid
+                                if (*value++ < 0.f)
+                                    {
+                                        row[x] = voxelType::DEFAULT;
+                                        solidCount++;
+                                        cellCounts[getSolidCellIndex({ x, y, z }, c_solidCellSize, c_solidCellsPerSide)]++;
+                                    }
+                                else
+                                    {
+                                        row[x] = voxelType::NONE;
+                                        openFaces |= getBoundaryFaces({ x, y, z }, blockSize);
+                                    }
+                            }
+                    }
+            }
+
+        chunkVoxelData &voxelData = chunk->m_voxelData[subChunkIndex];
+        voxelData.m_solidCount = solidCount;
+        voxelData.m_allSolid = solidCount == blockSize.x * blockSize.y * blockSize.z;
+        voxelData.m_openFaces = openFaces;
+        voxelData.m_solidCells = 0;
+        for (int cell = 0; cell < c_solidCellsPerSide * c_solidCellsPerSide * c_solidCellsPerSide; cell++)
+            {
+                if (cellCounts[cell] == c_solidCellSize * c_solidCellSize * c_solidCellSize)
+                    {
+                        voxelData.m_solidCells |= 1ull << cell;
+                    }
+            }
+    }
+
+void voxelSpace::transformSpace(glm::vec3 globalPosition, glm::ivec3 &chunkPos, glm::vec3 &localPos) const
+    {
+        transformChunkSpace(globalPosition, chunkPos);
+        transformLocalSpace(globalPosition, localPos);
+    }
+
+void voxelSpace::transformChunkSpace(glm::vec3 globalPosition, glm::ivec3 &chunkPos) const
+    {
+        chunkPos = glm::floor(globalPosition / static_cast<glm::vec3>(c_chunkSize));
+    }
+
+void voxelSpace::transformLocalSpace(glm::vec3 globalPosition, glm::vec3 &localPos) const
+    {
+        localPos = glm::mod(globalPosition, static_cast<glm::vec3>(c_chunkSize));
+    }
+
+voxelSpace::~voxelSpace()
+    {
+        destroy();
+    }
+
+void voxelSpace::create()
+    {
+    }
+
+void voxelSpace::destroy()
+    {
+        if (m_streamingThread.joinable())
+            {
+                    {
+                        std::lock_guard<std::mutex> lock(m_streamingMutex);
+                        m_streaming = false;
+                    }
+                // update() no longer starts frames, so a batch waiting on the budget has to be let through
+                taskScheduler::get().setFrameBudget(std::chrono::microseconds(0));
+                m_streamingCondition.notify_one();
+                m_streamingThread.join();
+            }
+        m_remeshHandle.wait();
+        m_remeshHandle = {};
+        if (!m_remeshJobs.empty())
+            {
+                m_graph->clear();
+                m_remeshJobs.clear();
+            }
+
+        m_streamingGraph.reset();
+        m_pendingChunks.clear();
+        m_completedChunks.clear();
+        m_requestedChunks.clear();
+
+        // the streaming thread is gone, so whatever it did not write and the meshes of the chunks still loaded are written here
+        std::vector<cacheWrite> cacheWrites = std::move(m_pendingCacheWrites);
+        m_pendingCacheWrites.clear();
+        for (auto &chunk : m_loadedChunks)
+            {
+                if (chunk.second.m_modified)
+                    {
+                        saveChunk(chunk.second, chunk.first);
+                    }
+                takeCacheWrites(chunk.second, chunk.first, cacheWrites);
+                destroyChunk(chunk.second);
+            }
+        m_loadedChunks.clear();
+        writeCachedMeshes(cacheWrites);
+        m_regions.clear();
+        m_meshCaches.clear();
+        m_subChunkBounds.clear();
+        m_boundedSubChunks.clear();
+        m_visibleCount = 0;
+        m_localBuffer.destroy();
+    }
+
+void voxelSpace::createWorld(taskGraph *graph)
+    {
+        m_graph = graph;
+
+        const std::vector<voxelType> solid(static_cast<std::size_t>(c_chunkSize.x) * c_chunkSize.y * c_chunkSize.z, voxelType::DEFAULT);
+        m_solidNeighbour.m_chunk.create(c_chunkSize.x, c_chunkSize.y, c_chunkSize.z);
+        m_solidNeighbour.m_chunk.assign(solid.data());
+        m_solidNeighbour.m_generated = true;
+
+        m_noise.setSeed(loadSeed());
+        m_noise.setFrequency(0.05f);
+        m_noise.setFractalOctaves(5);
+        m_noise.setFractalLacunarity(2.f);
+        m_noise.setFractalGain(0.4f);
+
+        m_translation = glm::translate(glm::mat4(1.f), glm::vec3{0.f, 0.f, 0.f});
+        m_quaternion = glm::angleAxis(0.f, glm::normalize(glm::vec3{ 0, 1.f, 0.f }));
+
+        m_streamingGraph = std::make_unique<taskGraph>(256);
+        taskScheduler::get().setFrameBudget(c_streamingFrameBudget);
+        m_streaming = true;
+        m_streamingThread = std::thread(&voxelSpace::streamingLoop, this);
+    }
+
+unsigned int voxelSpace::selectLod(float distance, unsigned int currentLod) const
+    {
+        unsigned int lod = currentLod;
+        while (lod + 1 < c_lodLevels && distance > c_lodDistances[lod + 1] + c_lodHysteresis)
+            {
+                lod++;
+            }
+        while (lod > 0 && distance < c_lodDistances[lod] - c_lodHysteresis)
+            {
+                lod--;
+            }
+        return lod;
+    }
+
+bool voxelSpace::updateLods(const glm::vec3 &cameraPosition, std::vector<std::pair<chunkData*, std::size_t>> &remesh)
+    {
+        OPTICK_EVENT();
+        const glm::vec2 camera = glm::vec2(cameraPosition.x / c_chunkSize.x, cameraPosition.z / c_chunkSize.z);
+
+        bool changed = false;
+        for (auto &chunk : m_loadedChunks)
+            {
+                if (!chunk.second.m_generated)
+                    {
+                        continue;
+                    }
+
+                const glm::vec2 chunkCentre = glm::vec2(chunk.first.x, chunk.first.z) + 0.5f;
+                const unsigned int lod = selectLod(glm::length(chunkCentre - camera), chunk.second.m_lod);
+                if (lod == chunk.second.m_lod)
+                    {
+                        continue;
+                    }
+
+                chunk.second.m_lod = lod;
+                changed = true;
+                for (std::size_t i = 0; i < chunk.second.m_voxelData.size(); i++)
+                    {
+                        std::pair<chunkData*, std::size_t> subChunk = { &chunk.second, i };
+                        if (std::find(remesh.begin(), remesh.end(), subChunk) == remesh.end())
+                            {
+                                remesh.push_back(subChunk);
+                            }
+                    }
+
+                // neighbours either start or stop treating this chunk as solid across the shared border
+                for (const auto &direction : c_neighbourDirections)
+                    {
+                        getBorderSubChunks(chunk.first + direction, -direction, remesh);
+                    }
+            }
+
+        return changed;
+    }
+
+void voxelSpace::update(glm::vec3 cameraPosition)
+    {
+        OPTICK_EVENT();
+        glm::ivec3 centre{};
+        transformChunkSpace(cameraPosition, centre);
+        centre.y = 0;
+
+        if (!m_streamingCentreValid || centre != m_streamingCentre)
+            {
+                requestChunks(centre);
+                m_streamingCentreValid = true;
+            }
+
+        m_localBuffer.nextFrame();
+
+        // nothing that changes the loaded chunks may run while the remesh submitted by an earlier frame reads them
+        if (!m_remeshHandle.done())
+            {
+                return;
+            }
+        finishRemesh();
+
+        std::vector<std::pair<chunkData*, std::size_t>> remesh;
+        std::vector<std::pair<chunkData*, std::size_t>> upload;
+        flushEdits(remesh);
+        bool changed = !remesh.empty();
+        changed |= unloadChunks(centre, remesh);
+        changed |= integrateChunks(centre, remesh, upload);
+        changed |= updateLods(cameraPosition, remesh);
+
+        if (changed)
+            {
+                // new chunks show their detached meshes straight away. Sub-chunks being remeshed are uploaded once their mesh is done
+                for (auto &subChunk : upload)
+                    {
+                        if (std::find(remesh.begin(), remesh.end(), subChunk) == remesh.end())
+                            {
+                                updateSubChunkMemory(*subChunk.first, subChunk.second);
+                            }
+                    }
+                submitRemesh(remesh);
+            }
+    }
+
+void voxelSpace::setStreamingRadius(int radius)
+    {
+        m_streamingRadius = radius;
+        m_streamingCentreValid = false;
+    }
+
+int voxelSpace::getStreamingRadius() const
+    {
+        return m_streamingRadius;
+    }
+
+int voxelSpace::loadSeed() const
+    {
+        int seed = static_cast<int>(fe::random::get().generate<uint32_t>());
+        if (m_saveDirectory.empty())
+            {
+                return seed;
+            }
+
+        // unedited chunks are not saved, so the world is only the same between runs if it is generated from the same seed
+        const std::filesystem::path path = std::filesystem::path(m_saveDirectory) / "seed";
+        std::ifstream in(path);
+        if (!(in >> seed))
+            {
+                std::ofstream(path) << seed;
+            }
+        return seed;
+    }
+
+void voxelSpace::setMeshCacheEnabled(bool enabled)
+    {
+        m_meshCacheEnabled = enabled;
+    }
+
+void voxelSpace::setSaveDirectory(const char *directory)
+    {
+        m_saveDirectory = directory;
+        std::error_code error;
+        std::filesystem::create_directories(m_saveDirectory, error);
+    }
+
+void voxelSpace::setIntegrationBudget(unsigned int budget)
+    {
+        m_integrationBudget = budget;
+    }
+
+std::size_t voxelSpace::getLoadedChunkCount() const
+    {
+        return m_loadedChunks.size();
+    }
+
+std::size_t voxelSpace::getRequestedChunkCount() const
+    {
+        return m_requestedChunks.size();
+    }
+
+glm::mat4 voxelSpace::getModelTransformation() const
+    {
+        return m_translation * glm::toMat4(m_quaternion);
+    }
+
+glm::vec<3, int> voxelSpace::raycast(const glm::vec3 origin, const glm::vec3 direction)
+    {
+        OPTICK_EVENT();
+        constexpr float infinity = std::numeric_limits<float>::infinity();
+
+        // everything below is in voxel units
+        const glm::vec3 rayOrigin = glm::vec3(getModelTransformation() * glm::vec4(origin, 0.f)) / c_voxelSize;
+        const glm::vec3 rayDirection = glm::normalize(direction);
+        const float maxDistance = glm::length(static_cast<glm::vec3>(c_chunkSize)) * m_loadedChunks.size();
+
+        glm::ivec3 step{};
+        glm::vec3 deltaDistance{};
+        for (int axis = 0; axis < 3; axis++)
+            {
+                step[axis] = rayDirection[axis] < 0.f ? -1 : 1;
+                deltaDistance[axis] = rayDirection[axis] != 0.f ? std::abs(1.f / rayDirection[axis]) : infinity;
+            }
+
+        glm::ivec3 gridPosition = glm::floor(rayOrigin);
+        glm::vec3 sideDistance{};
+        auto resetSideDistance = [&]() {
+            for (int axis = 0; axis < 3; axis++)
+                {
+                    if (rayDirection[axis] == 0.f)
+                        {
+                            sideDistance[axis] = infinity;
+                        }
+                    else if (step[axis] > 0)
+                        {
+                            sideDistance[axis] = (gridPosition[axis] + 1 - rayOrigin[axis]) * deltaDistance[axis];
+                        }
+                    else
+                        {
+                            sideDistance[axis] = (rayOrigin[axis] - gridPosition[axis]) * deltaDistance[axis];
+                        }
+                }
+        };
+        resetSideDistance();
+
+        // the walk stays in chunk local integer coordinates and only hashes when it crosses into another chunk
+        glm::ivec3 chunkPosition = floorDivide(gridPosition, c_chunkSize);
+        glm::ivec3 localPosition = gridPosition - chunkPosition * c_chunkSize;
+        const chunkData *chunk = findChunk(chunkPosition);
 
-        if (m_localBuffer.m_maxVertexCount < totalVertexCount || m_localBuffer.m_maxIndexCount < totalIndexCount)
+        float distance = 0.f;
+        while (distance <= maxDistance)
             {
-                m_localBuffer.create(totalVertexCount, totalIndexCount);
-            }
+                glm::ivec3 boxMin{};
+                glm::ivec3 boxMax{};
+                bool skip = false;
 
-        int vertexOffset = 0;
-        int indexOffset = 0;
-        for (auto &chunk : m_loadedChunks)
-            {
-                updateChunkMemory(chunk.second, static_cast<fe::int8*>(m_localBuffer.m_cpuStagingBuffer), getVertexMemoryOffset(), vertexOffset, indexOffset);
-            }
-        m_localBuffer.m_needUpdate = true;
-    }
+                if (!chunk)
+                    {
+                        boxMin = chunkPosition * c_chunkSize;
+                        boxMax = boxMin + c_chunkSize;
+                        skip = true;
+                    }
+                else
+                    {
+                        const std::size_t subChunkIndex = getSubChunkIndex(*chunk, localPosition);
+                        if (chunk->m_voxelData[subChunkIndex].m_solidCount == 0)
+                            {
+                                boxMin = chunkPosition * c_chunkSize + getSubChunkPosition(*chunk, subChunkIndex);
+                                boxMax = glm::min(boxMin + glm::ivec3(static_cast<int>(chunk->m_subSize)), chunkPosition * c_chunkSize + c_chunkSize);
+                                skip = true;
+                            }
+                        else if (chunk->m_chunk.at(localPosition.x, localPosition.y, localPosition.z) != voxelType::NONE)
+                            {
+                                return gridPosition;
+                            }
+                    }
 
-void voxelSpace::createChunk(chunkData &chunk, const voxelChunk::sizeType sizeX, const voxelChunk::sizeType sizeY, const voxelChunk::sizeType sizeZ, const voxelChunk::sizeType posX, const voxelChunk::sizeType posY, const voxelChunk::sizeType posZ)
-    {
-        chunk.m_chunk.create(sizeX, sizeY, sizeZ);
-        chunk.m_chunk.setVoxelSize(c_voxelSize);
+                if (skip)
+                    {
+                        // nothing to hit in the box. Leave it through the nearest face and carry on from the voxel on the other side
+                        glm::vec3 exitDistance{};
+                        for (int axis = 0; axis < 3; axis++)
+                            {
+                                if (rayDirection[axis] == 0.f)
+                                    {
+                                        exitDistance[axis] = infinity;
+                                    }
+                                else
+                                    {
+                                        exitDistance[axis] = (step[axis] > 0 ? boxMax[axis] - rayOrigin[axis] : rayOrigin[axis] - boxMin[axis]) * deltaDistance[axis];
+                                    }
+                            }
 
-        voxelChunk::sizeType subChunkCountX = static_cast<voxelChunk::sizeType>(std::ceil(static_cast<float>(sizeX) / c_chunkSubSize));
-        voxelChunk::sizeType subChunkCountY = static_cast<voxelChunk::sizeType>(std::ceil(static_cast<float>(sizeY) / c_chunkSubSize));
-        voxelChunk::sizeType subChunkCountZ = static_cast<voxelChunk::sizeType>(std::ceil(static_cast<float>(sizeZ) / c_chunkSubSize));
+                        int exitAxis = 0;
+                        if (exitDistance[1] < exitDistance[exitAxis]) { exitAxis = 1; }
+                        if (exitDistance[2] < exitDistance[exitAxis]) { exitAxis = 2; }
 
-        chunk.m_voxelData.resize(static_cast<std::size_t>(subChunkCountX * subChunkCountY * subChunkCountZ));
-        chunk.m_subSize = c_chunkSubSize;
+                        distance = exitDistance[exitAxis];
+                        const glm::vec3 exitPoint = rayOrigin + rayDirection * distance;
+                        for (int axis = 0; axis < 3; axis++)
+                            {
+                                gridPosition[axis] = glm::clamp(static_cast<int>(std::floor(exitPoint[axis])), boxMin[axis], boxMax[axis] - 1);
+                            }
+                        gridPosition[exitAxis] = step[exitAxis] > 0 ? boxMax[exitAxis] : boxMin[exitAxis] - 1;
+                        resetSideDistance();
 
-        chunk.m_sizeX = sizeX;
-        chunk.m_sizeY = sizeY;
-        chunk.m_sizeZ = sizeZ;
+                        const glm::ivec3 nextChunkPosition = floorDivide(gridPosition, c_chunkSize);
+                        localPosition = gridPosition - nextChunkPosition * c_chunkSize;
+                        if (nextChunkPosition != chunkPosition)
+                            {
+                                chunkPosition = nextChunkPosition;
+                                chunk = findChunk(chunkPosition);
+                            }
+                        continue;
+                    }
 
-        chunk.m_positionX = posX;
-        chunk.m_positionY = posY;
-        chunk.m_positionZ = posZ;
-    }
+                int axis = 0;
+                if (sideDistance[1] < sideDistance[axis]) { axis = 1; }
+                if (sideDistance[2] < sideDistance[axis]) { axis = 2; }
 
-void voxelSpace::buildChunk(chunkData &chunk, unsigned int &totalIndexOffset)
-    {
-        OPTICK_CATEGORY("VoxelChunkCreation", Optick::Category::Rendering);
-        OPTICK_EVENT();
-        chunk.m_vertexCount = 0;
-        chunk.m_indexCount = 0;
+                distance = sideDistance[axis];
+                sideDistance[axis] += deltaDistance[axis];
+                gridPosition[axis] += step[axis];
+                localPosition[axis] += step[axis];
 
-        buildChunkMesh(chunk);
-        for (auto &subChunk : chunk.m_voxelData)
-            {
-                totalIndexOffset = buildGeometry(glm::vec3{ chunk.m_positionX, chunk.m_positionY, chunk.m_positionZ }, subChunk, totalIndexOffset);
-                chunk.m_vertexCount += subChunk.m_vertexCount;
-                chunk.m_indexCount += subChunk.m_indexCount;
+                if (localPosition[axis] < 0 || localPosition[axis] >= c_chunkSize[axis])
+                    {
+                        localPosition[axis] -= step[axis] * c_chunkSize[axis];
+                        chunkPosition[axis] += step[axis];
+                        chunk = findChunk(chunkPosition);
+                    }
             }
+
+        return {};
     }
 
-void voxelSpace::destroyChunk(chunkData &chunk)
+void voxelSpace::updateBuffers(VkCommandBuffer commandBuffer)
     {
-        for (auto &voxelData : chunk.m_voxelData)
+        OPTICK_EVENT();
+        std::vector<VkBufferCopy> &dirtyRanges = m_localBuffer.m_dirtyRanges;
+        if (dirtyRanges.empty())
             {
-                voxelData.m_quads.clear();
+                return;
             }
-    }
 
-void voxelSpace::buildSlice(chunkData &chunk, unsigned int y, const FastNoise &noise)
-    {
-        for (int x = 0; x < chunk.m_chunk.getSizeX(); x++)
+        // coalesce overlapping and touching ranges so neighbouring sub-chunks go out as one region
+        std::sort(dirtyRanges.begin(), dirtyRanges.end(), [](const VkBufferCopy &lhs, const VkBufferCopy &rhs) { return lhs.srcOffset < rhs.srcOffset; });
+        std::size_t merged = 0;
+        for (std::size_t i = 1; i < dirtyRanges.size(); i++)
             {
-                for (int z = 0; z < chunk.m_chunk.getSizeZ(); z++)
+                VkBufferCopy &last = dirtyRanges[merged];
+                if (dirtyRanges[i].srcOffset <= last.srcOffset + last.size)
                     {
-                        voxelType type = voxelType::NONE;
-                        float surface = (1.f + noise.GetNoise(x + chunk.m_positionX, y + chunk.m_positionY, z + chunk.m_positionZ)) / 2.f;
-
-                        if (surface < 0.5f)
-                            {
-                                type = voxelType::DEFAULT;
-                            }
-                        chunk.m_chunk.at(x, y, z) = type;
+                        last.size = std::max(last.srcOffset + last.size, dirtyRanges[i].srcOffset + dirtyRanges[i].size) - last.srcOffset;
+                    }
+                else
+                    {
+                        dirtyRanges[++merged] = dirtyRanges[i];
                     }
             }
+        dirtyRanges.resize(merged + 1);
+
+        OPTICK_TAG("Copy regions", dirtyRanges.size());
+        vkCmdCopyBuffer(commandBuffer, *m_localBuffer.m_masterStagingBuffer, *m_localBuffer.m_masterBuffer, static_cast<uint32_t>(dirtyRanges.size()), dirtyRanges.data());
+        dirtyRanges.clear();
+
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+            0,
+            1, &barrier,
+            0, nullptr,
+            0, nullptr
+        );
     }
 
-void voxelSpace::transformSpace(glm::vec3 globalPosition, glm::ivec3 &chunkPos, glm::vec3 &localPos) const
-    {
-        transformChunkSpace(globalPosition, chunkPos);
-        transformLocalSpace(globalPosition, localPos);
-    }
-
-void voxelSpace::transformChunkSpace(glm::vec3 globalPosition, glm::ivec3 &chunkPos) const
-    {
-        chunkPos = glm::floor(globalPosition / static_cast<glm::vec3>(c_chunkSize));
-    }
-
-void voxelSpace::transformLocalSpace(glm::vec3 globalPosition, glm::vec3 &localPos) const
+bool voxelSpace::bindDescriptors(descriptorSet &descriptors)
     {
-        localPos = glm::mod(globalPosition, static_cast<glm::vec3>(c_chunkSize));
-    }
+        if (!m_localBuffer.m_exists)
+            {
+                return false;
+            }
 
-voxelSpace::~voxelSpace()
-    {
-        destroy();
+        if (m_boundGeneration != m_localBuffer.m_generation)
+            {
+                descriptors.bindSBO(*m_localBuffer.m_masterBuffer, getFaceBufferSize(), 1, getFaceMemoryOffset());
+                descriptors.bindSBO(*m_localBuffer.m_masterBuffer, getOriginBufferSize(), 2, getOriginMemoryOffset());
+                m_boundGeneration = m_localBuffer.m_generation;
+            }
+        return true;
     }
 
-void voxelSpace::create()
+bool voxelSpace::needsUpdate() const
     {
+        return !m_localBuffer.m_dirtyRanges.empty();
     }
 
-void voxelSpace::destroy()
+void voxelSpace::rebuildBounds()
     {
+        OPTICK_EVENT();
+        m_subChunkBounds.clear();
+        m_boundedSubChunks.clear();
         for (auto &chunk : m_loadedChunks)
             {
-                destroyChunk(chunk.second);
+                const glm::vec3 chunkOrigin(chunk.second.m_positionX, chunk.second.m_positionY, chunk.second.m_positionZ);
+                const float voxelSize = chunk.second.m_chunk.getVoxelSize();
+                for (std::size_t i = 0; i < chunk.second.m_voxelData.size(); i++)
+                    {
+                        const chunkVoxelData &voxelData = chunk.second.m_voxelData[i];
+                        if (!voxelData.m_allocation.valid())
+                            {
+                                continue;
+                            }
+
+                        const glm::vec3 min = chunkOrigin + glm::vec3(getSubChunkPosition(chunk.second, i)) * voxelSize;
+                        m_subChunkBounds.push(min, min + glm::vec3(getSubChunkSize(chunk.second, i)) * voxelSize);
+                        m_boundedSubChunks.push_back(&voxelData);
+                    }
             }
-        m_localBuffer.destroy();
+        m_boundsDirty = false;
     }
 
-void voxelSpace::createWorld(taskGraph *graph)
+void voxelSpace::rasteriseOccluders(const std::vector<uint32_t> &visible)
     {
-        FastNoise noiseSurface(fe::random::get().generate<uint32_t>());
-        noiseSurface.SetNoiseType(FastNoise::NoiseType::ValueFractal);
-        noiseSurface.SetFrequency(0.05f);
-        noiseSurface.SetFractalOctaves(5);
-        noiseSurface.SetFractalLacunarity(2.0);
-        noiseSurface.SetFractalGain(0.4);
+        OPTICK_EVENT();
+        m_occlusionBuffer.clear(m_viewProjection * getModelTransformation());
+        m_occluderCount = 0;
 
-        for (int x = 0; x < 1; x++)
+        // near occluders hide the most, so they get the budget first
+        std::vector<std::pair<float, uint32_t>> candidates;
+        candidates.reserve(visible.size());
+        for (uint32_t index : visible)
             {
-                for (int z = 0; z < 1; z++)
+                if (m_boundedSubChunks[index]->m_solidCells == 0)
                     {
-                        createChunk(m_loadedChunks[glm::ivec3{ x, 0, z }], c_chunkSize.x, c_chunkSize.y, c_chunkSize.z, c_chunkSize.x * x, 0, c_chunkSize.z * z);
+                        continue;
                     }
+
+                const glm::vec3 centre = glm::vec3(
+                    m_subChunkBounds.m_minX[index] + m_subChunkBounds.m_maxX[index],
+                    m_subChunkBounds.m_minY[index] + m_subChunkBounds.m_maxY[index],
+                    m_subChunkBounds.m_minZ[index] + m_subChunkBounds.m_maxZ[index]
+                ) * 0.5f;
+                candidates.emplace_back(glm::length2(centre - m_cameraPosition), index);
             }
-        
-        for (auto &chunk : m_loadedChunks)
+        std::sort(candidates.begin(), candidates.end());
+
+        const float cellSize = c_solidCellSize * c_voxelSize;
+        for (auto &candidate : candidates)
             {
-                for (int i = 0; i < chunk.second.m_chunk.getSizeY(); i++)
+                if (m_occluderCount >= c_maxOccluders)
                     {
-                        graph->addTask(task(this, &voxelSpace::buildSlice), nullptr, chunk.second, i, noiseSurface);
+                        break;
                     }
-            }
 
-        graph->execute();
-        graph->clear(); 
+                const uint32_t index = candidate.second;
+                const chunkVoxelData &voxelData = *m_boundedSubChunks[index];
+                const glm::vec3 subChunkMin = { m_subChunkBounds.m_minX[index], m_subChunkBounds.m_minY[index], m_subChunkBounds.m_minZ[index] };
+                if (voxelData.m_allSolid)
+                    {
+                        const glm::vec3 subChunkMax = { m_subChunkBounds.m_maxX[index], m_subChunkBounds.m_maxY[index], m_subChunkBounds.m_maxZ[index] };
+                        m_occlusionBuffer.rasteriseOccluder(subChunkMin, subChunkMax);
+                        m_occluderCount++;
+                        continue;
+                    }
 
-        unsigned int offset = 0;
-        for (auto &chunk : m_loadedChunks)
-            {
-                chunk.second.m_indexOffset = offset;
-                buildChunk(chunk.second, offset);
+                // runs of solid cells along x are merged into one box
+                for (int z = 0; z < c_solidCellsPerSide; z++)
+                    {
+                        for (int y = 0; y < c_solidCellsPerSide; y++)
+                            {
+                                int x = 0;
+                                while (x < c_solidCellsPerSide)
+                                    {
+                                        const int rowStart = c_solidCellsPerSide * (y + c_solidCellsPerSide * z);
+                                        if (!(voxelData.m_solidCells & (1ull << (rowStart + x))))
+                                            {
+                                                x++;
+                                                continue;
+                                            }
+
+                                        int end = x + 1;
+                                        while (end < c_solidCellsPerSide && (voxelData.m_solidCells & (1ull << (rowStart + end))))
+                                            {
+                                                end++;
+                                            }
+
+                                        const glm::vec3 min = subChunkMin + glm::vec3(x, y, z) * cellSize;
+                                        const glm::vec3 max = subChunkMin + glm::vec3(end, y + 1, z + 1) * cellSize;
+                                        m_occlusionBuffer.rasteriseOccluder(min, max);
+                                        m_occluderCount++;
+                                        x = end;
+                                    }
+                            }
+                    }
             }
-        updateMemory();
 
-        m_translation = glm::translate(glm::mat4(1.f), glm::vec3{0.f, 0.f, 0.f});
-        m_quaternion = glm::angleAxis(0.f, glm::normalize(glm::vec3{ 0, 1.f, 0.f }));
+        m_occlusionBuffer.buildPyramid();
     }
 
-glm::mat4 voxelSpace::getModelTransformation() const
+void voxelSpace::setCamera(const glm::mat4 &viewProjection, const glm::vec3 &position)
     {
-        return m_translation * glm::toMat4(m_quaternion);
+        m_viewProjection = viewProjection;
+        m_cameraPosition = glm::vec3(glm::inverse(getModelTransformation()) * glm::vec4(position, 1.f));
     }
 
-glm::vec<3, int> voxelSpace::raycast(const glm::vec3 origin, const glm::vec3 direction)
+void voxelSpace::cull()
     {
         OPTICK_EVENT();
-        constexpr float gridOffset = 0.000001f;
-
-        glm::vec3 worldPosition = getModelTransformation() * glm::vec4(origin, 0.f);
-        glm::ivec3 chunkPosition{};
-        glm::vec3 localPosition{};
-
-        glm::ivec3 gridPosition = glm::round(worldPosition / c_voxelSize);
-        glm::vec3 deltaDistance = glm::abs(1.f / direction);
-        glm::vec3 sideDistance;
-        glm::ivec3 step;
-
-        if (direction.x < 0.f)
+        m_visibleCount = 0;
+        m_occludedCount = 0;
+        m_outsideFrustumCount = 0;
+        if (!m_localBuffer.m_exists)
             {
-                step.x = -1;
-                sideDistance.x = (worldPosition.x - gridPosition.x) * deltaDistance.x;
+                return;
             }
-        else
+
+        if (m_boundsDirty)
             {
-                step.x = 1;
-                sideDistance.x = (gridPosition.x + gridOffset - worldPosition.x) * deltaDistance.x;
+                rebuildBounds();
             }
 
-        if (direction.y < 0.f)
+        std::vector<uint32_t> visible;
+        visible.reserve(m_boundedSubChunks.size());
+        frustum(m_viewProjection * getModelTransformation()).cull(m_subChunkBounds, visible);
+        m_outsideFrustumCount = static_cast<uint32_t>(m_boundedSubChunks.size() - visible.size());
+
+        if (m_occlusionBuffer.getSize().x == 0)
             {
-                step.y = -1;
-                sideDistance.y = (worldPosition.y - gridPosition.y) * deltaDistance.y;
+                m_occlusionBuffer.create(c_occlusionWidth, c_occlusionHeight);
             }
-        else
+        rasteriseOccluders(visible);
+
+        // slots are cycled per frame so a command is never overwritten while a frame in flight reads it
+        m_visibleOffset = m_localBuffer.getIndirectSlotOffset();
+        VkDrawIndexedIndirectCommand *commands = reinterpret_cast<VkDrawIndexedIndirectCommand*>(static_cast<fe::uInt8*>(m_localBuffer.m_cpuStagingBuffer) + m_visibleOffset);
+        for (uint32_t index : visible)
             {
-                step.y = 1;
-                sideDistance.y = (gridPosition.y + gridOffset - worldPosition.y) * deltaDistance.y;
+                const glm::vec3 min = { m_subChunkBounds.m_minX[index], m_subChunkBounds.m_minY[index], m_subChunkBounds.m_minZ[index] };
+                const glm::vec3 max = { m_subChunkBounds.m_maxX[index], m_subChunkBounds.m_maxY[index], m_subChunkBounds.m_maxZ[index] };
+                if (!m_occlusionBuffer.visible(min, max))
+                    {
+                        m_occludedCount++;
+                        continue;
+                    }
+
+                const chunkVoxelData &voxelData = *m_boundedSubChunks[index];
+                VkDrawIndexedIndirectCommand &command = commands[m_visibleCount++];
+                command.indexCount = static_cast<uint32_t>(voxelData.m_faceCount * 6);
+                command.instanceCount = 1;
+                command.firstIndex = 0;
+                command.vertexOffset = static_cast<int32_t>(voxelData.m_allocation.m_offset * 4);
+                command.firstInstance = voxelData.m_drawIndex;
             }
 
-        if (direction.z < 0.f)
+        OPTICK_TAG("Visible sub-chunks", m_visibleCount);
+        OPTICK_TAG("Occluded sub-chunks", m_occludedCount);
+        if (m_visibleCount > 0)
             {
-                step.z = -1;
-                sideDistance.z = (worldPosition.z - gridPosition.z) * deltaDistance.z;
+                m_localBuffer.markDirty(m_visibleOffset, m_visibleCount * sizeof(VkDrawIndexedIndirectCommand));
             }
-        else
+    }
+
+void voxelSpace::draw(VkCommandBuffer commandBuffer) const
+    {
+        OPTICK_EVENT();
+        if (!m_localBuffer.m_exists || m_visibleCount == 0)
             {
-                step.z = 1;
-                sideDistance.z = (gridPosition.z + gridOffset - worldPosition.z) * deltaDistance.z;
+                return;
             }
 
-        int stepCount = 0;
-        const int maxStepCount = glm::length(static_cast<glm::vec3>(c_chunkSize)) * m_loadedChunks.size();
-        while (stepCount++ <= maxStepCount)
-            {
-                if (sideDistance.x < sideDistance.z)
-                    {
-                        if (sideDistance.y < sideDistance.x)
-                            {
-                                sideDistance.y += deltaDistance.y;
-                                gridPosition.y += step.y;
-                            }
-                        else
-                            {
-                                sideDistance.x += deltaDistance.x;
-                                gridPosition.x += step.x;
-                            }
-                    }
-                else
-                    {
-                        if (sideDistance.y < sideDistance.z)
-                            {
-                                sideDistance.y += deltaDistance.y;
-                                gridPosition.y += step.y;
-                            }
-                        else
-                            {
-                                sideDistance.z += deltaDistance.z;
-                                gridPosition.z += step.z;
-                            }
-                    }
+        vkCmdBindIndexBuffer(commandBuffer, *m_localBuffer.m_masterBuffer, 0, VK_INDEX_TYPE_UINT32);
+        vkCmdDrawIndexedIndirect(commandBuffer, *m_localBuffer.m_masterBuffer, m_visibleOffset, m_visibleCount, sizeof(VkDrawIndexedIndirectCommand));
+    }
 
-                transformSpace(gridPosition, chunkPosition, localPosition);
-                if (m_loadedChunks.find(chunkPosition) != m_loadedChunks.end())
-                    {
-                        voxelType type = m_loadedChunks.at(chunkPosition).m_chunk.at(localPosition.x, localPosition.y, localPosition.z);
-                        if (type != voxelType::NONE)
-                            {
-                                return gridPosition;
-                            }
-                    }
-            }
+vulkanBuffer &voxelSpace::getBufferMemory()
+    {
+        return *m_localBuffer.m_masterBuffer;
+    }
 
-        return {};
+VkDeviceSize voxelSpace::getIndexBufferSize() const
+    {
+        return c_maxFacesPerSubChunk * 6 * sizeof(fe::index);
     }
 
-void voxelSpace::updateBuffers(vulkanCommandBuffer &commandBuffer)
+VkDeviceSize voxelSpace::getFaceMemoryOffset() const
     {
-        VkBufferCopy copyRegion{};
-        copyRegion.size = m_localBuffer.m_bufferSize;
-        vkCmdCopyBuffer(commandBuffer, m_localBuffer.m_masterStagingBuffer, m_localBuffer.m_masterBuffer, 1, &copyRegion);
-        m_localBuffer.m_needUpdate = false;
+        return m_localBuffer.m_faceOffset;
     }
 
-bool voxelSpace::needsUpdate() const
+VkDeviceSize voxelSpace::getFaceBufferSize() const
     {
-        return m_localBuffer.m_needUpdate;
+        return m_localBuffer.m_faceAllocator.getCapacity() * sizeof(packedFace);
     }
 
-vulkanBuffer &voxelSpace::getBufferMemory()
+VkDeviceSize voxelSpace::getOriginMemoryOffset() const
     {
-        return m_localBuffer.m_masterBuffer;
+        return m_localBuffer.m_originOffset;
     }
 
-VkDeviceSize voxelSpace::getVertexMemoryOffset() const
+VkDeviceSize voxelSpace::getOriginBufferSize() const
     {
-        return m_localBuffer.m_maxIndexCount * sizeof(fe::index);
+        return m_localBuffer.m_maxSubChunkCount * sizeof(glm::vec4);
     }
 
-VkDeviceSize voxelSpace::getIndexBufferSize() const
+uint32_t voxelSpace::getVisibleSubChunkCount() const
     {
-        return getIndexCount() * sizeof(fe::index);
+        return m_visibleCount;
     }
 
-VkDeviceSize voxelSpace::getVertexBufferSize() const
+uint32_t voxelSpace::getOccludedSubChunkCount() const
     {
-        return getVertexCount() * sizeof(vertex);
+        return m_occludedCount;
     }
 
-unsigned int voxelSpace::getVertexCount() const
+uint32_t voxelSpace::getOutsideFrustumSubChunkCount() const
     {
-        unsigned int vertexCount = 0;
-        for (auto &chunk : m_loadedChunks)
-            {
-                vertexCount += chunk.second.m_vertexCount;
-            }
+        return m_outsideFrustumCount;
+    }
+
+uint32_t voxelSpace::getOccluderCount() const
+    {
+        return m_occluderCount;
+    }
+
+taskProfiler *voxelSpace::getStreamingProfiler()
+    {
+        return m_streamingGraph ? &m_streamingGraph->getProfiler() : nullptr;
+    }
 
-        return vertexCount;
+std::size_t voxelSpace::getDrawableSubChunkCount() const
+    {
+        return m_boundedSubChunks.size();
     }
 
-unsigned int voxelSpace::getIndexCount() const
+unsigned int voxelSpace::getFaceCount() const
     {
-        unsigned int indexCount = 0;
+        unsigned int faceCount = 0;
         for (auto &chunk : m_loadedChunks)
             {
-                indexCount += chunk.second.m_indexCount;
+                for (auto &voxelData : chunk.second.m_voxelData)
+                    {
+                        faceCount += static_cast<unsigned int>(voxelData.m_faceCount);
+                    }
             }
 
-        return indexCount;
+        return faceCount;
     }
 
-const voxelType &voxelSpace::at(glm::vec3 position) const
+voxelType voxelSpace::at(glm::vec3 position) const
     {
         OPTICK_EVENT();
         glm::ivec3 chunkPosition{};
         glm::vec3 localPosition{};
         transformSpace(position, chunkPosition, localPosition);
-        assert(m_loadedChunks.find(chunkPosition) != m_loadedChunks.end());
+        assert(m_loadedChunks.contains(chunkPosition));
         return m_loadedChunks.at(chunkPosition).m_chunk.at(localPosition.x, localPosition.y, localPosition.z);
     }
 
@@ -383,55 +1781,100 @@ void voxelSpace::setAt(glm::vec3 position, voxelType type)
         glm::ivec3 chunkPosition{};
         glm::vec3 localPosition{};
         transformSpace(position, chunkPosition, localPosition);
-        assert(m_loadedChunks.find(chunkPosition) != m_loadedChunks.end());
-        chunkData &chunk = m_loadedChunks.at(chunkPosition);
-        chunk.m_chunk.at(localPosition.x, localPosition.y, localPosition.z) = type;
-
-        voxelChunk::sizeType subChunkCountX = static_cast<voxelChunk::sizeType>(std::ceil(static_cast<float>(chunk.m_sizeX) / c_chunkSubSize));
-        voxelChunk::sizeType subChunkCountY = static_cast<voxelChunk::sizeType>(std::ceil(static_cast<float>(chunk.m_sizeY) / c_chunkSubSize));
-        voxelChunk::sizeType subChunkCountZ = static_cast<voxelChunk::sizeType>(std::ceil(static_cast<float>(chunk.m_sizeZ) / c_chunkSubSize));
+        assert(m_loadedChunks.contains(chunkPosition));
+        // the mesh tasks read the voxels. The remesh is normally finished by the time the next frame's edits come in
+        m_remeshHandle.wait();
 
-        unsigned int subChunkX = localPosition.x / c_chunkSubSize;
-        unsigned int subChunkY = localPosition.y / c_chunkSubSize;
-        unsigned int subChunkZ = localPosition.z / c_chunkSubSize;
-        int index = subChunkX + subChunkCountX * (subChunkY + subChunkCountY * subChunkZ);
-        chunkVoxelData &subChunk = chunk.m_voxelData[index];
-
-        chunk.m_vertexCount -= subChunk.m_vertexCount;
-        chunk.m_indexCount -= subChunk.m_indexCount;
+        chunkData &chunk = m_loadedChunks.at(chunkPosition);
+        voxelChunk::reference voxel = chunk.m_chunk.at(localPosition.x, localPosition.y, localPosition.z);
 
-        voxelChunk::sizeType x = subChunkX * chunk.m_subSize;
-        voxelChunk::sizeType y = subChunkY * chunk.m_subSize;
-        voxelChunk::sizeType z = subChunkZ * chunk.m_subSize;
+        // kept exact between flushes so raycasts never skip a sub-chunk that was just filled
+        const std::size_t subChunkIndex = getSubChunkIndex(chunk, localPosition);
+        chunkVoxelData &voxelData = chunk.m_voxelData[subChunkIndex];
+        const voxelType previous = voxel;
+        const bool emptinessChanged = (previous == voxelType::NONE) != (type == voxelType::NONE);
+        voxel = type;
 
-        unsigned int offset = chunk.m_indexOffset;
-        for (int i = 0; i < index; i++)
+        if (emptinessChanged)
             {
-                offset += chunk.m_voxelData[i].m_vertexCount;
+                const glm::ivec3 subChunkSize = getSubChunkSize(chunk, subChunkIndex);
+                voxelData.m_solidCount += type == voxelType::NONE ? -1 : 1;
+                voxelData.m_allSolid = voxelData.m_solidCount == subChunkSize.x * subChunkSize.y * subChunkSize.z;
+                const glm::ivec3 positionInSubChunk = glm::ivec3(localPosition) - getSubChunkPosition(chunk, subChunkIndex);
+                if (getBoundaryFaces(positionInSubChunk, subChunkSize) != 0)
+                    {
+                        voxelData.m_openFaces = getOpenFaces(chunk, subChunkIndex);
+                    }
+
+                const int cell = getSolidCellIndex(positionInSubChunk, c_solidCellSize, c_solidCellsPerSide);
+                voxelData.m_solidCells &= ~(1ull << cell);
+                if (type != voxelType::NONE && solidCellFull(chunk, subChunkIndex, cell))
+                    {
+                        voxelData.m_solidCells |= 1ull << cell;
+                    }
             }
 
-        buildChunkMesh(chunk, subChunk, x, y, z);
-        buildGeometry({ chunk.m_positionX, chunk.m_positionY, chunk.m_positionZ }, subChunk, offset);
+        chunk.m_modified = true;
 
-        chunk.m_vertexCount += subChunk.m_vertexCount;
-        chunk.m_indexCount += subChunk.m_indexCount;
-        updateSubChunkMemory(subChunk);
+        markDirtyAround(glm::floor(position));
     }
 
-void buildChunkMesh(const voxelSpace::chunkData &chunkData, voxelSpace::chunkVoxelData &voxelData, voxelChunk::sizeType &x, voxelChunk::sizeType &y, voxelChunk::sizeType &z)
+void buildChunkMesh(const voxelSpace::chunkData &chunkData, voxelSpace::chunkVoxelData &voxelData, voxelChunk::sizeType &x, voxelChunk::sizeType &y, voxelChunk::sizeType &z, const voxelChunk::neighbourList &neighbours)
     {
         OPTICK_EVENT("buildChunkMesh - sub-chunk");
-        voxelData.m_quads.clear();
-        for (voxelChunk::sizeType yIncrement = 0; yIncrement < chunkData.m_subSize; yIncrement++)
+        voxelData.m_faces.clear();
+
+        // a solid sub-chunk only has faces where a neighbouring boundary is open. Neighbours within the chunk answer from their
+        // summary, the layer past the chunk edge is sampled directly since it belongs to another chunk
+        const int subSize = static_cast<int>(chunkData.m_subSize);
+        const glm::ivec3 origin = { x, y, z };
+        const glm::ivec3 chunkSize = { chunkData.m_sizeX, chunkData.m_sizeY, chunkData.m_sizeZ };
+        const glm::ivec3 size = glm::min(glm::ivec3(subSize), chunkSize - origin);
+        const glm::ivec3 subChunkCount = (chunkSize + subSize - 1) / subSize;
+        const glm::ivec3 subChunk = origin / subSize;
+
+        bool enclosed = voxelData.m_allSolid;
+        for (int face = 0; face < 6 && enclosed; face++)
+            {
+                const int axis = face / 2;
+                const int direction = face % 2 == 0 ? 1 : -1;
+
+                glm::ivec3 adjacent = subChunk;
+                adjacent[axis] += direction;
+                if (adjacent[axis] >= 0 && adjacent[axis] < subChunkCount[axis])
+                    {
+                        const std::size_t adjacentIndex = adjacent.x + subChunkCount.x * (adjacent.y + subChunkCount.y * adjacent.z);
+                        enclosed = !(chunkData.m_voxelData[adjacentIndex].m_openFaces & (1 << (face ^ 1)));
+                        continue;
+                    }
+
+                const int u = (axis + 1) % 3;
+                const int v = (axis + 2) % 3;
+                glm::ivec3 position{};
+                position[axis] = direction > 0 ? origin[axis] + size[axis] : origin[axis] - 1;
+                for (position[u] = origin[u]; position[u] < origin[u] + size[u] && enclosed; position[u]++)
+                    {
+                        for (position[v] = origin[v]; position[v] < origin[v] + size[v] && enclosed; position[v]++)
+                            {
+                                enclosed = !chunkData.m_chunk.emptyAt(position.x, position.y, position.z, neighbours);
+                            }
+                    }
+            }
+
+        if (voxelData.m_solidCount > 0 && !enclosed)
             {
-                for (voxelChunk::sizeType xIncrement = 0; xIncrement < chunkData.m_subSize; xIncrement++)
+                for (voxelChunk::sizeType yIncrement = 0; yIncrement < chunkData.m_subSize; yIncrement++)
                     {
-                        for (voxelChunk::sizeType zIncrement = 0; zIncrement < chunkData.m_subSize; zIncrement++)
+                        for (voxelChunk::sizeType xIncrement = 0; xIncrement < chunkData.m_subSize; xIncrement++)
                             {
-                                chunkData.m_chunk.meshAtPosition(voxelData.m_quads, x + xIncrement, y + yIncrement, z + zIncrement);
+                                for (voxelChunk::sizeType zIncrement = 0; zIncrement < chunkData.m_subSize; zIncrement++)
+                                    {
+                                        chunkData.m_chunk.meshAtPosition(voxelData.m_faces, x + xIncrement, y + yIncrement, z + zIncrement, x, y, z, neighbours);
+                                    }
                             }
                     }
             }
+        voxelData.m_faceCount = voxelData.m_faces.size();
 
         x += chunkData.m_subSize;
         if (x >= chunkData.m_sizeX)
@@ -446,223 +1889,175 @@ void buildChunkMesh(const voxelSpace::chunkData &chunkData, voxelSpace::chunkVox
             }   
     }
 
-void buildChunkMesh(voxelSpace::chunkData &chunkData)
+void voxelSpace::localBuffer::create(uint64_t faceCapacity, unsigned int subChunkCapacity)
     {
-        OPTICK_EVENT();
-        voxelChunk::sizeType x = 0;
-        voxelChunk::sizeType y = 0;
-        voxelChunk::sizeType z = 0;
-        OPTICK_TAG("VoxelDataSize", chunkData.m_voxelData.size());
-        OPTICK_TAG("VoxelSubSize", chunkData.m_subSize);
-        for (auto &voxelData : chunkData.m_voxelData)
+        destroy();
+
+        m_faceAllocator.create(faceCapacity, c_minimumFaceAllocation);
+        m_maxSubChunkCount = subChunkCapacity;
+        m_freeDrawIndices.clear();
+        for (unsigned int i = subChunkCapacity; i > 0; i--)
+            {
+                m_freeDrawIndices.push_back(i - 1);
+            }
+
+        createBuffers();
+
+        // every face uses the same 0, 1, 2, 0, 2, 3 pattern so the indices never change once written
+        fe::index *indices = static_cast<fe::index*>(m_cpuStagingBuffer);
+        for (fe::index i = 0; i < c_maxFacesPerSubChunk; i++)
             {
-                buildChunkMesh(chunkData, voxelData, x, y, z);
+                indices[i * 6 + 0] = i * 4 + 0;
+                indices[i * 6 + 1] = i * 4 + 1;
+                indices[i * 6 + 2] = i * 4 + 2;
+                indices[i * 6 + 3] = i * 4 + 0;
+                indices[i * 6 + 4] = i * 4 + 2;
+                indices[i * 6 + 5] = i * 4 + 3;
             }
+
+        markDirty(0, m_faceOffset);
+        m_exists = true;
     }
 
-unsigned int buildGeometry(glm::vec3 offset, voxelSpace::chunkVoxelData &voxelData, unsigned int indexOffset)
+void voxelSpace::localBuffer::resize(unsigned int subChunkCapacity)
     {
         OPTICK_EVENT();
-        vertex vertexArr[4] = {};
-        vertex &v0 = vertexArr[0];
-        vertex &v1 = vertexArr[1];
-        vertex &v2 = vertexArr[2];
-        vertex &v3 = vertexArr[3];
-
-        fe::index indexArrPositive[6] = {
-            0, 1, 2, 0, 2, 3
-        };
-        fe::index indexArrNegative[6] = {
-            2, 1, 0, 3, 2, 0
-        };
+        std::unique_ptr<vulkanBuffer> oldMasterBuffer = std::move(m_masterBuffer);
+        std::unique_ptr<vulkanBuffer> oldStagingBuffer = std::move(m_masterStagingBuffer);
+        const fe::uInt8 *oldStaging = static_cast<const fe::uInt8*>(m_cpuStagingBuffer);
+        const VkDeviceSize oldOriginOffset = m_originOffset;
+        const unsigned int oldSubChunkCount = m_maxSubChunkCount;
 
-        indexArrPositive[0] += indexOffset;
-        indexArrPositive[1] += indexOffset;
-        indexArrPositive[2] += indexOffset;
-        indexArrPositive[3] += indexOffset;
-        indexArrPositive[4] += indexOffset;
-        indexArrPositive[5] += indexOffset;
-
-        indexArrNegative[0] += indexOffset;
-        indexArrNegative[1] += indexOffset;
-        indexArrNegative[2] += indexOffset;
-        indexArrNegative[3] += indexOffset;
-        indexArrNegative[4] += indexOffset;
-        indexArrNegative[5] += indexOffset;
-
-        glm::vec3 colours[] = {
-            { 0.23f, 0.48f, 0.34f },
-            { 0.53f, 0.81f, 0.92f },
-            { 0.37f, 0.50f, 0.22f }
-        };
+        for (unsigned int i = subChunkCapacity; i > oldSubChunkCount; i--)
+            {
+                m_freeDrawIndices.push_back(i - 1);
+            }
+        m_maxSubChunkCount = subChunkCapacity;
+        createBuffers();
+
+        // the staging buffer holds everything the device buffer does, so the new device buffer is filled from it in one copy
+        fe::uInt8 *staging = static_cast<fe::uInt8*>(m_cpuStagingBuffer);
+        std::memcpy(staging, oldStaging, oldOriginOffset);
+        std::memcpy(staging + m_originOffset, oldStaging + oldOriginOffset, oldSubChunkCount * sizeof(glm::vec4));
+        m_dirtyRanges.clear();
+        markDirty(0, m_bufferSize);
+
+        vmaUnmapMemory(*globals::g_vulkanAllocator, oldStagingBuffer->getUnderlyingAllocation());
+        m_retiredBuffers.emplace_back(m_frame, std::move(oldMasterBuffer));
+        m_retiredBuffers.emplace_back(m_frame, std::move(oldStagingBuffer));
+    }
+
+void voxelSpace::localBuffer::createBuffers()
+    {
+        const VkDeviceSize indexSize = c_maxFacesPerSubChunk * 6 * sizeof(fe::index);
+        m_faceOffset = alignTo(indexSize, c_storageAlignment);
+        m_originOffset = alignTo(m_faceOffset + m_faceAllocator.getCapacity() * sizeof(packedFace), c_storageAlignment);
+        m_indirectOffset = alignTo(m_originOffset + m_maxSubChunkCount * sizeof(glm::vec4), c_storageAlignment);
+        m_bufferSize = m_indirectOffset + c_framesInFlight * m_maxSubChunkCount * sizeof(VkDrawIndexedIndirectCommand);
 
-        {
-            OPTICK_EVENT("Resize Vertices/Indices");
-            std::size_t expectedNewVertexSize = voxelData.m_quads.size() * 4;
-            std::size_t expectedNewIndexSize = voxelData.m_quads.size() * 6;
+        m_masterStagingBuffer = std::make_unique<vulkanBuffer>(m_bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, VMA_MEMORY_USAGE_CPU_COPY);
+        m_masterBuffer = std::make_unique<vulkanBuffer>(m_bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VMA_MEMORY_USAGE_GPU_ONLY);
 
-            if (voxelData.m_vertices.size() < expectedNewVertexSize)
-                {
-                    voxelData.m_vertices.resize(expectedNewVertexSize);
-                }
+        vmaMapMemory(*globals::g_vulkanAllocator, m_masterStagingBuffer->getUnderlyingAllocation(), &m_cpuStagingBuffer);
+        m_generation++;
+    }
 
-            if (voxelData.m_indices.size() < expectedNewIndexSize)
-                {
-                    voxelData.m_indices.resize(expectedNewIndexSize);
-                }
+void voxelSpace::localBuffer::destroy()
+    {
+        if (!m_exists) { return; }
 
-            voxelData.m_indexCount = expectedNewIndexSize;
-            voxelData.m_vertexCount = expectedNewVertexSize;
-        }
-
-        unsigned int vertexIndex = 0;
-        // index of the current polygon index. Confusing, I know...
-        unsigned int indexIndex = 0;
-
-        OPTICK_TAG("VoxelDataQuads", voxelData.m_quads.size());
-        for (auto &quad : voxelData.m_quads)
-            {
-                v0.m_colour = quad.m_colour * colours[std::abs(quad.m_orientation) - 1];
-                v1.m_colour = quad.m_colour * colours[std::abs(quad.m_orientation) - 1];
-                v2.m_colour = quad.m_colour * colours[std::abs(quad.m_orientation) - 1];
-                v3.m_colour = quad.m_colour * colours[std::abs(quad.m_orientation) - 1];
-
-                switch (std::abs(quad.m_orientation))
-                    {
-                        case 1:
-                            v0.m_position.x = quad.m_position.x;
-                            v0.m_position.y = quad.m_position.y;
-                            v0.m_position.z = quad.m_position.z;
-
-                            v1.m_position.x = quad.m_position.x + quad.m_size.x;
-                            v1.m_position.y = quad.m_position.y;
-                            v1.m_position.z = quad.m_position.z;
-
-                            v2.m_position.x = quad.m_position.x + quad.m_size.x;
-                            v2.m_position.y = quad.m_position.y + quad.m_size.y;
-                            v2.m_position.z = quad.m_position.z;
-
-                            v3.m_position.x = quad.m_position.x;
-                            v3.m_position.y = quad.m_position.y + quad.m_size.y;
-                            v3.m_position.z = quad.m_position.z;
-                            break;
-                        case 2:
-                            v0.m_position.x = quad.m_position.x;
-                            v0.m_position.y = quad.m_position.z;
-                            v0.m_position.z = quad.m_position.y;
-
-                            v1.m_position.x = quad.m_position.x + quad.m_size.x;
-                            v1.m_position.y = quad.m_position.z;
-                            v1.m_position.z = quad.m_position.y;
-
-                            v2.m_position.x = quad.m_position.x + quad.m_size.x;
-                            v2.m_position.y = quad.m_position.z;
-                            v2.m_position.z = quad.m_position.y + quad.m_size.y;
-
-                            v3.m_position.x = quad.m_position.x;
-                            v3.m_position.y = quad.m_position.z;
-                            v3.m_position.z = quad.m_position.y + quad.m_size.y;
-                            break;
-                        case 3:
-                            v0.m_position.x = quad.m_position.z;
-                            v0.m_position.y = quad.m_position.x;
-                            v0.m_position.z = quad.m_position.y;
-
-                            v1.m_position.x = quad.m_position.z;
-                            v1.m_position.y = quad.m_position.x + quad.m_size.x;
-                            v1.m_position.z = quad.m_position.y;
-
-                            v2.m_position.x = quad.m_position.z;
-                            v2.m_position.y = quad.m_position.x + quad.m_size.x;
-                            v2.m_position.z = quad.m_position.y + quad.m_size.y;
-
-                            v3.m_position.x = quad.m_position.z;
-                            v3.m_position.y = quad.m_position.x;
-                            v3.m_position.z = quad.m_position.y + quad.m_size.y;
-                            break;
-                        default:
-                            break;
-                    }
-
-                v0.m_position += offset;
-                v1.m_position += offset;
-                v2.m_position += offset;
-                v3.m_position += offset;
-                
-                {
-                    voxelData.m_vertices[vertexIndex + 0] = vertexArr[0];
-                    voxelData.m_vertices[vertexIndex + 1] = vertexArr[1];
-                    voxelData.m_vertices[vertexIndex + 2] = vertexArr[2];
-                    voxelData.m_vertices[vertexIndex + 3] = vertexArr[3];
-                    if (quad.m_orientation < 0)
-                        {
-                            voxelData.m_indices[indexIndex + 0] = indexArrNegative[0];
-                            voxelData.m_indices[indexIndex + 1] = indexArrNegative[1];
-                            voxelData.m_indices[indexIndex + 2] = indexArrNegative[2];
-                            voxelData.m_indices[indexIndex + 3] = indexArrNegative[3];
-                            voxelData.m_indices[indexIndex + 4] = indexArrNegative[4];
-                            voxelData.m_indices[indexIndex + 5] = indexArrNegative[5];
-                        }
-                    else 
-                        {
-                            voxelData.m_indices[indexIndex + 0] = indexArrPositive[0];
-                            voxelData.m_indices[indexIndex + 1] = indexArrPositive[1];
-                            voxelData.m_indices[indexIndex + 2] = indexArrPositive[2];
-                            voxelData.m_indices[indexIndex + 3] = indexArrPositive[3];
-                            voxelData.m_indices[indexIndex + 4] = indexArrPositive[4];
-                            voxelData.m_indices[indexIndex + 5] = indexArrPositive[5];
-                        }
-                    vertexIndex += 4;
-                    indexIndex += 6;
-                }
-                
-                indexArrPositive[0] += 4;
-                indexArrPositive[1] += 4;
-                indexArrPositive[2] += 4;
-                indexArrPositive[3] += 4;
-                indexArrPositive[4] += 4;
-                indexArrPositive[5] += 4;
+        vmaUnmapMemory(*globals::g_vulkanAllocator, m_masterStagingBuffer->getUnderlyingAllocation());
+        m_cpuStagingBuffer = nullptr;
 
-                indexArrNegative[0] += 4;
-                indexArrNegative[1] += 4;
-                indexArrNegative[2] += 4;
-                indexArrNegative[3] += 4;
-                indexArrNegative[4] += 4;
-                indexArrNegative[5] += 4;
-            }
+        m_masterStagingBuffer.reset();
+        m_masterBuffer.reset();
+        m_retiredBuffers.clear();
+        m_deferredReleases.clear();
+        m_dirtyRanges.clear();
+        m_freeDrawIndices.clear();
 
-        return indexOffset + voxelData.m_vertexCount;
+        m_bufferSize = 0;
+        m_faceOffset = 0;
+        m_originOffset = 0;
+        m_indirectOffset = 0;
+        m_maxSubChunkCount = 0;
+        m_exists = false;
     }
 
-void voxelSpace::localBuffer::create(unsigned int vertexCount, unsigned int indexCount)
+buddyAllocator::allocation voxelSpace::localBuffer::allocateFaces(std::size_t faceCount)
     {
-        destroy();
+        if (!m_exists)
+            {
+                create(c_initialFaceCapacity, c_initialSubChunkCapacity);
+            }
 
-        m_bufferSize = vertexCount * sizeof(vertex) + indexCount * sizeof(fe::index);
-        m_masterStagingBuffer.create(m_bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, VMA_MEMORY_USAGE_CPU_COPY);
+        buddyAllocator::allocation allocation = m_faceAllocator.allocate(faceCount);
+        if (!allocation.valid())
+            {
+                while (!allocation.valid())
+                    {
+                        m_faceAllocator.grow();
+                        allocation = m_faceAllocator.allocate(faceCount);
+                    }
+                resize(m_maxSubChunkCount);
+            }
 
-        VmaMemoryUsage bufferUsage = VMA_MEMORY_USAGE_GPU_ONLY;
-        m_masterBuffer.create(m_bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, bufferUsage);
+        return allocation;
+    }
 
-        m_maxIndexCount = indexCount;
-        m_maxVertexCount = vertexCount;
+unsigned int voxelSpace::localBuffer::allocateDrawIndex()
+    {
+        if (m_freeDrawIndices.empty())
+            {
+                resize(m_maxSubChunkCount * 2);
+            }
 
-        vmaMapMemory(*globals::g_vulkanAllocator, m_masterStagingBuffer.getUnderlyingAllocation(), &m_cpuStagingBuffer);
-        m_needUpdate = true;
-        m_exists = true;
+        unsigned int drawIndex = m_freeDrawIndices.back();
+        m_freeDrawIndices.pop_back();
+        return drawIndex;
     }
 
-void voxelSpace::localBuffer::destroy()
+void voxelSpace::localBuffer::release(const buddyAllocator::allocation &allocation, unsigned int drawIndex)
     {
-        if (!m_exists) { return; }
+        deferredRelease release;
+        release.m_frame = m_frame;
+        release.m_allocation = allocation;
+        release.m_drawIndex = drawIndex;
+        m_deferredReleases.push_back(release);
+    }
 
-        m_bufferSize = 0;
-        m_maxIndexCount = 0;
-        m_maxVertexCount = 0;
+void voxelSpace::localBuffer::markDirty(VkDeviceSize offset, VkDeviceSize size)
+    {
+        if (size == 0)
+            {
+                return;
+            }
 
-        vmaUnmapMemory(*globals::g_vulkanAllocator, m_masterStagingBuffer.getUnderlyingAllocation());
+        VkBufferCopy copy{};
+        copy.srcOffset = offset;
+        copy.dstOffset = offset;
+        copy.size = size;
+        m_dirtyRanges.push_back(copy);
+    }
 
-        m_masterStagingBuffer.cleanup();
-        m_masterBuffer.cleanup();
-        m_exists = false;
+VkDeviceSize voxelSpace::localBuffer::getIndirectSlotOffset() const
+    {
+        return m_indirectOffset + (m_frame % c_framesInFlight) * m_maxSubChunkCount * sizeof(VkDrawIndexedIndirectCommand);
+    }
+
+void voxelSpace::localBuffer::nextFrame()
+    {
+        m_frame++;
+
+        auto expired = [this](uint64_t frame) { return m_frame - frame >= c_framesInFlight; };
+        for (auto &release : m_deferredReleases)
+            {
+                if (expired(release.m_frame))
+                    {
+                        m_faceAllocator.free(release.m_allocation);
+                        m_freeDrawIndices.push_back(release.m_drawIndex);
+                    }
+            }
+        m_deferredReleases.erase(std::remove_if(m_deferredReleases.begin(), m_deferredReleases.end(), [&expired](const deferredRelease &release) { return expired(release.m_frame); }), m_deferredReleases.end());
+        m_retiredBuffers.erase(std::remove_if(m_retiredBuffers.begin(), m_retiredBuffers.end(), [&expired](const auto &buffer) { return expired(buffer.first); }), m_retiredBuffers.end());
     }
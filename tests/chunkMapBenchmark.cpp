@@ -0,0 +1,188 @@
+// chunkMap against the std::unordered_map it replaced in voxelSpace, on the access patterns streaming uses: filling a view sized cube,
+// lookups, gathering the six neighbours of every chunk, iterating everything and streaming a slab out and back in. Not run by ctest,
+// the numbers only mean something on a quiet machine in a release build
+#define GLM_ENABLE_EXPERIMENTAL
+#include "voxel/chunkMap.hpp"
+#include <glm/gtx/hash.hpp>
+#include <unordered_map>
+#include <chrono>
+#include <cstdio>
+
+namespace
+    {
+        // the payload is about the size of voxelSpace::chunkData so iteration touches a realistic amount of memory
+        struct payload
+            {
+                uint64_t m_value = 0;
+                unsigned char m_padding[248] = {};
+            };
+
+        constexpr int c_radius = 16;
+        constexpr int c_height = 8;
+        constexpr int c_repeats = 5;
+
+        template<typename TFunction>
+        double measure(TFunction &&function)
+            {
+                double best = 1e30;
+                for (int i = 0; i < c_repeats; i++)
+                    {
+                        const auto start = std::chrono::steady_clock::now();
+                        function();
+                        best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+                    }
+                return best;
+            }
+
+        template<typename TFunction>
+        void forEachPosition(TFunction &&function)
+            {
+                for (int z = -c_radius; z < c_radius; z++)
+                    {
+                        for (int y = -c_height; y < c_height; y++)
+                            {
+                                for (int x = -c_radius; x < c_radius; x++)
+                                    {
+                                        function(glm::ivec3(x, y, z));
+                                    }
+                            }
+                    }
+            }
+
+        // a sink the optimiser can not remove
+        volatile uint64_t g_sink = 0;
+
+        void report(const char *name, double map, double reference)
+            {
+                std::printf("%-12s chunkMap %8.3f ms  unordered_map %8.3f ms  %5.2fx\n", name, map, reference, reference / map);
+            }
+    }
+
+int main()
+    {
+        std::printf("%d chunks, best of %d\n", (2 * c_radius) * (2 * c_radius) * (2 * c_height), c_repeats);
+
+        const double fillMap = measure([] {
+            chunkMap<payload> map;
+            forEachPosition([&] (const glm::ivec3 &position) { map[position].m_value = position.x; });
+            g_sink = g_sink + map.size();
+        });
+        const double fillReference = measure([] {
+            std::unordered_map<glm::ivec3, payload> map;
+            forEachPosition([&] (const glm::ivec3 &position) { map[position].m_value = position.x; });
+            g_sink = g_sink + map.size();
+        });
+        report("fill", fillMap, fillReference);
+
+        chunkMap<payload> map;
+        std::unordered_map<glm::ivec3, payload> reference;
+        forEachPosition([&] (const glm::ivec3 &position) {
+            map[position].m_value = position.x;
+            reference[position].m_value = position.x;
+        });
+
+        report("lookup",
+            measure([&] {
+                uint64_t sum = 0;
+                forEachPosition([&] (const glm::ivec3 &position) { sum += map.get(position)->m_value; });
+                g_sink = g_sink + sum;
+            }),
+            measure([&] {
+                uint64_t sum = 0;
+                forEachPosition([&] (const glm::ivec3 &position) { sum += reference.find(position)->second.m_value; });
+                g_sink = g_sink + sum;
+            }));
+
+        report("neighbours",
+            measure([&] {
+                uint64_t found = 0;
+                forEachPosition([&] (const glm::ivec3 &position) {
+                    for (const payload *neighbour : map.getNeighbours(position))
+                        {
+                            found += neighbour != nullptr;
+                        }
+                });
+                g_sink = g_sink + found;
+            }),
+            measure([&] {
+                uint64_t found = 0;
+                forEachPosition([&] (const glm::ivec3 &position) {
+                    for (const glm::ivec3 &direction : chunkMap<payload>::c_neighbourDirections)
+                        {
+                            found += reference.find(position + direction) != reference.end();
+                        }
+                });
+                g_sink = g_sink + found;
+            }));
+
+        report("iterate",
+            measure([&] {
+                uint64_t sum = 0;
+                for (const auto &[position, value] : map)
+                    {
+                        sum += value.m_value;
+                    }
+                g_sink = g_sink + sum;
+            }),
+            measure([&] {
+                uint64_t sum = 0;
+                for (const auto &[position, value] : reference)
+                    {
+                        sum += value.m_value;
+                    }
+                g_sink = g_sink + sum;
+            }));
+
+        // the camera crossing a chunk boundary unloads one face of the cube and loads the opposite one
+        report("stream",
+            measure([&] {
+                for (int step = 0; step < 2 * c_radius; step++)
+                    {
+                        for (int y = -c_height; y < c_height; y++)
+                            {
+                                for (int x = -c_radius; x < c_radius; x++)
+                                    {
+                                        map.erase(glm::ivec3(x, y, -c_radius + step));
+                                        map[glm::ivec3(x, y, c_radius + step)].m_value = x;
+                                    }
+                            }
+                    }
+                for (int step = 2 * c_radius - 1; step >= 0; step--)
+                    {
+                        for (int y = -c_height; y < c_height; y++)
+                            {
+                                for (int x = -c_radius; x < c_radius; x++)
+                                    {
+                                        map.erase(glm::ivec3(x, y, c_radius + step));
+                                        map[glm::ivec3(x, y, -c_radius + step)].m_value = x;
+                                    }
+                            }
+                    }
+            }),
+            measure([&] {
+                for (int step = 0; step < 2 * c_radius; step++)
+                    {
+                        for (int y = -c_height; y < c_height; y++)
+                            {
+                                for (int x = -c_radius; x < c_radius; x++)
+                                    {
+                                        reference.erase(glm::ivec3(x, y, -c_radius + step));
+                                        reference[glm::ivec3(x, y, c_radius + step)].m_value = x;
+                                    }
+                            }
+                    }
+                for (int step = 2 * c_radius - 1; step >= 0; step--)
+                    {
+                        for (int y = -c_height; y < c_height; y++)
+                            {
+                                for (int x = -c_radius; x < c_radius; x++)
+                                    {
+                                        reference.erase(glm::ivec3(x, y, c_radius + step));
+                                        reference[glm::ivec3(x, y, -c_radius + step)].m_value = x;
+                                    }
+                            }
+                    }
+            }));
+
+        return 0;
+    }
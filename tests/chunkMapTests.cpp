@@ -0,0 +1,234 @@
+// chunkMap against a std::map reference through random inserts and erases, backward shift erase inside long probe runs and stepping
+// Morton keys to their neighbours
+#include "voxel/chunkMap.hpp"
+#include "testCheck.hpp"
+#include <random>
+#include <map>
+#include <vector>
+#include <tuple>
+#include <algorithm>
+
+namespace
+    {
+        struct positionLess
+            {
+                bool operator()(const glm::ivec3 &lhs, const glm::ivec3 &rhs) const
+                    {
+                        return std::tie(lhs.x, lhs.y, lhs.z) < std::tie(rhs.x, rhs.y, rhs.z);
+                    }
+            };
+
+        using referenceMap = std::map<glm::ivec3, int, positionLess>;
+
+        bool matches(const chunkMap<int> &map, const referenceMap &reference)
+            {
+                if (map.size() != reference.size())
+                    {
+                        return false;
+                    }
+
+                for (const auto &[position, value] : reference)
+                    {
+                        const int *found = map.get(position);
+                        if (!found || *found != value)
+                            {
+                                return false;
+                            }
+                    }
+
+                std::size_t iterated = 0;
+                for (const auto &[position, value] : map)
+                    {
+                        auto it = reference.find(position);
+                        if (it == reference.end() || it->second != value)
+                            {
+                                return false;
+                            }
+                        iterated++;
+                    }
+                return iterated == reference.size();
+            }
+
+        void testEncoding()
+            {
+                const glm::ivec3 positions[] = { { 0, 0, 0 }, { -1, -1, -1 }, { 5, -7, 123 }, { -(1 << 20), 0, (1 << 20) - 1 }, { (1 << 20) - 1, -(1 << 20), 17 } };
+                for (const glm::ivec3 &position : positions)
+                    {
+                        TEST_CHECK(chunkMap<int>::decode(chunkMap<int>::encode(position)) == position);
+                    }
+                // x takes the lowest bit of each triple
+                TEST_CHECK(chunkMap<int>::encode({ 1, 0, 0 }) - chunkMap<int>::encode({ 0, 0, 0 }) == 1);
+                TEST_CHECK(chunkMap<int>::encode({ 0, 0, 1 }) - chunkMap<int>::encode({ 0, 0, 0 }) == 4);
+            }
+
+        void testNeighbourKeys()
+            {
+                // the carry has to cross the other axes' bits, including where every low bit of one axis flips
+                const glm::ivec3 positions[] = {
+                    { 0, 0, 0 }, { -1, -1, -1 }, { 1, 2, 3 }, { 255, -256, 1023 }, { -1024, 511, -512 }, { (1 << 20) - 2, 3, -(1 << 20) + 1 }
+                };
+
+                for (const glm::ivec3 &position : positions)
+                    {
+                        const uint64_t key = chunkMap<int>::encode(position);
+                        for (std::size_t direction = 0; direction < 6; direction++)
+                            {
+                                const glm::ivec3 neighbour = position + chunkMap<int>::c_neighbourDirections[direction];
+                                TEST_CHECK(chunkMap<int>::getNeighbourKey(key, direction) == chunkMap<int>::encode(neighbour));
+                            }
+                    }
+
+                std::mt19937 random(7);
+                std::uniform_int_distribution<int> coordinate(-(1 << 20) + 1, (1 << 20) - 2);
+                bool allMatch = true;
+                for (int i = 0; i < 10000; i++)
+                    {
+                        const glm::ivec3 position = { coordinate(random), coordinate(random), coordinate(random) };
+                        const uint64_t key = chunkMap<int>::encode(position);
+                        for (std::size_t direction = 0; direction < 6; direction++)
+                            {
+                                const glm::ivec3 neighbour = position + chunkMap<int>::c_neighbourDirections[direction];
+                                allMatch &= chunkMap<int>::getNeighbourKey(key, direction) == chunkMap<int>::encode(neighbour);
+                            }
+                    }
+                TEST_CHECK(allMatch);
+
+                chunkMap<int> map;
+                map[{ 0, 0, 0 }] = 1;
+                map[{ 1, 0, 0 }] = 2;
+                map[{ 0, 0, -1 }] = 3;
+                const chunkMap<int>::neighbourList neighbours = map.getNeighbours({ 0, 0, 0 });
+                TEST_CHECK(neighbours[0] && *neighbours[0] == 2);
+                TEST_CHECK(neighbours[5] && *neighbours[5] == 3);
+                TEST_CHECK(!neighbours[1] && !neighbours[2] && !neighbours[3] && !neighbours[4]);
+            }
+
+        void testRandomOperations()
+            {
+                std::mt19937 random(99);
+                // a small cube so inserts and erases hit the same keys often
+                std::uniform_int_distribution<int> coordinate(-6, 6);
+                std::uniform_int_distribution<int> operation(0, 9);
+
+                chunkMap<int> map;
+                referenceMap reference;
+                bool allMatch = true;
+                for (int i = 0; i < 50000; i++)
+                    {
+                        const glm::ivec3 position = { coordinate(random), coordinate(random), coordinate(random) };
+                        if (operation(random) < 6)
+                            {
+                                const bool inserted = map.emplace(position, i).second;
+                                allMatch &= inserted == reference.emplace(position, i).second;
+                            }
+                        else
+                            {
+                                allMatch &= map.erase(position) == (reference.erase(position) == 1);
+                            }
+
+                        if (i % 1000 == 0)
+                            {
+                                allMatch &= matches(map, reference);
+                            }
+                    }
+                TEST_CHECK(allMatch);
+                TEST_CHECK(matches(map, reference));
+
+                map.clear();
+                TEST_CHECK(map.empty() && map.begin() == map.end());
+            }
+
+        void testBackwardShiftErase()
+            {
+                // a dense block keeps the table at its load limit, so probe runs are long and wrap around the end of the table
+                chunkMap<int> map;
+                referenceMap reference;
+                int value = 0;
+                for (int z = 0; z < 8; z++)
+                    {
+                        for (int y = 0; y < 8; y++)
+                            {
+                                for (int x = 0; x < 8; x++)
+                                    {
+                                        map.emplace(glm::ivec3(x, y, z), value);
+                                        reference.emplace(glm::ivec3(x, y, z), value);
+                                        value++;
+                                    }
+                            }
+                    }
+
+                // erasing from the middle of runs has to shift the entries after the hole back, or they become unreachable
+                std::vector<glm::ivec3> order;
+                for (const auto &[position, unused] : reference)
+                    {
+                        order.push_back(position);
+                    }
+                std::shuffle(order.begin(), order.end(), std::mt19937(3));
+
+                bool allMatch = true;
+                for (std::size_t i = 0; i < order.size(); i++)
+                    {
+                        allMatch &= map.erase(order[i]);
+                        allMatch &= !map.erase(order[i]);
+                        reference.erase(order[i]);
+                        if (i % 16 == 0)
+                            {
+                                allMatch &= matches(map, reference);
+                            }
+                    }
+                TEST_CHECK(allMatch);
+                TEST_CHECK(map.empty());
+
+                // erasing through an iterator skips to the next live payload
+                for (int i = 0; i < 200; i++)
+                    {
+                        map[{ i, -i, i % 5 }] = i;
+                    }
+                std::size_t remaining = map.size();
+                for (auto it = map.begin(); it != map.end();)
+                    {
+                        if (it->second % 2 == 0)
+                            {
+                                it = map.erase(it);
+                                remaining--;
+                            }
+                        else
+                            {
+                                ++it;
+                            }
+                    }
+                TEST_CHECK(map.size() == remaining && remaining == 100);
+                for (int i = 0; i < 200; i++)
+                    {
+                        TEST_CHECK(map.contains({ i, -i, i % 5 }) == (i % 2 == 1));
+                    }
+            }
+
+        void testPointerStability()
+            {
+                chunkMap<int> map;
+                map[{ 3, 3, 3 }] = 42;
+                const int *pointer = map.get({ 3, 3, 3 });
+
+                // growing the index table and adding pages never moves a payload
+                for (int i = 0; i < 5000; i++)
+                    {
+                        map[{ i, 0, -i }] = i;
+                    }
+                for (int i = 0; i < 5000; i += 2)
+                    {
+                        map.erase({ i, 0, -i });
+                    }
+                TEST_CHECK(map.get({ 3, 3, 3 }) == pointer && *pointer == 42);
+            }
+    }
+
+int main()
+    {
+        testEncoding();
+        testNeighbourKeys();
+        testRandomOperations();
+        testBackwardShiftErase();
+        testPointerStability();
+        return testCheck::result("chunkMapTests");
+    }
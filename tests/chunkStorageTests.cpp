@@ -0,0 +1,293 @@
+// Palette storage, the run length codec behind voxelChunk::serialise, reading chunks back out of region files and the mesh cache
+// stored next to them
+#include "voxel/voxelChunk.hpp"
+#include "voxel/voxelRegion.hpp"
+#include "voxel/meshCache.hpp"
+#include "testCheck.hpp"
+#include <random>
+#include <vector>
+#include <set>
+#include <cstring>
+#include <filesystem>
+
+namespace
+    {
+        constexpr voxelChunk::sizeType c_size = 32;
+
+        std::vector<voxelType> getVoxels(const voxelChunk &chunk)
+            {
+                std::vector<voxelType> voxels(chunk.getVolume());
+                chunk.extract(voxels.data());
+                return voxels;
+            }
+
+        // mostly long runs like generated terrain, with noise near the surface so short runs and all palette entries show up
+        voxelChunk createTerrainChunk(unsigned int seed)
+            {
+                std::mt19937 random(seed);
+                std::uniform_int_distribution<int> type(0, 2);
+                std::vector<voxelType> voxels(c_size * c_size * c_size);
+                for (voxelChunk::sizeType z = 0; z < c_size; z++)
+                    {
+                        for (voxelChunk::sizeType y = 0; y < c_size; y++)
+                            {
+                                for (voxelChunk::sizeType x = 0; x < c_size; x++)
+                                    {
+                                        voxelType voxel = y < 12 ? voxelType::DEFAULT : voxelType::NONE;
+                                        if (y >= 12 && y < 16)
+                                            {
+                                                voxel = static_cast<voxelType>(type(random));
+                                            }
+                                        voxels[x + c_size * (y + c_size * z)] = voxel;
+                                    }
+                            }
+                    }
+
+                voxelChunk chunk(c_size, c_size, c_size);
+                chunk.setVoxelSize(0.5f);
+                chunk.assign(voxels.data());
+                return chunk;
+            }
+
+        void testPalette()
+            {
+                voxelChunk chunk(c_size, c_size, c_size);
+                TEST_CHECK(chunk.uniform());
+                TEST_CHECK(chunk.at(3, 4, 5) == voxelType::NONE);
+
+                // the index width grows as types are added and every voxel keeps its type across the repack
+                chunk.at(1, 2, 3) = voxelType::DEFAULT;
+                TEST_CHECK(!chunk.uniform());
+                TEST_CHECK(chunk.getPaletteSize() == 2);
+                chunk.at(4, 5, 6) = voxelType::TEST_1;
+                TEST_CHECK(chunk.getPaletteSize() == 3);
+                TEST_CHECK(chunk.at(1, 2, 3) == voxelType::DEFAULT);
+                TEST_CHECK(chunk.at(4, 5, 6) == voxelType::TEST_1);
+                TEST_CHECK(chunk.at(0, 0, 0) == voxelType::NONE);
+
+                const voxelChunk terrain = createTerrainChunk(1);
+                const std::vector<voxelType> voxels = getVoxels(terrain);
+                voxelChunk copy(c_size, c_size, c_size);
+                copy.assign(voxels.data());
+                TEST_CHECK(getVoxels(copy) == voxels);
+            }
+
+        bool roundTrips(const voxelChunk &chunk)
+            {
+                std::vector<uint8_t> blob;
+                chunk.serialise(blob);
+
+                voxelChunk decoded;
+                if (!decoded.deserialise(blob.data(), blob.size()))
+                    {
+                        return false;
+                    }
+
+                return decoded.getSizeX() == chunk.getSizeX() && decoded.getSizeY() == chunk.getSizeY() && decoded.getSizeZ() == chunk.getSizeZ() &&
+                    decoded.getVoxelSize() == chunk.getVoxelSize() && getVoxels(decoded) == getVoxels(chunk);
+            }
+
+        void testCodec()
+            {
+                TEST_CHECK(roundTrips(voxelChunk(c_size, c_size, c_size)));
+                TEST_CHECK(roundTrips(createTerrainChunk(2)));
+                // runs longer than one LEB128 byte and sizes that are not powers of two
+                TEST_CHECK(roundTrips(voxelChunk(17, 300, 5)));
+
+                // every voxel different from the one before is the worst case for the run length encoding
+                voxelChunk alternating(c_size, c_size, c_size);
+                for (voxelChunk::sizeType i = 0; i < alternating.getVolume(); i++)
+                    {
+                        alternating[i] = static_cast<voxelType>(i % 3);
+                    }
+                TEST_CHECK(roundTrips(alternating));
+
+                // a uniform chunk is a header, one palette entry and one run
+                std::vector<uint8_t> blob;
+                voxelChunk(c_size, c_size, c_size).serialise(blob);
+                TEST_CHECK(blob.size() < 32);
+            }
+
+        void testMalformedBlobs()
+            {
+                std::vector<uint8_t> blob;
+                createTerrainChunk(3).serialise(blob);
+
+                voxelChunk chunk;
+                TEST_CHECK(!chunk.deserialise(blob.data(), 4));
+                TEST_CHECK(!chunk.deserialise(blob.data(), blob.size() / 2));
+                TEST_CHECK(chunk.getVolume() == 0);
+
+                // a run pointing past the palette
+                std::vector<uint8_t> corrupt = blob;
+                corrupt.back() = 0x7f;
+                corrupt[corrupt.size() - 2] = 0xff;
+                TEST_CHECK(!chunk.deserialise(corrupt.data(), corrupt.size()));
+
+                // a header claiming a huge chunk is refused before anything is allocated. The sizes are the first three words
+                std::vector<uint8_t> huge = blob;
+                const uint32_t hugeSize = 1 << 20;
+                std::memcpy(huge.data(), &hugeSize, sizeof(hugeSize));
+                TEST_CHECK(!chunk.deserialise(huge.data(), huge.size()));
+                TEST_CHECK(chunk.getVolume() == 0);
+
+                // a header and palette with no runs after them
+                std::vector<uint8_t> uniform;
+                voxelChunk(c_size, c_size, c_size).serialise(uniform);
+                TEST_CHECK(chunk.deserialise(uniform.data(), uniform.size()));
+                TEST_CHECK(!chunk.deserialise(uniform.data(), uniform.size() - 2));
+            }
+
+        void testRegion()
+            {
+                const std::filesystem::path directory = std::filesystem::temp_directory_path() / "voxelChunkStorageTests";
+                std::filesystem::remove_all(directory);
+                std::filesystem::create_directories(directory);
+                const std::string file = (directory / voxelRegion::getFileName({ -1, 0, 0 })).string();
+
+                TEST_CHECK(voxelRegion::getRegionPosition({ 0, 0, 31 }) == glm::ivec3(0, 0, 0));
+                TEST_CHECK(voxelRegion::getRegionPosition({ -1, 0, 32 }) == glm::ivec3(-1, 0, 1));
+                TEST_CHECK(voxelRegion::getRegionPosition({ -32, 0, -33 }) == glm::ivec3(-1, 0, -2));
+
+                const glm::ivec3 first = { -1, 0, 5 };
+                const glm::ivec3 second = { -32, 0, 31 };
+                const voxelChunk firstChunk = createTerrainChunk(4);
+                const voxelChunk secondChunk = createTerrainChunk(5);
+                    {
+                        voxelRegion region;
+                        TEST_CHECK(region.open(file.c_str()));
+                        TEST_CHECK(!region.contains(first));
+                        TEST_CHECK(region.write(first, firstChunk));
+                        TEST_CHECK(region.write(second, secondChunk));
+                    }
+
+                // read back through a fresh mapping
+                voxelRegion region;
+                TEST_CHECK(region.open(file.c_str()));
+                TEST_CHECK(region.contains(first) && region.contains(second));
+                TEST_CHECK(!region.contains({ -2, 0, 5 }));
+
+                voxelChunk read;
+                TEST_CHECK(region.read(first, read) && getVoxels(read) == getVoxels(firstChunk));
+                TEST_CHECK(region.read(second, read) && getVoxels(read) == getVoxels(secondChunk));
+                TEST_CHECK(!region.read({ -2, 0, 5 }, read));
+
+                // rewriting appends the new blob and relinks the entry, the other chunk is untouched. The file grows geometrically,
+                // so many rewrites only resize it a few times
+                voxelChunk edited = createTerrainChunk(4);
+                edited.at(0, 31, 0) = voxelType::TEST_1;
+                std::set<std::uintmax_t> fileSizes;
+                bool allWritten = true;
+                for (int i = 0; i < 64; i++)
+                    {
+                        allWritten &= region.write(first, edited);
+                        fileSizes.insert(std::filesystem::file_size(file));
+                    }
+                TEST_CHECK(allWritten);
+                TEST_CHECK(fileSizes.size() <= 8);
+                TEST_CHECK(region.read(first, read) && read.at(0, 31, 0) == voxelType::TEST_1 && getVoxels(read) == getVoxels(edited));
+                TEST_CHECK(region.read(second, read) && getVoxels(read) == getVoxels(secondChunk));
+                region.close();
+
+                // the spare capacity at the end of the file is not mistaken for data when it is opened again
+                TEST_CHECK(region.open(file.c_str()));
+                TEST_CHECK(region.read(first, read) && getVoxels(read) == getVoxels(edited));
+                TEST_CHECK(region.write(second, edited));
+                TEST_CHECK(region.read(second, read) && getVoxels(read) == getVoxels(edited));
+                TEST_CHECK(region.read(first, read) && getVoxels(read) == getVoxels(edited));
+
+                region.close();
+                std::filesystem::remove_all(directory);
+            }
+
+        std::vector<packedFace> createMesh(std::size_t faceCount, unsigned int material)
+            {
+                std::vector<packedFace> faces;
+                for (std::size_t i = 0; i < faceCount; i++)
+                    {
+                        faces.push_back(packedFace::create(i % 32, (i / 32) % 32, i / 1024, i % 6, 1, 1, material));
+                    }
+                return faces;
+            }
+
+        bool sameFaces(const std::vector<packedFace> &lhs, const std::vector<packedFace> &rhs)
+            {
+                return lhs.size() == rhs.size() && (lhs.empty() || std::memcmp(lhs.data(), rhs.data(), lhs.size() * sizeof(packedFace)) == 0);
+            }
+
+        void testMeshCache()
+            {
+                const std::filesystem::path directory = std::filesystem::temp_directory_path() / "voxelMeshCacheTests";
+                std::filesystem::remove_all(directory);
+                std::filesystem::create_directories(directory);
+                const std::string file = (directory / meshCache::getFileName({ 0, 0, 0 })).string();
+                constexpr uint32_t mesherVersion = 7;
+                constexpr uint32_t subChunksPerChunk = 4;
+
+                const glm::ivec3 first = { 3, 0, 4 };
+                const glm::ivec3 second = { 30, 0, 1 };
+                std::vector<packedFace> read;
+                    {
+                        meshCache cache;
+                        TEST_CHECK(cache.open(file.c_str(), mesherVersion, subChunksPerChunk));
+                        TEST_CHECK(!cache.read(first, 1, 11, read));
+
+                        // every way of the sub-chunk gets a slot, after which rewrites of the same size refill them in place
+                        bool allWritten = true;
+                        std::uintmax_t settledSize = 0;
+                        for (uint64_t key = 1; key <= 64; key++)
+                            {
+                                allWritten &= cache.write(first, 1, key, createMesh(100, key % 256).data(), 100);
+                                if (key == meshCache::c_ways)
+                                    {
+                                        settledSize = std::filesystem::file_size(file);
+                                    }
+                            }
+                        TEST_CHECK(allWritten);
+                        TEST_CHECK(std::filesystem::file_size(file) == settledSize);
+                        TEST_CHECK(cache.read(first, 1, 64, read) && sameFaces(read, createMesh(100, 64)));
+                        TEST_CHECK(cache.read(first, 1, 61, read) && sameFaces(read, createMesh(100, 61)));
+                        TEST_CHECK(!cache.read(first, 1, 60, read));
+                        TEST_CHECK(!cache.read(first, 0, 64, read));
+
+                        // a mesh outgrowing its slot moves, and the slot it leaves behind is handed to the next mesh that fits
+                        TEST_CHECK(cache.write(first, 1, 65, createMesh(1000, 1).data(), 1000));
+                        const std::uintmax_t grownSize = std::filesystem::file_size(file);
+                        TEST_CHECK(cache.write(second, 2, 66, createMesh(90, 2).data(), 90));
+                        TEST_CHECK(std::filesystem::file_size(file) == grownSize);
+                        TEST_CHECK(cache.read(first, 1, 65, read) && sameFaces(read, createMesh(1000, 1)));
+                        TEST_CHECK(cache.read(second, 2, 66, read) && sameFaces(read, createMesh(90, 2)));
+                    }
+
+                // slots are rebuilt from the index when the file is opened again, so the gaps are still reused
+                meshCache cache;
+                TEST_CHECK(cache.open(file.c_str(), mesherVersion, subChunksPerChunk));
+                TEST_CHECK(cache.read(first, 1, 65, read) && sameFaces(read, createMesh(1000, 1)));
+                TEST_CHECK(cache.read(second, 2, 66, read) && sameFaces(read, createMesh(90, 2)));
+                const std::uintmax_t reopenedSize = std::filesystem::file_size(file);
+                TEST_CHECK(cache.write(first, 1, 67, createMesh(1200, 3).data(), 1200));
+                TEST_CHECK(cache.write(second, 3, 68, createMesh(128, 4).data(), 128));
+                TEST_CHECK(cache.read(first, 1, 67, read) && sameFaces(read, createMesh(1200, 3)));
+                TEST_CHECK(cache.read(second, 3, 68, read) && sameFaces(read, createMesh(128, 4)));
+                TEST_CHECK(cache.read(second, 2, 66, read) && sameFaces(read, createMesh(90, 2)));
+                TEST_CHECK(std::filesystem::file_size(file) == reopenedSize + 2048 * sizeof(packedFace));
+                cache.close();
+
+                // a different mesher version throws every mesh away
+                TEST_CHECK(cache.open(file.c_str(), mesherVersion + 1, subChunksPerChunk));
+                TEST_CHECK(!cache.read(first, 1, 67, read));
+                cache.close();
+
+                std::filesystem::remove_all(directory);
+            }
+    }
+
+int main()
+    {
+        testPalette();
+        testCodec();
+        testMalformedBlobs();
+        testRegion();
+        testMeshCache();
+        return testCheck::result("chunkStorageTests");
+    }
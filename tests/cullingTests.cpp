@@ -0,0 +1,94 @@
+// Frustum culling through the SSE path against the scalar plane test, and the occlusion buffer against a wall
+#include "graphics/frustum.hpp"
+#include "graphics/occlusionBuffer.hpp"
+#include "testCheck.hpp"
+#include <random>
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace
+    {
+        glm::mat4 getViewProjection()
+            {
+                // looking down -z from the origin
+                const glm::mat4 projection = glm::perspective(glm::radians(90.f), 2.f, 0.1f, 1000.f);
+                const glm::mat4 view = glm::lookAt(glm::vec3(0.f), glm::vec3(0.f, 0.f, -1.f), glm::vec3(0.f, 1.f, 0.f));
+                return projection * view;
+            }
+
+        void testKnownBoxes()
+            {
+                const frustum cameraFrustum(getViewProjection());
+                TEST_CHECK(cameraFrustum.intersects({ -1.f, -1.f, -11.f }, { 1.f, 1.f, -9.f }));
+                // behind the camera
+                TEST_CHECK(!cameraFrustum.intersects({ -1.f, -1.f, 9.f }, { 1.f, 1.f, 11.f }));
+                // past the far plane
+                TEST_CHECK(!cameraFrustum.intersects({ -1.f, -1.f, -1200.f }, { 1.f, 1.f, -1100.f }));
+                // straddling the left plane
+                TEST_CHECK(cameraFrustum.intersects({ -30.f, -1.f, -11.f }, { -15.f, 1.f, -9.f }));
+                TEST_CHECK(!cameraFrustum.intersects({ -40.f, -1.f, -11.f }, { -30.f, 1.f, -9.f }));
+            }
+
+        // cull takes four boxes at a time with SSE and the rest through intersects, so it has to agree with intersects on every box
+        void testCullMatchesScalar()
+            {
+                const frustum cameraFrustum(getViewProjection());
+                std::mt19937 random(12345);
+                std::uniform_real_distribution<float> position(-200.f, 200.f);
+                std::uniform_real_distribution<float> extent(0.f, 20.f);
+
+                // not a multiple of four so the scalar tail runs as well
+                constexpr std::size_t boxCount = 4099;
+                boundingBoxes boxes;
+                std::vector<uint32_t> expected;
+                for (std::size_t i = 0; i < boxCount; i++)
+                    {
+                        const glm::vec3 min = { position(random), position(random), position(random) };
+                        const glm::vec3 max = min + glm::vec3(extent(random), extent(random), extent(random));
+                        boxes.push(min, max);
+                        if (cameraFrustum.intersects(min, max))
+                            {
+                                expected.push_back(static_cast<uint32_t>(i));
+                            }
+                    }
+
+                std::vector<uint32_t> visible;
+                cameraFrustum.cull(boxes, visible);
+                TEST_CHECK(visible == expected);
+                // the scene has to exercise both outcomes
+                TEST_CHECK(!expected.empty() && expected.size() < boxCount);
+            }
+
+        void testOcclusion()
+            {
+                occlusionBuffer buffer;
+                buffer.create(256, 128);
+                buffer.clear(getViewProjection());
+                // a 4x4 wall five units in front of the camera
+                buffer.rasteriseOccluder({ -2.f, -2.f, -6.f }, { 2.f, 2.f, -5.f });
+                buffer.buildPyramid();
+
+                // directly behind the wall
+                TEST_CHECK(!buffer.visible({ -1.f, -1.f, -20.f }, { 1.f, 1.f, -18.f }));
+                // partly behind the wall, partly beside it
+                TEST_CHECK(buffer.visible({ 5.f, -1.f, -20.f }, { 12.f, 1.f, -18.f }));
+                // in front of the wall
+                TEST_CHECK(buffer.visible({ -1.f, -1.f, -3.f }, { 1.f, 1.f, -2.f }));
+                // off to the side, nothing in the way
+                TEST_CHECK(buffer.visible({ 15.f, -1.f, -20.f }, { 17.f, 1.f, -18.f }));
+                // crossing the near plane is never culled
+                TEST_CHECK(buffer.visible({ -1.f, -1.f, -20.f }, { 1.f, 1.f, 1.f }));
+
+                // nothing is occluded once the buffer is cleared
+                buffer.clear(getViewProjection());
+                buffer.buildPyramid();
+                TEST_CHECK(buffer.visible({ -1.f, -1.f, -20.f }, { 1.f, 1.f, -18.f }));
+            }
+    }
+
+int main()
+    {
+        testKnownBoxes();
+        testCullMatchesScalar();
+        testOcclusion();
+        return testCheck::result("cullingTests");
+    }
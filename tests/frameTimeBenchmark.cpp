@@ -0,0 +1,117 @@
+// Frame critical work timed against a steady stream of background work, the way the render thread runs its frame graph while the
+// streaming thread generates chunks. Prints the median and p99 of the frame work with no background load, with the load at normal
+// priority, at background priority and at background priority under a frame budget. Not run by ctest
+#include "taskGraph.hpp"
+#include "taskScheduler.hpp"
+#include <chrono>
+#include <cstdio>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+namespace
+    {
+        constexpr int c_frameCount = 400;
+        constexpr int c_frameNodeCount = 8;
+        constexpr std::chrono::microseconds c_frameNodeTime{ 250 };
+        constexpr int c_backgroundNodeCount = 64;
+        constexpr std::chrono::microseconds c_backgroundNodeTime{ 2000 };
+        // the rest of a frame, presenting and waiting on the GPU, without any task work
+        constexpr std::chrono::milliseconds c_frameGap{ 4 };
+
+        struct configuration
+            {
+                const char *m_name;
+                bool m_load;
+                taskPriority m_priority;
+                std::chrono::microseconds m_budget;
+            };
+
+        void spin(std::chrono::microseconds time)
+            {
+                const auto end = std::chrono::steady_clock::now() + time;
+                while (std::chrono::steady_clock::now() < end)
+                    {
+                    }
+            }
+
+        // keeps one batch of background work submitted until told to stop, like the streaming thread
+        void runBackgroundLoad(const std::atomic<bool> &running, taskPriority priority)
+            {
+                taskGraph graph(c_backgroundNodeCount);
+                for (int i = 0; i < c_backgroundNodeCount; i++)
+                    {
+                        graph.addTask(task(spin, c_backgroundNodeTime));
+                    }
+                taskGraph::compiledGraph work = graph.compile();
+
+                while (running)
+                    {
+                        taskGraph::executionHandle handle = graph.submit(work, priority);
+                        while (!handle.done())
+                            {
+                                std::this_thread::sleep_for(std::chrono::microseconds(200));
+                            }
+                    }
+            }
+    }
+
+int main()
+    {
+        const configuration configurations[] = {
+            { "no background load", false, taskPriority::BACKGROUND, std::chrono::microseconds(0) },
+            { "load at normal priority", true, taskPriority::NORMAL, std::chrono::microseconds(0) },
+            { "load at background priority", true, taskPriority::BACKGROUND, std::chrono::microseconds(0) },
+            { "load at background, 2ms budget", true, taskPriority::BACKGROUND, std::chrono::microseconds(2000) },
+        };
+
+        taskScheduler::get().start({});
+        std::printf("%u workers. %d frame nodes of %lld us per frame, %d frames\n", taskScheduler::get().getWorkerCount(), c_frameNodeCount,
+            static_cast<long long>(c_frameNodeTime.count()), c_frameCount);
+
+        for (const configuration &current : configurations)
+            {
+                taskGraph graph(c_frameNodeCount);
+                for (int i = 0; i < c_frameNodeCount; i++)
+                    {
+                        graph.addTask(task(spin, c_frameNodeTime));
+                    }
+                taskGraph::compiledGraph frame = graph.compile();
+
+                taskScheduler::get().setFrameBudget(current.m_budget);
+                std::atomic<bool> running = true;
+                std::thread background;
+                if (current.m_load)
+                    {
+                        background = std::thread(runBackgroundLoad, std::cref(running), current.m_priority);
+                        // let the load fill the workers before the first frame
+                        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                    }
+
+                std::vector<double> times;
+                times.reserve(c_frameCount);
+                for (int i = 0; i < c_frameCount; i++)
+                    {
+                        const auto start = std::chrono::steady_clock::now();
+                        taskScheduler::get().beginFrame();
+                        graph.execute(frame, taskPriority::FRAME_CRITICAL);
+                        times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+                        std::this_thread::sleep_for(c_frameGap);
+                    }
+
+                running = false;
+                // the load may be waiting for budget that only comes back with the next frame
+                taskScheduler::get().setFrameBudget(std::chrono::microseconds(0));
+                if (background.joinable())
+                    {
+                        background.join();
+                    }
+
+                std::sort(times.begin(), times.end());
+                std::printf("%-32s p50 %6.2f ms  p99 %6.2f ms  max %6.2f ms\n", current.m_name, times[times.size() / 2], times[times.size() * 99 / 100], times.back());
+            }
+
+        taskScheduler::get().stop();
+        return 0;
+    }
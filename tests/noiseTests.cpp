@@ -0,0 +1,96 @@
+// batchNoise against the per-sample FastNoise path it replaced in world generation, with the same settings voxelSpace uses
+#include "voxel/batchNoise.hpp"
+#include "FastNoise.h"
+#include "testCheck.hpp"
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+namespace
+    {
+        constexpr float c_tolerance = 1e-5f;
+
+        void configure(batchNoise &noise, FastNoise &reference, int seed)
+            {
+                noise.setSeed(seed);
+                noise.setFrequency(0.05f);
+                noise.setFractalOctaves(5);
+                noise.setFractalLacunarity(2.f);
+                noise.setFractalGain(0.4f);
+
+                reference.SetSeed(seed);
+                reference.SetNoiseType(FastNoise::ValueFractal);
+                reference.SetFractalType(FastNoise::FBM);
+                reference.SetInterp(FastNoise::Quintic);
+                reference.SetFrequency(0.05f);
+                reference.SetFractalOctaves(5);
+                reference.SetFractalLacunarity(2.f);
+                reference.SetFractalGain(0.4f);
+            }
+
+        // the sizes are not multiples of four so the scalar tail of every SSE row runs as well. Negative origins cover the floor rounding
+        void testFillMatchesFastNoise()
+            {
+                const glm::ivec3 origins[] = { { 0, 0, 0 }, { -70, -5, 33 }, { 1000, 64, -2000 } };
+                const glm::ivec3 size = { 37, 19, 23 };
+                const int seeds[] = { 1337, -42, 918273 };
+
+                float maxDifference = 0.f;
+                bool classificationMatches = true;
+                std::vector<float> values(static_cast<std::size_t>(size.x) * size.y * size.z);
+                for (int seed : seeds)
+                    {
+                        batchNoise noise;
+                        FastNoise reference;
+                        configure(noise, reference, seed);
+
+                        for (const glm::ivec3 &origin : origins)
+                            {
+                                noise.fill(values.data(), origin, size);
+                                const float *value = values.data();
+                                for (int z = 0; z < size.z; z++)
+                                    {
+                                        for (int y = 0; y < size.y; y++)
+                                            {
+                                                for (int x = 0; x < size.x; x++)
+                                                    {
+                                                        const glm::ivec3 position = origin + glm::ivec3{ x, y, z };
+                                                        const float expected = reference.GetNoise(static_cast<float>(position.x), static_cast<float>(position.y), static_cast<float>(position.z));
+                                                        maxDifference = std::max(maxDifference, std::abs(*value - expected));
+                                                        // terrain is solid below zero, so this is what decides whether a voxel changes
+                                                        classificationMatches &= (*value < 0.f) == (expected < 0.f) || std::abs(expected) < c_tolerance;
+                                                        value++;
+                                                    }
+                                            }
+                                    }
+                            }
+                    }
+
+                TEST_CHECK(maxDifference <= c_tolerance);
+                TEST_CHECK(classificationMatches);
+            }
+
+        void testSampleMatchesFastNoise()
+            {
+                batchNoise noise;
+                FastNoise reference;
+                configure(noise, reference, 7);
+
+                float maxDifference = 0.f;
+                for (int i = 0; i < 2000; i++)
+                    {
+                        const float x = i * 1.37f - 900.f;
+                        const float y = i * 0.21f;
+                        const float z = 500.f - i * 0.77f;
+                        maxDifference = std::max(maxDifference, std::abs(noise.sample(x, y, z) - reference.GetNoise(x, y, z)));
+                    }
+                TEST_CHECK(maxDifference <= c_tolerance);
+            }
+    }
+
+int main()
+    {
+        testFillMatchesFastNoise();
+        testSampleMatchesFastNoise();
+        return testCheck::result("noiseTests");
+    }
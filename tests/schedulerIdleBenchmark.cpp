@@ -0,0 +1,85 @@
+// What parked workers cost. Measures the CPU time the process uses while the workers have nothing to do, and how long a parked worker
+// takes to start a node submitted after a pause. Not run by ctest
+#include "taskGraph.hpp"
+#include "taskScheduler.hpp"
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+#if defined(_WIN32)
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <Windows.h>
+#else
+    #include <sys/resource.h>
+#endif
+
+namespace
+    {
+        constexpr std::chrono::seconds c_idleTime{ 1 };
+        constexpr std::chrono::milliseconds c_pause{ 20 };
+        constexpr int c_wakeCount = 50;
+
+        // user and kernel time of the whole process
+        double getProcessTime()
+            {
+                #if defined(_WIN32)
+                    FILETIME creation, exit, kernel, user;
+                    GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user);
+                    const auto toMilliseconds = [] (const FILETIME &time) { return ((static_cast<unsigned long long>(time.dwHighDateTime) << 32) | time.dwLowDateTime) / 1e4; };
+                    return toMilliseconds(kernel) + toMilliseconds(user);
+                #else
+                    rusage usage;
+                    getrusage(RUSAGE_SELF, &usage);
+                    return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1e3 + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e3;
+                #endif
+            }
+
+        void markStart(std::chrono::steady_clock::time_point *start)
+            {
+                *start = std::chrono::steady_clock::now();
+            }
+    }
+
+int main()
+    {
+        taskScheduler::get().start({});
+        const unsigned int workerCount = taskScheduler::get().getWorkerCount();
+        taskGraph graph(16);
+        std::chrono::steady_clock::time_point started;
+        graph.addTask(task(markStart, &started));
+        graph.execute();
+        graph.clear();
+
+        const double processTime = getProcessTime();
+        const auto idleStart = std::chrono::steady_clock::now();
+        std::this_thread::sleep_for(c_idleTime);
+        const double idleProcessTime = getProcessTime() - processTime;
+        const double wallTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - idleStart).count();
+        std::printf("%u workers idle: %.1f ms of CPU over %.0f ms (%.2f%% of one core)\n", workerCount, idleProcessTime, wallTime, 100.0 * idleProcessTime / wallTime);
+
+        // polled instead of waited on so this thread does not run the node itself. Yielding leaves the core to the worker on small machines
+        std::vector<double> latencies;
+        for (int i = 0; i < c_wakeCount; i++)
+            {
+                std::this_thread::sleep_for(c_pause);
+                graph.addTask(task(markStart, &started));
+                const auto submitted = std::chrono::steady_clock::now();
+                taskGraph::executionHandle handle = graph.submit();
+                while (!handle.done())
+                    {
+                        std::this_thread::yield();
+                    }
+                latencies.push_back(std::chrono::duration<double, std::micro>(started - submitted).count());
+                graph.clear();
+            }
+
+        std::sort(latencies.begin(), latencies.end());
+        std::printf("wake latency after %lld ms idle: median %.1f us  p90 %.1f us  max %.1f us\n", static_cast<long long>(c_pause.count()),
+            latencies[latencies.size() / 2], latencies[latencies.size() * 9 / 10], latencies.back());
+
+        taskScheduler::get().stop();
+        return 0;
+    }
@@ -0,0 +1,97 @@
+// How graph execution scales from one worker up to one per core. A wide fan-out should speed up with every worker, a chain can not and
+// shows the cost of handing each node on, and many empty nodes show the per-node overhead. Not run by ctest
+#include "taskGraph.hpp"
+#include "taskScheduler.hpp"
+#include <chrono>
+#include <cstdio>
+#include <atomic>
+#include <algorithm>
+
+namespace
+    {
+        constexpr int c_nodeCount = 2000;
+        constexpr int c_emptyNodeCount = 20000;
+        constexpr int c_spinIterations = 20000;
+        constexpr int c_repeats = 5;
+
+        std::atomic<int> g_completed = 0;
+
+        void spin(int iterations)
+            {
+                volatile double value = 1.0;
+                for (int i = 0; i < iterations; i++)
+                    {
+                        value = value * 1.0000001 + 0.1;
+                    }
+                g_completed.fetch_add(1, std::memory_order_relaxed);
+            }
+
+        template<typename TBuild>
+        double measure(taskGraph &graph, TBuild &&build)
+            {
+                double best = 1e30;
+                for (int i = 0; i < c_repeats; i++)
+                    {
+                        build();
+                        const auto start = std::chrono::steady_clock::now();
+                        graph.execute();
+                        best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+                        graph.clear();
+                    }
+                return best;
+            }
+    }
+
+int main()
+    {
+        const unsigned int coreCount = taskScheduler::getCoreCount();
+        std::printf("%u cores. %d nodes of %d iterations, %d empty nodes, best of %d\n", coreCount, c_nodeCount, c_spinIterations, c_emptyNodeCount, c_repeats);
+
+        double singleWorkerFanOut = 0.0;
+        for (unsigned int workerCount = 1;; workerCount = std::min(workerCount * 2, coreCount))
+            {
+                taskScheduler::get().start({ workerCount });
+                taskGraph graph(c_emptyNodeCount);
+
+                const double fanOut = measure(graph, [&] {
+                    taskGraph::nodeHandle root = graph.addTask(task(spin, c_spinIterations));
+                    for (int i = 0; i < c_nodeCount; i++)
+                        {
+                            graph.addTask(task(spin, c_spinIterations), root);
+                        }
+                });
+
+                const double chain = measure(graph, [&] {
+                    taskGraph::nodeHandle previous = nullptr;
+                    for (int i = 0; i < c_nodeCount; i++)
+                        {
+                            previous = graph.addTask(task(spin, c_spinIterations), previous);
+                        }
+                });
+
+                // half the nodes hang off the root and half continue a chain, so both stealing and handing on are exercised
+                const double empty = measure(graph, [&] {
+                    taskGraph::nodeHandle root = graph.addTask(task(spin, 0));
+                    taskGraph::nodeHandle previous = root;
+                    for (int i = 0; i < c_emptyNodeCount; i++)
+                        {
+                            previous = graph.addTask(task(spin, 0), i % 2 ? previous : root);
+                        }
+                });
+
+                if (workerCount == 1)
+                    {
+                        singleWorkerFanOut = fanOut;
+                    }
+                std::printf("%2u workers: fan-out %8.2f ms (%4.2fx)  chain %8.2f ms  empty %8.2f ms (%5.0f ns per node)\n",
+                    workerCount, fanOut, singleWorkerFanOut / fanOut, chain, empty, empty * 1e6 / c_emptyNodeCount);
+
+                if (workerCount >= coreCount)
+                    {
+                        break;
+                    }
+            }
+
+        taskScheduler::get().stop();
+        return 0;
+    }
@@ -0,0 +1,253 @@
+// Random graphs run on different worker counts, checking every node runs exactly once and only after all of its parents. Also covers
+// compiled graphs run repeatedly, several graphs in flight at once, what a waiting thread helps with and restarting the workers
+#include "taskGraph.hpp"
+#include "taskScheduler.hpp"
+#include "testCheck.hpp"
+#include <random>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <chrono>
+
+namespace
+    {
+        // remembers the position each node ran at, so parents can be checked to have run first
+        struct recorder
+            {
+                std::atomic<int> m_counter = 0;
+                std::vector<std::atomic<int>> m_order;
+
+                explicit recorder(std::size_t nodeCount) : m_order(nodeCount) {}
+
+                void run(std::size_t index)
+                    {
+                        m_order[index].store(m_counter.fetch_add(1) + 1);
+                    }
+
+                void reset()
+                    {
+                        m_counter = 0;
+                        for (std::atomic<int> &order : m_order)
+                            {
+                                order = 0;
+                            }
+                    }
+
+                bool ranInOrder(const std::vector<std::vector<std::size_t>> &parents) const
+                    {
+                        if (m_counter != static_cast<int>(parents.size()))
+                            {
+                                return false;
+                            }
+
+                        for (std::size_t i = 0; i < parents.size(); i++)
+                            {
+                                for (std::size_t parent : parents[i])
+                                    {
+                                        if (m_order[parent] == 0 || m_order[parent] >= m_order[i])
+                                            {
+                                                return false;
+                                            }
+                                    }
+                            }
+                        return true;
+                    }
+            };
+
+        // every node gets up to maxParents random parents out of the nodes before it
+        std::vector<std::vector<std::size_t>> buildRandomGraph(taskGraph &graph, recorder &nodeRecorder, std::size_t nodeCount, unsigned int maxParents, std::mt19937 &random)
+            {
+                std::vector<std::vector<std::size_t>> parents(nodeCount);
+                std::vector<taskGraph::nodeHandle> nodes;
+                nodes.reserve(nodeCount);
+                for (std::size_t i = 0; i < nodeCount; i++)
+                    {
+                        nodes.push_back(graph.addTask(task(&nodeRecorder, &recorder::run, i)));
+                        const unsigned int parentCount = i == 0 ? 0 : random() % (maxParents + 1);
+                        for (unsigned int j = 0; j < parentCount; j++)
+                            {
+                                const std::size_t parent = random() % i;
+                                parents[i].push_back(parent);
+                                graph.addParents(nodes[i], { nodes[parent] });
+                            }
+                    }
+                return parents;
+            }
+
+        void testRandomGraphs()
+            {
+                std::mt19937 random(3);
+                bool allRan = true;
+                for (unsigned int round = 0; round < 120; round++)
+                    {
+                        taskScheduler::get().start({ 1 + round % 6 });
+                        taskGraph graph(16);
+                        const std::size_t nodeCount = 1 + random() % 2000;
+                        recorder nodeRecorder(nodeCount);
+                        const std::vector<std::vector<std::size_t>> parents = buildRandomGraph(graph, nodeRecorder, nodeCount, 3, random);
+
+                        graph.execute(static_cast<taskPriority>(round % 3));
+                        allRan &= graph.done() && nodeRecorder.ranInOrder(parents);
+                        graph.clear();
+
+                        // a cleared graph is reused for the next one
+                        nodeRecorder.reset();
+                        const std::vector<std::vector<std::size_t>> reusedParents = buildRandomGraph(graph, nodeRecorder, nodeCount, 1, random);
+                        graph.execute();
+                        allRan &= nodeRecorder.ranInOrder(reusedParents);
+                        graph.clear();
+                    }
+                TEST_CHECK(allRan);
+            }
+
+        void testCompiledGraph()
+            {
+                std::mt19937 random(5);
+                taskScheduler::get().start({ 3 });
+                taskGraph graph(16);
+                recorder nodeRecorder(1500);
+                const std::vector<std::vector<std::size_t>> parents = buildRandomGraph(graph, nodeRecorder, 1500, 2, random);
+
+                taskGraph::compiledGraph compiled = graph.compile();
+                TEST_CHECK(compiled.size() == 1500);
+                TEST_CHECK(graph.done());
+
+                bool allRan = true;
+                for (int run = 0; run < 20; run++)
+                    {
+                        nodeRecorder.reset();
+                        graph.execute(compiled);
+                        allRan &= nodeRecorder.ranInOrder(parents);
+                    }
+                TEST_CHECK(allRan);
+            }
+
+        void testConcurrentSubmissions()
+            {
+                std::mt19937 random(11);
+                taskScheduler::get().start({ 4 });
+                bool allRan = true;
+                for (int round = 0; round < 50; round++)
+                    {
+                        taskGraph frame(16);
+                        taskGraph background(16);
+                        recorder frameRecorder(500);
+                        recorder backgroundRecorder(3000);
+                        const auto frameParents = buildRandomGraph(frame, frameRecorder, 500, 2, random);
+                        const auto backgroundParents = buildRandomGraph(background, backgroundRecorder, 3000, 2, random);
+
+                        // waiting on the frame graph must not need the background graph to finish first
+                        taskGraph::executionHandle backgroundHandle = background.submit(taskPriority::BACKGROUND);
+                        taskGraph::executionHandle frameHandle = frame.submit(taskPriority::FRAME_CRITICAL);
+                        frameHandle.wait();
+                        allRan &= frameHandle.done() && frameRecorder.ranInOrder(frameParents);
+                        backgroundHandle.wait();
+                        allRan &= backgroundHandle.done() && backgroundRecorder.ranInOrder(backgroundParents);
+                    }
+                TEST_CHECK(allRan);
+            }
+
+        // a thread waiting on a frame critical graph helps with it, but never picks up background work that could hold it up
+        void testHelpPriority()
+            {
+                taskScheduler::get().start({ 1 });
+                const std::thread::id waitingThread = std::this_thread::get_id();
+                std::atomic<bool> waiting = false;
+                std::atomic<int> backgroundRunWhileWaiting = 0;
+
+                taskGraph background(16);
+                for (int i = 0; i < 100; i++)
+                    {
+                        background.addTask(task([&] {
+                            if (waiting && std::this_thread::get_id() == waitingThread)
+                                {
+                                    backgroundRunWhileWaiting++;
+                                }
+                            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                        }));
+                    }
+
+                // the waiter takes one frame node and the worker the other once its background node is done, so the waiter runs out
+                // of frame work first while background nodes are still queued
+                taskGraph frame(16);
+                for (int i = 0; i < 2; i++)
+                    {
+                        frame.addTask(task([] { std::this_thread::sleep_for(std::chrono::milliseconds(5)); }));
+                    }
+
+                taskGraph::executionHandle backgroundHandle = background.submit(taskPriority::BACKGROUND);
+                bool allWaited = true;
+                for (int round = 0; round < 10; round++)
+                    {
+                        waiting = true;
+                        frame.execute(taskPriority::FRAME_CRITICAL);
+                        waiting = false;
+                        allWaited &= frame.done();
+                    }
+                TEST_CHECK(allWaited);
+                TEST_CHECK(backgroundRunWhileWaiting == 0);
+
+                backgroundHandle.wait();
+                TEST_CHECK(background.done());
+            }
+
+        void testRestart()
+            {
+                // a submission the caller has seen finish never keeps the workers from being replaced
+                bool allRestarted = true;
+                for (unsigned int round = 0; round < 50; round++)
+                    {
+                        allRestarted &= taskScheduler::get().start({ 1 + round % 4 });
+                        taskGraph graph(16);
+                        for (int i = 0; i < 20; i++)
+                            {
+                                graph.addTask(task([] {}));
+                            }
+                        graph.execute();
+                        allRestarted &= taskScheduler::get().stop();
+                    }
+                TEST_CHECK(allRestarted);
+
+                // the profiler of a graph made before a restart records the threads of the new workers as well
+                taskScheduler::get().start({ 1 });
+                taskGraph graph(16);
+                graph.getProfiler().setEnabled(true);
+                taskScheduler::get().start({ 6 });
+                for (int i = 0; i < 500; i++)
+                    {
+                        graph.addTask(task([] {}));
+                    }
+                graph.execute();
+                graph.getProfiler().collect();
+                TEST_CHECK(graph.getProfiler().getEvents().size() == 500);
+                graph.clear();
+
+                #if defined(NDEBUG)
+                    // refused while a node is still running. Debug builds assert instead
+                    std::atomic<bool> release = false;
+                    graph.addTask(task([&] {
+                        while (!release)
+                            {
+                                std::this_thread::yield();
+                            }
+                    }));
+                    taskGraph::executionHandle handle = graph.submit();
+                    TEST_CHECK(!taskScheduler::get().start({ 2 }));
+                    TEST_CHECK(!taskScheduler::get().stop());
+                    release = true;
+                    handle.wait();
+                    TEST_CHECK(taskScheduler::get().start({ 2 }));
+                #endif
+            }
+    }
+
+int main()
+    {
+        testRandomGraphs();
+        testCompiledGraph();
+        testConcurrentSubmissions();
+        testHelpPriority();
+        testRestart();
+        taskScheduler::get().stop();
+        return testCheck::result("taskGraphTests");
+    }
@@ -0,0 +1,119 @@
+// The profiler's summary of a small graph with a known critical path, and collecting events on one thread while the workers record
+#include "taskGraph.hpp"
+#include "taskScheduler.hpp"
+#include "testCheck.hpp"
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <cstring>
+#include <algorithm>
+
+namespace
+    {
+        void spin(std::chrono::microseconds time)
+            {
+                const auto end = std::chrono::steady_clock::now() + time;
+                while (std::chrono::steady_clock::now() < end)
+                    {
+                    }
+            }
+
+        void testCriticalPath()
+            {
+                taskScheduler::get().start({ 3 });
+                taskGraph graph(64);
+                graph.getProfiler().setEnabled(true);
+
+                // a -> b -> d and a -> c -> d, with b much longer than c
+                taskGraph::nodeHandle a = graph.addTask(task(spin, std::chrono::microseconds(100)), nullptr, "a");
+                taskGraph::nodeHandle b = graph.addTask(task(spin, std::chrono::microseconds(2000)), a, "b");
+                taskGraph::nodeHandle c = graph.addTask(task(spin, std::chrono::microseconds(50)), a, "c");
+                taskGraph::nodeHandle d = graph.addTask(task(spin, std::chrono::microseconds(100)), b, "d");
+                graph.addParents(d, { c });
+
+                taskGraph::compiledGraph compiled = graph.compile();
+                for (int i = 0; i < 3; i++)
+                    {
+                        graph.execute(compiled);
+                    }
+
+                taskProfiler &profiler = graph.getProfiler();
+                profiler.collect();
+                const std::vector<taskProfiler::event> &events = profiler.getEvents();
+                TEST_CHECK(events.size() == 12);
+
+                std::uint32_t latest = 0;
+                for (const taskProfiler::event &event : events)
+                    {
+                        latest = std::max(latest, event.m_submission);
+                    }
+                std::vector<taskProfiler::event> latestEvents;
+                std::copy_if(events.begin(), events.end(), std::back_inserter(latestEvents), [latest] (const taskProfiler::event &event) {
+                    return event.m_submission == latest;
+                });
+
+                const taskProfiler::summary summary = taskProfiler::summarise(latestEvents);
+                TEST_CHECK(summary.m_taskCount == 4);
+                TEST_CHECK(summary.m_criticalPath.size() == 3);
+                if (summary.m_criticalPath.size() == 3)
+                    {
+                        TEST_CHECK(std::strcmp(summary.m_criticalPath[0], "a") == 0);
+                        // normally b, but a preempted worker can hold c up long enough to be the parent that makes d ready
+                        TEST_CHECK(std::strcmp(summary.m_criticalPath[1], "b") == 0 || std::strcmp(summary.m_criticalPath[1], "c") == 0);
+                        TEST_CHECK(std::strcmp(summary.m_criticalPath[2], "d") == 0);
+                    }
+                TEST_CHECK(summary.m_criticalPathTime > 0.0 && summary.m_criticalPathTime <= summary.m_wallTime + 1e-6);
+            }
+
+        // the rings wrap many times while being read, so any event torn by a concurrent write would show up as a mismatched field
+        void testCollectWhileRecording()
+            {
+                taskScheduler::get().start({ 4 });
+                taskGraph graph(1024);
+                taskProfiler &profiler = graph.getProfiler();
+                profiler.setEnabled(true);
+
+                static const char *const label = "tick";
+                for (int i = 0; i < 1000; i++)
+                    {
+                        graph.addTask(task([] {}), nullptr, label);
+                    }
+                taskGraph::compiledGraph compiled = graph.compile();
+
+                std::atomic<bool> running = true;
+                std::thread executor([&] {
+                    while (running)
+                        {
+                            graph.execute(compiled);
+                        }
+                });
+
+                bool allIntact = true;
+                std::size_t collected = 0;
+                const auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(300);
+                while (std::chrono::steady_clock::now() < end)
+                    {
+                        profiler.collect();
+                        for (const taskProfiler::event &event : profiler.getEvents())
+                            {
+                                allIntact &= event.m_label == label && event.m_node != nullptr && event.m_startTime <= event.m_endTime;
+                                allIntact &= event.m_thread <= taskScheduler::get().getWorkerCount();
+                            }
+                        collected += profiler.getEvents().size();
+                        profiler.reset();
+                    }
+
+                running = false;
+                executor.join();
+                TEST_CHECK(allIntact);
+                TEST_CHECK(collected > 0);
+            }
+    }
+
+int main()
+    {
+        testCriticalPath();
+        testCollectWhileRecording();
+        taskScheduler::get().stop();
+        return testCheck::result("taskProfilerTests");
+    }
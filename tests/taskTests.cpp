@@ -0,0 +1,125 @@
+// Where a task keeps its callable. Captures that fit in the inline buffer must not touch the heap, larger ones fall back to a single
+// allocation. Every allocation in this executable goes through the counting operator new below
+#include "task.hpp"
+#include "testCheck.hpp"
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+    {
+        std::atomic<std::size_t> g_allocations = 0;
+        std::atomic<std::size_t> g_deallocations = 0;
+    }
+
+void *operator new(std::size_t size)
+    {
+        g_allocations++;
+        if (void *memory = std::malloc(size == 0 ? 1 : size))
+            {
+                return memory;
+            }
+        throw std::bad_alloc();
+    }
+
+void operator delete(void *memory) noexcept
+    {
+        if (memory)
+            {
+                g_deallocations++;
+            }
+        std::free(memory);
+    }
+
+void operator delete(void *memory, std::size_t) noexcept
+    {
+        ::operator delete(memory);
+    }
+
+namespace
+    {
+        struct accumulator
+            {
+                long long m_total = 0;
+
+                void add(long long value, long long scale)
+                    {
+                        m_total += value * scale;
+                    }
+            };
+
+        long long sum(const std::array<long long, 16> &values)
+            {
+                long long total = 0;
+                for (long long value : values)
+                    {
+                        total += value;
+                    }
+                return total;
+            }
+
+        void testSmallCaptureIsInline()
+            {
+                std::array<long long, 6> values = { 1, 2, 3, 4, 5, 6 };
+                long long result = 0;
+                long long *output = &result;
+                auto callable = [values, output]() { *output = values[0] + values[5]; };
+                static_assert(sizeof(callable) < 64);
+
+                accumulator target;
+                const std::size_t allocationsBefore = g_allocations;
+                    {
+                        task lambdaTask(callable);
+                        task methodTask(&target, &accumulator::add, 7ll, 3ll);
+                        task moved(std::move(lambdaTask));
+                        task assigned;
+                        assigned = std::move(methodTask);
+
+                        moved.execute();
+                        assigned.execute();
+                        assigned.execute();
+                        TEST_CHECK(!lambdaTask.valid() && !methodTask.valid());
+                    }
+                TEST_CHECK(g_allocations == allocationsBefore);
+                TEST_CHECK(result == 7);
+                TEST_CHECK(target.m_total == 42);
+            }
+
+        void testLargeCaptureUsesHeap()
+            {
+                std::array<long long, 16> values = {};
+                for (std::size_t i = 0; i < values.size(); i++)
+                    {
+                        values[i] = static_cast<long long>(i) + 1;
+                    }
+                long long result = 0;
+                long long *output = &result;
+                auto callable = [values, output]() { *output = sum(values); };
+                static_assert(sizeof(callable) > 64);
+
+                const std::size_t allocationsBefore = g_allocations;
+                const std::size_t deallocationsBefore = g_deallocations;
+                    {
+                        task heapTask(callable);
+                        TEST_CHECK(g_allocations == allocationsBefore + 1);
+
+                        // moving hands the pointer over instead of copying the callable
+                        task moved(std::move(heapTask));
+                        task assigned;
+                        assigned = std::move(moved);
+                        TEST_CHECK(g_allocations == allocationsBefore + 1);
+
+                        assigned.execute();
+                        TEST_CHECK(result == 136);
+                    }
+                TEST_CHECK(g_deallocations == deallocationsBefore + 1);
+            }
+    }
+
+int main()
+    {
+        testSmallCaptureIsInline();
+        testLargeCaptureUsesHeap();
+        return testCheck::result("taskTests");
+    }
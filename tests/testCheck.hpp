@@ -0,0 +1,31 @@
+// testCheck.hpp
+// Minimal checks shared by the standalone tests. A failed check prints where it failed and the test exits non-zero from
+// testResult, so every check in a test still runs after the first failure
+#pragma once
+#include <cstdio>
+
+namespace testCheck
+    {
+        inline int &failures()
+            {
+                static int count = 0;
+                return count;
+            }
+
+        inline void check(bool condition, const char *expression, const char *file, int line)
+            {
+                if (!condition)
+                    {
+                        std::printf("%s:%d: check failed: %s\n", file, line, expression);
+                        failures()++;
+                    }
+            }
+
+        inline int result(const char *name)
+            {
+                std::printf("%s: %s\n", name, failures() == 0 ? "passed" : "FAILED");
+                return failures() == 0 ? 0 : 1;
+            }
+    }
+
+#define TEST_CHECK(condition) testCheck::check(static_cast<bool>(condition), #condition, __FILE__, __LINE__)